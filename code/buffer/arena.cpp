@@ -0,0 +1,94 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "arena.h"
+
+#include <new>
+#include <algorithm>
+#include <cstdint>
+
+Arena::Arena(): head_(nullptr), cur_(nullptr), ptr_(nullptr), end_(nullptr),
+                blockCnt_(0), large_(nullptr), largeBytes_(0) {}
+
+Arena::~Arena() {
+    Release();
+}
+
+void Arena::UseBlock_(Block* block) {
+    cur_ = block;
+    ptr_ = reinterpret_cast<char*>(block + 1);
+    end_ = ptr_ + BLOCK_CAPACITY;
+}
+
+//回到第一个块重新分配，块本身不归还
+void Arena::Reset() {
+    FreeLarge_();
+    if(head_) {
+        UseBlock_(head_);
+    }
+}
+
+void Arena::Release() {
+    FreeLarge_();
+    while(head_) {
+        Block* block = head_;
+        head_ = block->next;
+        SlabAllocator::Free(block);
+    }
+    cur_ = nullptr;
+    ptr_ = end_ = nullptr;
+    blockCnt_ = 0;
+}
+
+void* Arena::do_allocate(size_t bytes, size_t alignment) {
+    //块的有效空间只按指针大小对齐，更大的对齐要求也走大对象
+    if(bytes + alignment > BLOCK_CAPACITY / 2 || alignment > alignof(std::max_align_t)) {
+        return AllocateLarge_(bytes, alignment);
+    }
+    while(true) {
+        if(ptr_) {
+            uintptr_t p = reinterpret_cast<uintptr_t>(ptr_);
+            char* aligned = ptr_ + ((alignment - p % alignment) % alignment);
+            if(aligned + bytes <= end_) {
+                ptr_ = aligned + bytes;
+                return aligned;
+            }
+        }
+        //当前块用完：先复用Reset前留下的块，没有再取新块
+        if(cur_ && cur_->next) {
+            UseBlock_(cur_->next);
+            continue;
+        }
+        Block* block = static_cast<Block*>(SlabAllocator::Alloc());
+        block->next = nullptr;
+        blockCnt_++;
+        if(cur_) { cur_->next = block; }
+        else { head_ = block; }
+        UseBlock_(block);
+    }
+}
+
+//头部放在申请到的内存开头，按对齐要求留出空间
+void* Arena::AllocateLarge_(size_t bytes, size_t alignment) {
+    alignment = std::max(alignment, alignof(Large));
+    size_t head = (sizeof(Large) + alignment - 1) / alignment * alignment;
+    char* mem = static_cast<char*>(::operator new(head + bytes, std::align_val_t(alignment)));
+    Large* large = reinterpret_cast<Large*>(mem);
+    large->size = head + bytes;
+    large->alignment = alignment;
+    large->next = large_;
+    large_ = large;
+    largeBytes_ += large->size;
+    return mem + head;
+}
+
+void Arena::FreeLarge_() {
+    while(large_) {
+        Large* large = large_;
+        large_ = large->next;
+        largeBytes_ -= large->size;
+        ::operator delete(large, std::align_val_t(large->alignment));
+    }
+}
@@ -0,0 +1,65 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <memory_resource>
+#include <cstddef>
+
+#include "slab.h"
+
+// 请求级的内存区，给std::pmr容器使用
+// 分配只移动指针，释放是空操作；一个请求处理完后Reset整体回收，耗时与请求大小无关
+// 内存块取自SlabAllocator，Reset后留着给下一个请求用，Release才还回去
+// 超过一个块的大对象直接向系统申请，Reset时释放
+// 使用者必须在Reset前丢掉所有指向本区的容器存储
+class Arena : public std::pmr::memory_resource {
+public:
+    Arena();
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void Reset();
+    void Release();
+
+    // 当前占用的内存大小
+    size_t Capacity() const { return blockCnt_ * SlabAllocator::CHUNK_SIZE + largeBytes_; }
+
+private:
+    struct Block {
+        Block* next;
+    };
+    struct Large {
+        Large* next;
+        size_t size;
+        size_t alignment;
+    };
+    static const size_t BLOCK_CAPACITY = SlabAllocator::CHUNK_SIZE - sizeof(Block);
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    void* AllocateLarge_(size_t bytes, size_t alignment);
+    void UseBlock_(Block* block);
+    void FreeLarge_();
+
+    Block* head_;   // 所有块串成一条链，Reset后从头复用
+    Block* cur_;
+    char* ptr_;
+    char* end_;
+    size_t blockCnt_;
+
+    Large* large_;
+    size_t largeBytes_;
+};
+
+#endif //ARENA_H
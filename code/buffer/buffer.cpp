@@ -4,8 +4,41 @@
  * @copyleft Apache 2.0
  */ 
 #include "buffer.h"
+#include <algorithm>
 
-Buffer::Buffer(int initBuffSize) : buffer_(initBuffSize), readPos_(0), writePos_(0) {}
+Buffer::Buffer(int initBuffSize) : buffer_(nullptr), capacity_(0), initSize_(initBuffSize), readPos_(0), writePos_(0) {}
+
+Buffer::~Buffer() {
+    Deallocate_(buffer_, capacity_);
+}
+
+//不超过一个块的请求统一取一个slab块，实际大小写回size
+char* Buffer::Allocate_(size_t& size) {
+    if(size <= SlabAllocator::CHUNK_SIZE) {
+        size = SlabAllocator::CHUNK_SIZE;
+        return static_cast<char*>(SlabAllocator::Alloc());
+    }
+    return static_cast<char*>(::operator new(size));
+}
+
+void Buffer::Deallocate_(char* data, size_t size) {
+    if(!data) { return; }
+    if(size == SlabAllocator::CHUNK_SIZE) {
+        SlabAllocator::Free(data);
+    } else {
+        ::operator delete(data);
+    }
+}
+
+bool Buffer::Release() {
+    if(ReadableBytes() > 0) { return false; }
+    Deallocate_(buffer_, capacity_);
+    buffer_ = nullptr;
+    capacity_ = 0;
+    readPos_ = 0;
+    writePos_ = 0;
+    return true;
+}
 
 //返回可读字节数
 size_t Buffer::ReadableBytes() const {
@@ -14,7 +47,7 @@ size_t Buffer::ReadableBytes() const {
 
 //返回可写字节数
 size_t Buffer::WritableBytes() const {
-    return buffer_.size() - writePos_;
+    return capacity_ - writePos_;
 }
 
 //返回头部预留字节数
@@ -28,9 +61,14 @@ const char* Buffer::Peek() const {
 }
 
 //如果Buffer里可读字节数大于要读的字节，那么直接将readPos_指针向后移动len个位置
+//读空后读写位置归零，下次追加从头开始，省掉一次腾挪
 void Buffer::Retrieve(size_t len) {
     assert(len <= ReadableBytes());
     readPos_ += len;
+    if(readPos_ == writePos_) {
+        readPos_ = 0;
+        writePos_ = 0;
+    }
 }
 
 //从可读处读至Buffer的end指针处
@@ -39,9 +77,8 @@ void Buffer::RetrieveUntil(const char* end) {
     Retrieve(end - Peek());
 }
 
-//清空Buffer
+//清空Buffer；只重置读写位置，旧内容会被后续写入覆盖，不需要清零
 void Buffer::RetrieveAll() {
-    bzero(&buffer_[0], buffer_.size());
     readPos_ = 0;
     writePos_ = 0;
 }
@@ -67,7 +104,7 @@ void Buffer::HasWritten(size_t len) {
     writePos_ += len;
 } 
 
-void Buffer::Append(const std::string& str) {
+void Buffer::Append(std::string_view str) {
     Append(str.data(), str.length());
 }
 
@@ -128,7 +165,7 @@ ssize_t Buffer::ReadFd(int fd, int* saveErrno) {
     }
     //读取数据超过Buffer长度时将超出部分放入buff中
     else {
-        writePos_ = buffer_.size();
+        writePos_ = capacity_;
         Append(buff, len - writable);
     }
     return len;
@@ -145,32 +182,39 @@ ssize_t Buffer::WriteFd(int fd, int* saveErrno) {
         *saveErrno = errno;
         return len;
     } 
-    readPos_ += len;
+    Retrieve(len);
     return len;
 }
 
 //返回Buffer中第一个元素的地址
 char* Buffer::BeginPtr_() {
-    return &*buffer_.begin();
+    return buffer_;
 }
 
 const char* Buffer::BeginPtr_() const {
-    return &*buffer_.begin();
+    return buffer_;
 }
 
 //当空间不够用时，对Buffer进行扩充数据和数据复制
 //如果头部剩下的空间和可写空间即 writableBytes() + prependableBytes()  小于 新加的数据长度 必须重新分配空间，如果大于的话，那么发生内部腾挪就行。
 void Buffer::MakeSpace_(size_t len) {
+    size_t readable = ReadableBytes();
     if(WritableBytes() + PrependableBytes() < len) {
-        //当buffer_.resize(writerIndex_+len)的时候，会把以前的Buffer自动复制到新的Buffer处。
-        buffer_.resize(writePos_ + len + 1);
+        //按倍数扩容，连续追加时重新分配和拷贝的次数为对数级；搬到新存储时顺便把可读数据移到开头
+        size_t size = std::max({readable + len, capacity_ * 2, initSize_});
+        char* data = Allocate_(size);
+        if(readable) {
+            memcpy(data, BeginPtr_() + readPos_, readable);
+        }
+        Deallocate_(buffer_, capacity_);
+        buffer_ = data;
+        capacity_ = size;
     } 
     else {
         // move readable data to the front, make space inside buffer
-        size_t readable = ReadableBytes();
-        std::copy(BeginPtr_() + readPos_, BeginPtr_() + writePos_, BeginPtr_());
-        readPos_ = 0;
-        writePos_ = readPos_ + readable;
-        assert(readable == ReadableBytes());
+        memmove(BeginPtr_(), BeginPtr_() + readPos_, readable);
     }
-}
\ No newline at end of file
+    readPos_ = 0;
+    writePos_ = readable;
+    assert(readable == ReadableBytes());
+}
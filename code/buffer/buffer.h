@@ -11,12 +11,19 @@
 #include <unistd.h>  // write
 #include <sys/uio.h> //readv
 #include <vector> //readv
+#include <string>
+#include <string_view>
 #include <atomic>
 #include <assert.h>
+
+#include "slab.h"
+
+// 存储按需从内存池借用：第一次写入时才分配，不超过一个块的取自SlabAllocator
+// 数据读空后可以调用Release把存储还回去，空闲的连接不占缓冲区内存
 class Buffer {
 public:
     Buffer(int initBuffSize = 1024);
-    ~Buffer() = default;
+    ~Buffer();
 
     size_t WritableBytes() const;       
     size_t ReadableBytes() const ;
@@ -35,7 +42,7 @@ public:
     const char* BeginWriteConst() const;
     char* BeginWrite();
 
-    void Append(const std::string& str);
+    void Append(std::string_view str);
     void Append(const char* str, size_t len);
     void Append(const void* data, size_t len);
     void Append(const Buffer& buff);
@@ -43,12 +50,22 @@ public:
     ssize_t ReadFd(int fd, int* Errno);
     ssize_t WriteFd(int fd, int* Errno);
 
+    // 当前占用的存储大小
+    size_t Capacity() const { return capacity_; }
+    // 没有可读数据时归还存储，返回是否归还
+    bool Release();
+
 private:
     char* BeginPtr_();
     const char* BeginPtr_() const;
     void MakeSpace_(size_t len);
 
-    std::vector<char> buffer_;
+    static char* Allocate_(size_t& size);
+    static void Deallocate_(char* data, size_t size);
+
+    char* buffer_;
+    size_t capacity_;
+    size_t initSize_;
     std::atomic<std::size_t> readPos_;
     std::atomic<std::size_t> writePos_;
 };
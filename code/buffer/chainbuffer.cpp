@@ -0,0 +1,159 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "chainbuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <assert.h>
+
+ChainBuffer::ChainBuffer(): head_(nullptr), tail_(nullptr), readable_(0), chunkCnt_(0) {}
+
+ChainBuffer::~ChainBuffer() {
+    while(head_) {
+        PopFront_();
+    }
+}
+
+ChainBuffer::Chunk* ChainBuffer::NewChunk_() {
+    chunkCnt_++;
+    Chunk* chunk = static_cast<Chunk*>(SlabAllocator::Alloc());
+    chunk->next = nullptr;
+    chunk->readPos = chunk->writePos = 0;
+    return chunk;
+}
+
+void ChainBuffer::PopFront_() {
+    Chunk* chunk = head_;
+    head_ = chunk->next;
+    if(!head_) { tail_ = nullptr; }
+    chunkCnt_--;
+    SlabAllocator::Free(chunk);
+}
+
+void ChainBuffer::Append(std::string_view str) {
+    Append(str.data(), str.size());
+}
+
+void ChainBuffer::Append(const void* data, size_t len) {
+    assert(data);
+    Append(static_cast<const char*>(data), len);
+}
+
+//尾块写满后挂新块，不搬移已有数据
+void ChainBuffer::Append(const char* str, size_t len) {
+    assert(str || len == 0);
+    readable_ += len;
+    while(len > 0) {
+        if(!tail_ || tail_->writePos == CHUNK_CAPACITY) {
+            Chunk* chunk = NewChunk_();
+            if(tail_) { tail_->next = chunk; }
+            else { head_ = chunk; }
+            tail_ = chunk;
+        }
+        size_t n = std::min(len, CHUNK_CAPACITY - tail_->writePos);
+        memcpy(tail_->Data() + tail_->writePos, str, n);
+        tail_->writePos += n;
+        str += n;
+        len -= n;
+    }
+}
+
+void ChainBuffer::Prepend(std::string_view str) {
+    Prepend(str.data(), str.size());
+}
+
+//从数据末尾往前填，头块前面没有空间时在前面挂新块
+void ChainBuffer::Prepend(const char* str, size_t len) {
+    assert(str || len == 0);
+    readable_ += len;
+    //空的头块整块让给预留区
+    if(head_ && head_->readPos == head_->writePos && head_ == tail_) {
+        head_->readPos = head_->writePos = CHUNK_CAPACITY;
+    }
+    while(len > 0) {
+        if(!head_ || head_->readPos == 0) {
+            Chunk* chunk = NewChunk_();
+            chunk->readPos = chunk->writePos = CHUNK_CAPACITY;
+            chunk->next = head_;
+            if(!head_) { tail_ = chunk; }
+            head_ = chunk;
+        }
+        size_t n = std::min(len, head_->readPos);
+        head_->readPos -= n;
+        len -= n;
+        memcpy(head_->Data() + head_->readPos, str + len, n);
+    }
+}
+
+void ChainBuffer::Retrieve(size_t len) {
+    assert(len <= readable_);
+    readable_ -= len;
+    while(len > 0) {
+        size_t n = std::min(len, head_->writePos - head_->readPos);
+        head_->readPos += n;
+        len -= n;
+        if(head_->readPos == head_->writePos && head_ != tail_) {
+            PopFront_();
+        }
+    }
+    if(readable_ == 0 && head_) {
+        head_->readPos = head_->writePos = 0;
+    }
+}
+
+void ChainBuffer::RetrieveAll() {
+    while(head_ && head_ != tail_) {
+        PopFront_();
+    }
+    if(head_) {
+        head_->readPos = head_->writePos = 0;
+    }
+    readable_ = 0;
+}
+
+bool ChainBuffer::Release() {
+    if(readable_ > 0) { return false; }
+    while(head_) {
+        PopFront_();
+    }
+    return true;
+}
+
+std::string ChainBuffer::RetrieveAllToStr() {
+    std::string str;
+    str.reserve(readable_);
+    for(Chunk* chunk = head_; chunk; chunk = chunk->next) {
+        str.append(chunk->Data() + chunk->readPos, chunk->writePos - chunk->readPos);
+    }
+    RetrieveAll();
+    return str;
+}
+
+int ChainBuffer::ReadableIov(struct iovec* iov, int cnt) const {
+    int n = 0;
+    for(Chunk* chunk = head_; chunk && n < cnt; chunk = chunk->next) {
+        if(chunk->readPos == chunk->writePos) { continue; }
+        iov[n].iov_base = chunk->Data() + chunk->readPos;
+        iov[n].iov_len = chunk->writePos - chunk->readPos;
+        n++;
+    }
+    return n;
+}
+
+//所有块一次writev发出，不需要先拼成连续内存
+ssize_t ChainBuffer::WriteFd(int fd, int* saveErrno) {
+    struct iovec iov[MAX_IOV];
+    int cnt = ReadableIov(iov, sizeof(iov) / sizeof(iov[0]));
+    if(cnt == 0) { return 0; }
+    ssize_t len = writev(fd, iov, cnt);
+    if(len < 0) {
+        *saveErrno = errno;
+        return len;
+    }
+    Retrieve(len);
+    return len;
+}
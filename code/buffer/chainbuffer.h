@@ -0,0 +1,72 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+
+#ifndef CHAIN_BUFFER_H
+#define CHAIN_BUFFER_H
+
+#include <string>
+#include <string_view>
+#include <sys/uio.h> //writev
+#include <unistd.h>
+
+#include "slab.h"
+
+// 由定长内存块串成的缓冲区，块取自SlabAllocator
+// 追加数据只往尾块写，写满就挂一个新块，已有数据从不搬移或扩容拷贝；
+// 头部可以预留（Prepend），发送时按块生成iovec交给writev
+class ChainBuffer {
+public:
+    ChainBuffer();
+    ~ChainBuffer();
+
+    ChainBuffer(const ChainBuffer&) = delete;
+    ChainBuffer& operator=(const ChainBuffer&) = delete;
+
+    size_t ReadableBytes() const { return readable_; }
+
+    void Append(std::string_view str);
+    void Append(const char* str, size_t len);
+    void Append(const void* data, size_t len);
+
+    // 在可读数据之前插入
+    void Prepend(std::string_view str);
+    void Prepend(const char* str, size_t len);
+
+    void Retrieve(size_t len);
+    // 清空数据，保留第一个块供下次使用
+    void RetrieveAll();
+    std::string RetrieveAllToStr();
+
+    // 没有可读数据时把所有块还给SlabAllocator，返回是否归还
+    bool Release();
+    // 当前占用的块内存大小
+    size_t Capacity() const { return chunkCnt_ * SlabAllocator::CHUNK_SIZE; }
+
+    // 按顺序填充可读数据的iovec，最多cnt个，返回填充的个数
+    int ReadableIov(struct iovec* iov, int cnt) const;
+
+    ssize_t WriteFd(int fd, int* Errno);
+
+private:
+    struct Chunk {
+        Chunk* next;
+        size_t readPos;
+        size_t writePos;
+        char* Data() { return reinterpret_cast<char*>(this + 1); }
+    };
+    static const size_t CHUNK_CAPACITY = SlabAllocator::CHUNK_SIZE - sizeof(Chunk);
+    static const int MAX_IOV = 64;
+
+    Chunk* NewChunk_();
+    void PopFront_();
+
+    Chunk* head_;
+    Chunk* tail_;
+    size_t readable_;
+    size_t chunkCnt_;
+};
+
+#endif //CHAIN_BUFFER_H
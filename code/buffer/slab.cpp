@@ -0,0 +1,104 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "slab.h"
+#include "../pool/affinity.h"
+
+SlabAllocator::LocalCache::~LocalCache() {
+    Release_(*this, count);
+}
+
+SlabAllocator::LocalCache& SlabAllocator::Local_() {
+    static thread_local LocalCache local;
+    return local;
+}
+
+SlabAllocator::Central& SlabAllocator::Central_(int node) {
+    //不析构，其他线程退出时仍可能归还内存块
+    static Central* centrals = new Central[MAX_NODES];
+    return centrals[node % MAX_NODES];
+}
+
+void* SlabAllocator::Alloc() {
+    LocalCache& local = Local_();
+    if(!local.head) {
+        Refill_(local);
+    }
+    FreeChunk* chunk = local.head;
+    local.head = chunk->next;
+    local.count--;
+    return chunk;
+}
+
+void SlabAllocator::Free(void* chunk) {
+    if(!chunk) { return; }
+    LocalCache& local = Local_();
+    FreeChunk* node = static_cast<FreeChunk*>(chunk);
+    node->next = local.head;
+    local.head = node;
+    local.count++;
+    if(local.count > LOCAL_MAX) {
+        Release_(local, BATCH);
+    }
+}
+
+size_t SlabAllocator::SlabCount() {
+    size_t cnt = 0;
+    for(int node = 0; node < MAX_NODES; node++) {
+        Central& central = Central_(node);
+        std::lock_guard<std::mutex> locker(central.mtx);
+        cnt += central.slabs.size();
+    }
+    return cnt;
+}
+
+//先从本节点的全局链表成批取，也空了再申请一个新的slab
+void SlabAllocator::Refill_(LocalCache& local) {
+    Central& central = Central_(CpuAffinity::CurrentNode());
+    {
+        std::lock_guard<std::mutex> locker(central.mtx);
+        while(central.head && local.count < BATCH) {
+            FreeChunk* chunk = central.head;
+            central.head = chunk->next;
+            central.count--;
+            chunk->next = local.head;
+            local.head = chunk;
+            local.count++;
+        }
+    }
+    if(local.head) { return; }
+
+    char* slab = static_cast<char*>(::operator new(CHUNK_SIZE * SLAB_CHUNKS));
+    {
+        std::lock_guard<std::mutex> locker(central.mtx);
+        central.slabs.push_back(slab);
+    }
+    for(size_t i = 0; i < SLAB_CHUNKS; i++) {
+        FreeChunk* chunk = reinterpret_cast<FreeChunk*>(slab + i * CHUNK_SIZE);
+        chunk->next = local.head;
+        local.head = chunk;
+        local.count++;
+    }
+}
+
+//把本地链表头部的cnt块交给全局链表
+void SlabAllocator::Release_(LocalCache& local, size_t cnt) {
+    if(!local.head || cnt == 0) { return; }
+    FreeChunk* first = local.head;
+    FreeChunk* last = first;
+    size_t n = 1;
+    while(n < cnt && last->next) {
+        last = last->next;
+        n++;
+    }
+    local.head = last->next;
+    local.count -= n;
+
+    Central& central = Central_(CpuAffinity::CurrentNode());
+    std::lock_guard<std::mutex> locker(central.mtx);
+    last->next = central.head;
+    central.head = first;
+    central.count += n;
+}
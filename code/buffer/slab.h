@@ -0,0 +1,58 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <mutex>
+#include <vector>
+#include <cstddef>
+
+// 定长内存块的分配器
+// 每个线程缓存一条空闲块链表，分配和释放都不加锁；本地缓存过多时成批交给全局链表，本地用完时先从全局成批取回，再不够才整块（slab）申请
+// 块在哪个线程释放就回到哪个线程的缓存，不要求和分配线程相同
+// 全局链表按NUMA节点分开，线程只和自己所在节点的链表交换；新slab由申请线程切块时首次写入，页面落在该线程的节点上
+class SlabAllocator {
+public:
+    static const size_t CHUNK_SIZE = 4096;
+
+    static void* Alloc();
+    static void Free(void* chunk);
+
+    // 已向系统申请的slab数，用于观察内存占用
+    static size_t SlabCount();
+
+private:
+    struct FreeChunk {
+        FreeChunk* next;
+    };
+
+    struct LocalCache {
+        FreeChunk* head = nullptr;
+        size_t count = 0;
+        ~LocalCache();  //线程退出时把缓存交还全局链表
+    };
+
+    // 每个节点一个全局链表，进程退出时由系统回收
+    struct Central {
+        std::mutex mtx;
+        FreeChunk* head = nullptr;
+        size_t count = 0;
+        std::vector<char*> slabs;
+    };
+
+    static const size_t SLAB_CHUNKS = 16;   //每个slab切成的块数
+    static const size_t LOCAL_MAX = 256;    //线程缓存上限
+    static const size_t BATCH = 64;         //与全局链表之间每次搬运的块数
+    static const int MAX_NODES = 8;         //超出的节点按取模共用链表
+
+    static LocalCache& Local_();
+    static Central& Central_(int node);
+    static void Refill_(LocalCache& local);
+    static void Release_(LocalCache& local, size_t cnt);
+};
+
+#endif //SLAB_H
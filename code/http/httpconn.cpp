@@ -7,13 +7,25 @@
 using namespace std;
 
 const char* HttpConn::srcDir;
+const Router* HttpConn::router;
 std::atomic<int> HttpConn::userCount;
+std::atomic<size_t> HttpConn::bufferBytes;
 bool HttpConn::isET;
 
 HttpConn::HttpConn() { 
     fd_ = -1;
     addr_ = { 0 };
     isClose_ = true;
+    route_ = nullptr;
+    handleState_ = HANDLE_NONE;
+    request_ = nullptr;
+    response_ = nullptr;
+    fileSent_ = 0;
+    bufferMem_ = 0;
+    phase_ = PHASE_CLOSED;
+    phaseStart_ = 0;
+    phaseBytes_ = 0;
+    lastWrite_ = 0;
 };
 
 HttpConn::~HttpConn() { 
@@ -29,18 +41,28 @@ void HttpConn::init(int fd, const sockaddr_in& addr) {
     //清空缓存
     writeBuff_.RetrieveAll();
     readBuff_.RetrieveAll();
+    //上一个连接可能在请求中途关闭
+    NextRequest_();
+    SetPhase_(PHASE_HEADER);
     isClose_ = false;
     LOG_INFO("Client[%d](%s:%d) in, userCount:%d", fd_, GetIP(), GetPort(), (int)userCount);
 }
 
 void HttpConn::Close() {
-    // 释放内存
-    response_.UnmapFile();
+    //处理函数还没完成，连接的内存和fd都不能动
+    if(CloseOnComplete()) { return; }
     if(isClose_ == false){
         isClose_ = true; 
+        phase_ = PHASE_CLOSED;
         userCount--;
+        LOG_INFO("Client[%d](%s:%d) quit, UserCount:%d, memory:%zu", fd_, GetIP(), GetPort(), (int)userCount, MemoryUsage());
+        //缓冲区全部还给内存池后再关闭fd：fd一关闭就可能被新连接复用，主线程会立即init同一个对象
+        writeBuff_.RetrieveAll();
+        readBuff_.RetrieveAll();
+        //收了一半的请求和没发完的文件一起丢掉
+        FreeRequest_();
+        ReleaseIdle_();
         close(fd_);
-        LOG_INFO("Client[%d](%s:%d) quit, UserCount:%d", fd_, GetIP(), GetPort(), (int)userCount);
     }
 }
 
@@ -74,8 +96,10 @@ ssize_t HttpConn::read(int* saveErrno) {
         if (len <= 0) {
             break;
         }
+        phaseBytes_.fetch_add(len, memory_order_relaxed);
     } while (isET); //先读取，再判断是否为ET模式（边缘触发模式）
     //ET模式：epoll_wait检测到有fd事件发生，立即进行处理，并将数据一次性读完
+    UpdateMemory_();
     return len;
 }
 
@@ -83,69 +107,219 @@ ssize_t HttpConn::read(int* saveErrno) {
 ssize_t HttpConn::write(int* saveErrno) {
     ssize_t len = -1;
     do {
-        // 将iovec中的数据发送给fd_
-        len = writev(fd_, iov_, iovCnt_);
-        if(len <= 0) {
-            *saveErrno = errno;
-            break;
-        }
-
+        // iov_base指向一个缓冲区，这个缓冲区是存放的是write()将要发送的数据。
         // struct iovec {
         //     ptr_t iov_base; /* Starting address */
         //     size_t iov_len; /* Length in bytes */
         // };
-
-        if(iov_[0].iov_len + iov_[1].iov_len  == 0) { break; } /* 传输结束 */
-        //传输数据超过第一个缓冲区的大小，更新第二个缓冲区的起始地址和剩余大小
-        else if(static_cast<size_t>(len) > iov_[0].iov_len) {
-            iov_[1].iov_base = (uint8_t*) iov_[1].iov_base + (len - iov_[0].iov_len);
-            iov_[1].iov_len -= (len - iov_[0].iov_len);
-            if(iov_[0].iov_len) {
-                //将writeBuf中所有字节读完
-                writeBuff_.RetrieveAll();
-                iov_[0].iov_len = 0;
-            }
+        struct iovec iov[MAX_IOV];
+        int iovCnt = writeBuff_.ReadableIov(iov, MAX_IOV - 1);
+        size_t headLen = 0;
+        for(int i = 0; i < iovCnt; i++) { headLen += iov[i].iov_len; }
+        //写缓冲区的块全部放进iovec之后才能接着放文件，保证发送顺序
+        size_t fileLeft = FileLeft_();
+        if(headLen == writeBuff_.ReadableBytes() && fileLeft > 0 && response_->File()) {
+            iov[iovCnt].iov_base = response_->File() + fileSent_;
+            iov[iovCnt].iov_len = fileLeft;
+            iovCnt++;
         }
-        else {
-            //长度小于第一个缓冲区的大小，则更新第二个缓冲区起始地址和剩余大小
-            iov_[0].iov_base = (uint8_t*)iov_[0].iov_base + len; 
-            iov_[0].iov_len -= len; 
-            //读取writeBuf中len个字节
-            writeBuff_.Retrieve(len);
+        if(iovCnt == 0) { break; } /* 传输结束 */
+
+        // 将iovec中的数据发送给fd_
+        len = writev(fd_, iov, iovCnt);
+        if(len <= 0) {
+            *saveErrno = errno;
+            break;
         }
+        //先消耗写缓冲区，超出的部分属于文件
+        size_t fromBuff = min(static_cast<size_t>(len), headLen);
+        writeBuff_.Retrieve(fromBuff);
+        fileSent_ += len - fromBuff;
+        lastWrite_.store(NowMs(), memory_order_relaxed);
     } while(isET || ToWriteBytes() > 10240); //ET模式且缓冲区大小>10240
+    UpdateMemory_();
     return len;
 }
 
 //处理请求并生成响应报文
-bool HttpConn::process() {
-    request_.Init();
+HttpConn::PROCESS_STATE HttpConn::process() {
+    route_ = nullptr;
+    //上一个请求已处理完，开始解析新的请求；否则接着解析没收完的请求
+    if(request_ && request_->IsFinish()) {
+        NextRequest_();
+        //缓冲区里已有下一个请求的数据时直接开始收头部，否则进入空闲
+        SetPhase_(readBuff_.ReadableBytes() ? PHASE_HEADER : PHASE_IDLE);
+    }
     if(readBuff_.ReadableBytes() <= 0) {
-        return false;
+        ReleaseIdle_();
+        return PROCESS_WAIT;
+    }
+    if(!request_) {
+        NewRequest_();
     }
     //解析缓冲区的报文内容
-    else if(request_.parse(readBuff_)) {
-        LOG_DEBUG("%s", request_.path().c_str());
-        response_.Init(srcDir, request_.path(), request_.IsKeepAlive(), 200);
-    } else {
-        response_.Init(srcDir, request_.path(), false, 400);
+    if(!request_->parse(readBuff_)) {
+        response_->Init(srcDir, request_->path(), false, request_->ErrorCode());
     }
+    //请求还没收完，继续等待数据
+    else if(!request_->IsFinish()) {
+        if(request_->InBody() && Phase() == PHASE_HEADER) {
+            SetPhase_(PHASE_BODY);
+        }
+        if(request_->ExpectContinue()) {
+            SendContinue_();
+        }
+        ReleaseIdle_();
+        return PROCESS_WAIT;
+    }
+    else {
+        LOG_DEBUG("%s", request_->path().c_str());
+        response_->Init(srcDir, request_->path(), request_->IsKeepAlive(), 200);
+        //没有命中路由的请求按静态文件处理
+        if(router) {
+            route_ = router->Match(request_->method(), request_->path(), request_->params());
+        }
+        if(route_ && route_->policy != Router::INLINE) {
+            handleState_.store(HANDLE_RUNNING);
+            SetPhase_(PHASE_HANDLE);
+            return PROCESS_DEFER;
+        }
+        if(route_) {
+            route_->handler(*request_, *response_);
+        }
+    }
+    MakeResponse_();
+    return PROCESS_DONE;
+}
+
+void HttpConn::Handle() {
+    assert(route_ && route_->handler);
+    route_->handler(*request_, *response_);
+}
+
+//协程帧从连接的内存区分配，在调用done之前销毁；在那之前连接不会关闭，内存区不会回收或给下一个请求用
+void HttpConn::HandleAsync(const Router::DoneCallBack& done) {
+    assert(route_ && route_->asyncHandler);
+    CoFrameScope scope(&arena_);
+    route_->asyncHandler(*request_, *response_, done);
+}
+
+//响应在结束处理状态之前生成，之后的关闭按发送阶段的连接处理
+bool HttpConn::Finish() {
+    MakeResponse_();
+    return EndHandle_();
+}
+
+bool HttpConn::Reject(int code) {
+    response_->SetCode(code);
+    MakeResponse_();
+    return EndHandle_();
+}
+
+bool HttpConn::CloseOnComplete() {
+    int state = HANDLE_RUNNING;
+    return handleState_.compare_exchange_strong(state, HANDLE_CLOSE_PENDING) || state == HANDLE_CLOSE_PENDING;
+}
+
+//结束处理状态，之后的Close真正关闭连接
+bool HttpConn::EndHandle_() {
+    return handleState_.exchange(HANDLE_NONE) != HANDLE_CLOSE_PENDING;
+}
 
+void HttpConn::MakeResponse_() {
     // 生成响应报文到报文缓冲区中
-    response_.MakeResponse(writeBuff_);
-    /* 响应头 */
-    // 第一个iovec指针指向响应报文缓冲区
-    iov_[0].iov_base = const_cast<char*>(writeBuff_.Peek());
-    iov_[0].iov_len = writeBuff_.ReadableBytes();
-    iovCnt_ = 1;
-
-    /* 文件 */
-    //第二个iovec指针指向mmap返回的文件指针
-    if(response_.FileLen() > 0  && response_.File()) {
-        iov_[1].iov_base = response_.File();
-        iov_[1].iov_len = response_.FileLen();
-        iovCnt_ = 2;
+    response_->MakeResponse(writeBuff_);
+    // 文件内容由mmap映射，发送时与响应头一起交给writev
+    fileSent_ = 0;
+    SetPhase_(PHASE_WRITE);
+    UpdateMemory_();
+    LOG_DEBUG("filesize:%d, to %d", response_->FileLen(), ToWriteBytes());
+}
+
+int64_t HttpConn::NowMs() {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t HttpConn::Deadline(const Timeouts& limits) const {
+    switch(Phase()) {
+    case PHASE_HEADER:
+        return PhaseStart() + limits.headerMs;
+    case PHASE_BODY:
+        // 之后不再收到数据时，平均速率降到下限的时刻
+        return PhaseStart() + limits.bodyGraceMs + int64_t(PhaseBytes()) * 1000 / limits.bodyMinRate;
+    case PHASE_HANDLE:
+        return PhaseStart() + limits.handleMs;
+    case PHASE_WRITE:
+        return LastWrite() + limits.writeStallMs;
+    default:
+        return PhaseStart() + limits.idleMs;
+    }
+}
+
+void HttpConn::SetPhase_(PHASE phase) {
+    int64_t now = NowMs();
+    phaseStart_.store(now, memory_order_relaxed);
+    phaseBytes_.store(0, memory_order_relaxed);
+    if(phase == PHASE_WRITE) { lastWrite_.store(now, memory_order_relaxed); }
+    phase_.store(phase, memory_order_relaxed);
+}
+
+//请求和响应对象放在内存区的开头，构造时它们的容器还是空的，不分配内存
+void HttpConn::NewRequest_() {
+    assert(!request_ && !response_);
+    request_ = new(arena_.allocate(sizeof(HttpRequest), alignof(HttpRequest))) HttpRequest(&arena_);
+    response_ = new(arena_.allocate(sizeof(HttpResponse), alignof(HttpResponse))) HttpResponse(&arena_);
+}
+
+//析构请求和响应：删除上传的临时文件、解除文件映射；存储随内存区回收
+void HttpConn::FreeRequest_() {
+    if(request_) {
+        request_->~HttpRequest();
+        request_ = nullptr;
+    }
+    if(response_) {
+        response_->~HttpResponse();
+        response_ = nullptr;
+    }
+}
+
+//先析构请求和响应，再整体回收内存区，之后的分配从头复用已有的块
+void HttpConn::NextRequest_() {
+    assert(handleState_ == HANDLE_NONE);
+    FreeRequest_();
+    arena_.Reset();
+}
+
+//等待数据期间不占用缓冲区：读空的读缓冲区和发完的写缓冲区都还给内存池
+//请求头部在请求体跨多次读取前已经拷贝出来，这里归还读缓冲区是安全的
+//内存区只在两个请求之间归还，收了一半的请求还在使用它
+void HttpConn::ReleaseIdle_() {
+    readBuff_.Release();
+    writeBuff_.Release();
+    if(request_ && request_->IsIdle()) {
+        FreeRequest_();
+    }
+    if(!request_) {
+        arena_.Release();
+    }
+    UpdateMemory_();
+}
+
+void HttpConn::UpdateMemory_() {
+    size_t mem = readBuff_.Capacity() + writeBuff_.Capacity() + arena_.Capacity();
+    if(mem != bufferMem_) {
+        bufferBytes += mem;
+        bufferBytes -= bufferMem_;
+        bufferMem_ = mem;
+    }
+}
+
+//客户端带 Expect: 100-continue 时，先回复100再接收请求体
+//响应只有一行，直接写socket，不经过写缓冲区
+void HttpConn::SendContinue_() {
+    const char CONTINUE[] = "HTTP/1.1 100 Continue\r\n\r\n";
+    if(send(fd_, CONTINUE, sizeof(CONTINUE) - 1, MSG_NOSIGNAL) < 0) {
+        LOG_WARN("Client[%d] send 100 Continue error: %d", fd_, errno);
     }
-    LOG_DEBUG("filesize:%d, %d  to %d", response_.FileLen() , iovCnt_, ToWriteBytes());
-    return true;
+    request_->ContinueSent();
 }
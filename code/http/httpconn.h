@@ -9,6 +9,7 @@
 
 #include <sys/types.h>
 #include <sys/uio.h>     // readv/writev
+#include <sys/socket.h>  // send
 #include <arpa/inet.h>   // sockaddr_in
 #include <stdlib.h>      // atoi()
 #include <errno.h>      
@@ -16,8 +17,12 @@
 #include "../log/log.h"
 #include "../pool/sqlconnRAII.h"
 #include "../buffer/buffer.h"
+#include "../buffer/chainbuffer.h"
+#include "../buffer/arena.h"
+#include "../timer/timingwheel.h"
 #include "httprequest.h"
 #include "httpresponse.h"
+#include "router.h"
 
 /*
 http报文处理流程
@@ -31,6 +36,33 @@ http报文处理流程
 
 class HttpConn {
 public:
+    //process的处理结果
+    enum PROCESS_STATE {
+        PROCESS_WAIT,   //请求还没收完，继续监听读事件
+        PROCESS_DONE,   //响应报文已生成，可以发送
+        PROCESS_DEFER,  //命中的路由要在别处执行，执行完后再生成响应
+    };
+
+    //连接所处的阶段，超时按阶段分别计算；由处理连接的线程更新，reactor的定时回调读取
+    enum PHASE {
+        PHASE_HEADER,   //收请求行和头部，从建立连接或收到请求的第一批数据起计时
+        PHASE_BODY,     //收请求体
+        PHASE_HANDLE,   //执行处理函数
+        PHASE_WRITE,    //发送响应
+        PHASE_IDLE,     //长连接等待下一个请求
+        PHASE_CLOSED,
+    };
+
+    //各阶段的超时，毫秒
+    struct Timeouts {
+        int headerMs;       //请求行和头部要在这段时间内收完
+        int bodyGraceMs;    //请求体开头的宽限，之后平均速率不能低于bodyMinRate
+        int bodyMinRate;    //字节/秒
+        int handleMs;       //处理函数执行超过这么久，完成后关闭连接而不回复
+        int writeStallMs;   //发送响应时连续这么久发不出数据
+        int idleMs;         //长连接空闲
+    };
+
     HttpConn();
 
     ~HttpConn();
@@ -51,38 +83,107 @@ public:
     
     sockaddr_in GetAddr() const;
     
-    bool process();
+    PROCESS_STATE process();
+
+    //执行PROCESS_DEFER对应的路由处理函数，之后调用Finish生成响应报文
+    //从PROCESS_DEFER到Finish/Reject之间处理函数在使用请求、响应和内存区，这期间的Close只做标记
+    void Handle();
+    void HandleAsync(const Router::DoneCallBack& done);
+    //返回false表示处理期间连接被要求关闭，不要再发送，由调用方关闭
+    bool Finish();
+    //不执行处理函数，直接以code（如503）回复；返回值同Finish
+    bool Reject(int code);
+    const Router::Route* route() const { return route_; }
+    //处理函数执行中时标记为完成后关闭并返回true，没有在执行返回false
+    bool CloseOnComplete();
+    bool ClosePending() const { return handleState_.load() == HANDLE_CLOSE_PENDING; }
 
     //发送的全部数据为响应报文头部信息和文件大小
-    int ToWriteBytes() { 
-        return iov_[0].iov_len + iov_[1].iov_len; 
+    size_t ToWriteBytes() const { 
+        return writeBuff_.ReadableBytes() + FileLeft_(); 
     }
 
     bool IsKeepAlive() const {
-        return request_.IsKeepAlive();
+        return request_ && request_->IsKeepAlive();
+    }
+
+    //连接占用的内存：对象本身加上当前借用的读写缓冲区和请求内存区
+    size_t MemoryUsage() const {
+        return sizeof(HttpConn) + bufferMem_;
+    }
+
+    //超时关闭用的定时节点，只在reactor线程操作
+    TimerEntry* Timer() { return &timer_; }
+
+    PHASE Phase() const { return phase_.load(std::memory_order_relaxed); }
+    //进入当前阶段的时刻和这之后读到的字节数
+    int64_t PhaseStart() const { return phaseStart_.load(std::memory_order_relaxed); }
+    size_t PhaseBytes() const { return phaseBytes_.load(std::memory_order_relaxed); }
+    //最近一次发出数据的时刻
+    int64_t LastWrite() const { return lastWrite_.load(std::memory_order_relaxed); }
+    //当前阶段的截止时刻，NowMs的时钟
+    int64_t Deadline(const Timeouts& limits) const;
+    //空闲的长连接上有数据到达，开始收下一个请求；reactor派发读事件时调用
+    void BeginRequest() {
+        if(Phase() == PHASE_IDLE) { SetPhase_(PHASE_HEADER); }
     }
+    //阶段计时用的时钟，steady_clock的毫秒数
+    static int64_t NowMs();
 
     static bool isET;
     static const char* srcDir;
+    static const Router* router;
     //用户连接定义为原子
     static std::atomic<int> userCount;
+    //所有连接借用的读写缓冲区和请求内存区总字节数
+    static std::atomic<size_t> bufferBytes;
     
 private:
-   
+    //处理函数的执行状态
+    enum HANDLE_STATE {
+        HANDLE_NONE,
+        HANDLE_RUNNING,
+        HANDLE_CLOSE_PENDING,   //执行期间有人要关闭连接，执行完后由Finish/Reject的调用方关闭
+    };
+
+    void SetPhase_(PHASE phase);
+    bool EndHandle_();
+    void SendContinue_();
+    void MakeResponse_();
+    void NewRequest_();
+    void FreeRequest_();
+    void NextRequest_();
+    void ReleaseIdle_();
+    void UpdateMemory_();
+    size_t FileLeft_() const {
+        return response_ && response_->FileLen() > fileSent_ ? response_->FileLen() - fileSent_ : 0;
+    }
+
     int fd_;
     struct  sockaddr_in addr_;
 
     bool isClose_;
     
-    int iovCnt_;
-    // iov_base指向一个缓冲区，这个缓冲区是存放的是write()将要发送的数据。
-    struct iovec iov_[2];
+    // 写缓冲区的各个块加上文件，一次writev发出
+    static const int MAX_IOV = 16;
+    size_t fileSent_;   // 文件已发送的字节数
     
     Buffer readBuff_; // 读缓冲区
-    Buffer writeBuff_; // 写缓冲区
-
-    HttpRequest request_;
-    HttpResponse response_;
+    ChainBuffer writeBuff_; // 写缓冲区
+    size_t bufferMem_;      // 上次统计时缓冲区和内存区的容量
+
+    // 请求和响应对象连同它们的字符串、容器都分配在这里，处理完一个请求整体回收
+    Arena arena_;
+    // 收到请求的数据时才在arena_上构造，空闲的长连接不持有，对象本身只剩缓冲区、地址和计时等几百字节
+    HttpRequest* request_;
+    HttpResponse* response_;
+    const Router::Route* route_;
+    std::atomic<int> handleState_;
+    TimerEntry timer_;
+    std::atomic<PHASE> phase_;
+    std::atomic<int64_t> phaseStart_;
+    std::atomic<size_t> phaseBytes_;
+    std::atomic<int64_t> lastWrite_;
 };
 
 
@@ -0,0 +1,41 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "httpdate.h"
+#include <thread>
+
+char HttpDate::header_[2][HEADER_LEN + 1];
+std::atomic<int> HttpDate::index_(0);
+std::atomic<time_t> HttpDate::second_(0);
+std::atomic_flag HttpDate::refreshing_ = ATOMIC_FLAG_INIT;
+
+void HttpDate::Append(ChainBuffer& buff) {
+    time_t now = time(nullptr);
+    if(now != second_.load(std::memory_order_acquire)) {
+        Refresh_(now);
+        //启动时还没有任何可用的值，等正在刷新的线程写完
+        while(second_.load(std::memory_order_acquire) == 0) {
+            std::this_thread::yield();
+        }
+    }
+    buff.Append(header_[index_.load(std::memory_order_acquire)], HEADER_LEN);
+}
+
+// 同一时刻只有一个线程刷新，其余线程继续用上一秒的值
+// 读者拷贝37个字节期间，另一块缓冲要等下一秒才会被改写
+void HttpDate::Refresh_(time_t now) {
+    if(refreshing_.test_and_set(std::memory_order_acquire)) {
+        return;
+    }
+    if(now != second_.load(std::memory_order_relaxed)) {
+        int next = 1 - index_.load(std::memory_order_relaxed);
+        struct tm t;
+        gmtime_r(&now, &t);
+        strftime(header_[next], HEADER_LEN + 1, "Date: %a, %d %b %Y %H:%M:%S GMT\r\n", &t);
+        index_.store(next, std::memory_order_release);
+        second_.store(now, std::memory_order_release);
+    }
+    refreshing_.clear(std::memory_order_release);
+}
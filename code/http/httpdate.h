@@ -0,0 +1,32 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef HTTP_DATE_H
+#define HTTP_DATE_H
+
+#include <atomic>
+#include <time.h>
+
+#include "../buffer/chainbuffer.h"
+
+// 所有线程共享的Date响应头，每秒最多格式化一次
+// 双缓冲：刷新时写入另一块，再切换下标，读者只做一次拷贝
+class HttpDate {
+public:
+    // "Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+    static const size_t HEADER_LEN = 37;
+
+    static void Append(ChainBuffer& buff);
+
+private:
+    static void Refresh_(time_t now);
+
+    static char header_[2][HEADER_LEN + 1];
+    static std::atomic<int> index_;
+    static std::atomic<time_t> second_;
+    static std::atomic_flag refreshing_;
+};
+
+#endif //HTTP_DATE_H
@@ -0,0 +1,98 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "httpheader.h"
+#include "perfecthash.h"
+
+using namespace std;
+
+// 常用头部名到固定槽位的映射，忽略大小写
+static constexpr auto KNOWN_HEADER = PerfectHash::Make<string_view, HttpHeader::HEADER_ID, true>({
+    { "Connection",        HttpHeader::CONNECTION },
+    { "Content-Length",    HttpHeader::CONTENT_LENGTH },
+    { "Content-Type",      HttpHeader::CONTENT_TYPE },
+    { "Transfer-Encoding", HttpHeader::TRANSFER_ENCODING },
+    { "Accept-Encoding",   HttpHeader::ACCEPT_ENCODING },
+    { "Host",              HttpHeader::HOST },
+    { "Expect",            HttpHeader::EXPECT },
+    { "Cookie",            HttpHeader::COOKIE },
+    { "Keep-Alive",        HttpHeader::KEEP_ALIVE },
+    { "User-Agent",        HttpHeader::USER_AGENT },
+    { "If-Modified-Since", HttpHeader::IF_MODIFIED_SINCE },
+    { "Range",             HttpHeader::RANGE },
+});
+static_assert(KNOWN_HEADER.size() == HttpHeader::HEADER_ID_COUNT, "every HEADER_ID needs a name");
+
+HttpHeader::HEADER_ID HttpHeader::Lookup(string_view name) {
+    const HEADER_ID* id = KNOWN_HEADER.Find(name);
+    return id ? *id : HEADER_ID_COUNT;
+}
+
+HttpHeader::HttpHeader(std::pmr::memory_resource* mr): mr_(mr), overflow_(mr), store_(mr) {
+    Clear();
+}
+
+void HttpHeader::Clear() {
+    known_.fill(string_view());
+    fieldCnt_ = 0;
+    overflow_ = std::pmr::vector<Field>(mr_);
+    std::pmr::string(mr_).swap(store_);
+}
+
+void HttpHeader::Add(string_view name, string_view value) {
+    HEADER_ID id = Lookup(name);
+    if(id != HEADER_ID_COUNT) {
+        known_[id] = value;
+        return;
+    }
+    if(fieldCnt_ < INLINE_FIELDS) {
+        fields_[fieldCnt_++] = { name, value };
+    } else {
+        overflow_.push_back({ name, value });
+    }
+}
+
+string_view HttpHeader::Get(HEADER_ID id) const {
+    return id < HEADER_ID_COUNT ? known_[id] : string_view();
+}
+
+string_view HttpHeader::Get(string_view name) const {
+    HEADER_ID id = Lookup(name);
+    if(id != HEADER_ID_COUNT) {
+        return known_[id];
+    }
+    for(size_t i = 0; i < fieldCnt_; i++) {
+        if(PerfectHash::EqualsIgnoreCase(fields_[i].name, name)) { return fields_[i].value; }
+    }
+    for(const Field& field : overflow_) {
+        if(PerfectHash::EqualsIgnoreCase(field.name, name)) { return field.value; }
+    }
+    return string_view();
+}
+
+void HttpHeader::Detach(string_view block) {
+    if(block.empty()) { return; }
+    store_.assign(block.data(), block.size());
+    const char* from = block.data();
+    auto rebase = [&](string_view& view) {
+        if(view.data() >= from && view.data() < from + block.size()) {
+            view = string_view(store_.data() + (view.data() - from), view.size());
+        }
+    };
+    for(string_view& value : known_) { rebase(value); }
+    for(size_t i = 0; i < fieldCnt_; i++) {
+        rebase(fields_[i].name);
+        rebase(fields_[i].value);
+    }
+    for(Field& field : overflow_) {
+        rebase(field.name);
+        rebase(field.value);
+    }
+}
+
+// 值指向缓冲区，空值的data()也不为空
+bool HttpHeader::Has(HEADER_ID id) const {
+    return Get(id).data() != nullptr;
+}
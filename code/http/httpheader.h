@@ -0,0 +1,70 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef HTTP_HEADER_H
+#define HTTP_HEADER_H
+
+#include <array>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <memory_resource>
+
+// 请求头部的紧凑存储
+// 字段名和值都是指向读缓冲区的string_view，不拷贝、不分配内存
+// 常用头部在解析时通过完美哈希识别一次，存放在固定槽位；其余头部只在查询时按名字（忽略大小写）线性查找
+class HttpHeader {
+public:
+    enum HEADER_ID {
+        CONNECTION = 0,
+        CONTENT_LENGTH,
+        CONTENT_TYPE,
+        TRANSFER_ENCODING,
+        ACCEPT_ENCODING,
+        HOST,
+        EXPECT,
+        COOKIE,
+        KEEP_ALIVE,
+        USER_AGENT,
+        IF_MODIFIED_SINCE,
+        RANGE,
+        HEADER_ID_COUNT,
+    };
+
+    explicit HttpHeader(std::pmr::memory_resource* mr = std::pmr::get_default_resource());
+
+    // 清空头部并丢掉已分配的存储，存储来自请求级的内存区时由内存区统一回收
+    void Clear();
+    void Add(std::string_view name, std::string_view value);
+
+    std::string_view Get(HEADER_ID id) const;
+    std::string_view Get(std::string_view name) const;
+    bool Has(HEADER_ID id) const;
+    size_t Count() const { return fieldCnt_ + overflow_.size(); }
+
+    // 返回字段名对应的HEADER_ID，非常用头部返回HEADER_ID_COUNT
+    static HEADER_ID Lookup(std::string_view name);
+
+    // 把头部所在的原始字节拷贝到自有存储并重新指向
+    // 请求体要跨多次读取时调用，避免读缓冲区扩容或腾挪后出现悬空引用
+    void Detach(std::string_view block);
+
+private:
+    struct Field {
+        std::string_view name;
+        std::string_view value;
+    };
+    static const size_t INLINE_FIELDS = 8;
+
+    std::array<std::string_view, HEADER_ID_COUNT> known_;
+    std::array<Field, INLINE_FIELDS> fields_;
+    size_t fieldCnt_;
+    std::pmr::memory_resource* mr_;
+    // 内联容量用完后放到这里
+    std::pmr::vector<Field> overflow_;
+    std::pmr::string store_;
+};
+
+#endif //HTTP_HEADER_H
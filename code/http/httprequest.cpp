@@ -6,64 +6,130 @@
 #include "httprequest.h"
 using namespace std;
 
-const unordered_set<string> HttpRequest::DEFAULT_HTML{
-            "/index", "/register", "/login",
-             "/welcome", "/video", "/picture", "/chat"};
+//无后缀的页面路径及其对应的html文件
+constexpr PerfectHash::Map<string_view, string_view, 7> HttpRequest::DEFAULT_HTML = PerfectHash::Make<string_view, string_view>({
+            { "/index",    "/index.html" },
+            { "/register", "/register.html" },
+            { "/login",    "/login.html" },
+            { "/welcome",  "/welcome.html" },
+            { "/video",    "/video.html" },
+            { "/picture",  "/picture.html" },
+            { "/chat",     "/chat.html" },
+});
 
-const unordered_map<string, int> HttpRequest::DEFAULT_HTML_TAG {
-            {"/register.html", 0}, {"/login.html", 1},  };
+const char* HttpRequest::UPLOAD_DIR = "/tmp";
+
+HttpRequest::HttpRequest(std::pmr::memory_resource* mr):
+    mr_(mr), method_(mr), path_(mr), version_(mr), body_(mr), header_(mr), post_(mr), partValue_(mr) {
+    uploadFd_ = -1;
+    multipart_.SetCallBack(
+        [this](const MultipartParser::Part& part) { return OnPartBegin_(part); },
+        [this](const MultipartParser::Part& part, const char* data, size_t len) { return OnPartData_(part, data, len); },
+        [this](const MultipartParser::Part& part) { return OnPartEnd_(part); });
+    Init();
+}
+
+HttpRequest::~HttpRequest() {
+    ClearUploads_();
+}
 
 void HttpRequest::Init() {
-    method_ = path_ = version_ = body_ = "";
+    //换成空容器，旧存储由内存区统一回收
+    //string的移动赋值遇到短字符串会保留原来的存储，只有swap能确保丢掉，否则Reset后会和新分配的内存重叠
+    for(std::pmr::string* str : { &method_, &path_, &version_, &body_, &partValue_ }) {
+        std::pmr::string(mr_).swap(*str);
+    }
     state_ = REQUEST_LINE;
-    header_.clear();
-    post_.clear();
+    code_ = 400;
+    keepAlive_ = false;
+    expectContinue_ = false;
+    header_.Clear();
+    headerBlock_ = string_view();
+    headerScan_ = 0;
+    bodyMode_ = NO_BODY;
+    bodyType_ = BODY_OTHER;
+    chunkState_ = CHUNK_SIZE;
+    bodyRemaining_ = bodyReceived_ = 0;
+    post_ = std::pmr::unordered_map<std::pmr::string, std::pmr::string>(mr_);
+    params_.Clear();
+    ClearUploads_();
 }
 
 // 检查是否为长连接
 // 短连接在数据包发送完成后就会自己断开，长连接在发包完毕后，会在一定的时间内保持连接
+// 在头部解析完时就已确定，请求体跨多次读取也不受影响
 bool HttpRequest::IsKeepAlive() const {
-    if(header_.count("Connection") == 1) {
-        return header_.find("Connection")->second == "keep-alive" && version_ == "1.1";
-    }
-    return false;
+    return keepAlive_;
 }
 
 //解析HTTP请求报文分成分别解析请求行、请求头部和请求数据的操作。
-//使用状态机转移的方式进行解析
+//使用状态机转移的方式进行解析；数据不完整时保留在缓冲区中，等下次读到更多数据后继续
 bool HttpRequest::parse(Buffer& buff) {
-    const char CRLF[] = "\r\n";
     if(buff.ReadableBytes() <= 0) {
         return false;
     }
-    while(buff.ReadableBytes() && state_ != FINISH) {
-        //根据数据尾部'\n'对TCP数据包进行拆包
-        const char* lineEnd = search(buff.Peek(), buff.BeginWriteConst(), CRLF, CRLF + 2);
-        std::string line(buff.Peek(), lineEnd);
-        switch(state_)
-        {
-        case REQUEST_LINE:
-            if(!ParseRequestLine_(line)) {
-                return false;
-            }
-            ParsePath_();
-            break;    
-        case HEADERS:
-            ParseHeader_(line);
-            if(buff.ReadableBytes() <= 2) {
-                state_ = FINISH;
-            }
-            break;
-        case BODY:
-            ParseBody_(line);
-            break;
-        default:
-            break;
+    if(state_ == REQUEST_LINE || state_ == HEADERS) {
+        if(!ParseHeaderBlock_(buff)) {
+            return false;
         }
-        if(lineEnd == buff.BeginWrite()) { break; }
-        buff.RetrieveUntil(lineEnd + 2);
     }
-    LOG_DEBUG("[%s], [%s], [%s]", method_.c_str(), path_.c_str(), version_.c_str());
+    if(state_ == BODY && !ParseBody_(buff)) {
+        return false;
+    }
+    //请求体要等后续数据，之后的读取可能让缓冲区扩容或腾挪，先把头部拷贝出来
+    if(state_ == BODY && !headerBlock_.empty()) {
+        header_.Detach(headerBlock_);
+        headerBlock_ = string_view();
+    }
+    if(state_ == FINISH) {
+        LOG_DEBUG("[%s], [%s], [%s]", method_.c_str(), path_.c_str(), version_.c_str());
+    }
+    return true;
+}
+
+//等请求行和全部头部都到达后一次解析完
+//头部直接引用缓冲区中的字节，这期间缓冲区不会扩容或腾挪
+bool HttpRequest::ParseHeaderBlock_(Buffer& buff) {
+    //忽略请求之间多余的空行
+    while(state_ == REQUEST_LINE && buff.ReadableBytes() >= 2 && buff.Peek()[0] == '\r' && buff.Peek()[1] == '\n') {
+        buff.Retrieve(2);
+    }
+    string_view data(buff.Peek(), buff.ReadableBytes());
+    size_t blockEnd = data.find("\r\n\r\n", headerScan_);
+    if(blockEnd == string_view::npos) {
+        if(data.size() > MAX_HEADER_SIZE) {
+            LOG_WARN("Request header too large");
+            return Fail_(431);
+        }
+        //头部还没收完，下次从这里接着找
+        headerScan_ = data.size() > 3 ? data.size() - 3 : 0;
+        state_ = HEADERS;
+        return true;
+    }
+    if(blockEnd + 4 > MAX_HEADER_SIZE) {
+        return Fail_(431);
+    }
+
+    string_view block = data.substr(0, blockEnd + 2);
+    size_t lineEnd = block.find("\r\n");
+    if(!ParseRequestLine_(block.substr(0, lineEnd))) {
+        return Fail_(400);
+    }
+    ParsePath_();
+    for(size_t pos = lineEnd + 2; pos < block.size(); pos = lineEnd + 2) {
+        lineEnd = block.find("\r\n", pos);
+        if(!ParseHeader_(block.substr(pos, lineEnd - pos))) {
+            return Fail_(400);
+        }
+    }
+    buff.Retrieve(blockEnd + 4);
+
+    keepAlive_ = PerfectHash::EqualsIgnoreCase(header_.Get(HttpHeader::CONNECTION), "keep-alive")
+                 && version_ == "1.1";
+    if(!BeginBody_()) {
+        return false;
+    }
+    headerBlock_ = block;
     return true;
 }
 
@@ -73,59 +139,232 @@ void HttpRequest::ParsePath_() {
     if(path_ == "/") {
         path_ = "/index.html"; 
     }
-    else {
-        //其他路径查表返回相应页面
-        for(auto &item: DEFAULT_HTML) {
-            if(item == path_) {
-                path_ += ".html";
-                break;
-            }
-        }
+    //其他路径查表返回相应页面
+    else if(const string_view* html = DEFAULT_HTML.Find(path_)) {
+        path_.assign(html->data(), html->size());
     }
 }
 
 //解析请求行
-bool HttpRequest::ParseRequestLine_(const string& line) {
-    //使用正则来匹配请求行
-    //匹配规则中，以括号()的方式来划分组别，实例中的规则共有两个括号，所以共有两组数据
-    regex patten("^([^ ]*) ([^ ]*) HTTP/([^ ]*)$");
-    //获得匹配结果放入subMatch数组
-    smatch subMatch;
-    if(regex_match(line, subMatch, patten)) {
-        //第一个是请求类型   
-        method_ = subMatch[1];
-        //第二个是请求路径
-        path_ = subMatch[2];
-        //第三个是请求HTTP的版本
-        version_ = subMatch[3];
-        //状态转移解析请求头部
-        state_ = HEADERS;
-        return true;
+//格式为 "方法 路径 HTTP/版本"，三段之间各有一个空格
+bool HttpRequest::ParseRequestLine_(string_view line) {
+    size_t methodEnd = line.find(' ');
+    size_t pathEnd = methodEnd == string_view::npos ? methodEnd : line.find(' ', methodEnd + 1);
+    if(pathEnd != string_view::npos) {
+        string_view version = line.substr(pathEnd + 1);
+        if(version.substr(0, 5) == "HTTP/" && version.find(' ') == string_view::npos) {
+            //第一个是请求类型
+            method_.assign(line.data(), methodEnd);
+            //第二个是请求路径
+            path_.assign(line.data() + methodEnd + 1, pathEnd - methodEnd - 1);
+            //第三个是请求HTTP的版本
+            version_.assign(version.data() + 5, version.size() - 5);
+            //状态转移解析请求头部
+            state_ = HEADERS;
+            return true;
+        }
     }
     LOG_ERROR("RequestLine Error");
     return false;
 }
 
 //解析请求头部
-void HttpRequest::ParseHeader_(const string& line) {
-    regex patten("^([^:]*): ?(.*)$");
-    smatch subMatch;
-    if(regex_match(line, subMatch, patten)) {
-        header_[subMatch[1]] = subMatch[2];
+//字段名和值只记录在缓冲区中的位置，常用字段放入固定槽位
+//Content-Length重复且值不同时请求体的边界有歧义，返回false
+bool HttpRequest::ParseHeader_(string_view line) {
+    size_t colon = line.find(':');
+    if(colon == string_view::npos) {
+        LOG_WARN("Header line without colon ignored");
+        return true;
     }
-    else {
-        //状态转移解析请求数据
-        state_ = BODY;
+    string_view name = line.substr(0, colon);
+    string_view value = line.substr(colon + 1);
+    while(!value.empty() && (value.front() == ' ' || value.front() == '\t')) { value.remove_prefix(1); }
+    while(!value.empty() && (value.back() == ' ' || value.back() == '\t')) { value.remove_suffix(1); }
+    if(HttpHeader::Lookup(name) == HttpHeader::CONTENT_LENGTH && header_.Has(HttpHeader::CONTENT_LENGTH)
+       && header_.Get(HttpHeader::CONTENT_LENGTH) != value) {
+        LOG_WARN("Conflicting Content-Length");
+        return false;
     }
+    header_.Add(name, value);
+    return true;
+}
+
+//根据头部决定请求体的长度和处理方式，都没有时视为没有请求体
+//同时带Transfer-Encoding和Content-Length的请求可能是请求走私，直接拒绝（RFC 9112 6.1）
+bool HttpRequest::BeginBody_() {
+    string_view transfer = header_.Get(HttpHeader::TRANSFER_ENCODING);
+    string_view length = header_.Get(HttpHeader::CONTENT_LENGTH);
+    if(!transfer.empty() && header_.Has(HttpHeader::CONTENT_LENGTH)) {
+        LOG_WARN("Request with both Transfer-Encoding and Content-Length");
+        return Fail_(400);
+    }
+    if(!transfer.empty()) {
+        if(!PerfectHash::EqualsIgnoreCase(transfer, "chunked")) {
+            return Fail_(400);
+        }
+        bodyMode_ = CHUNKED;
+    }
+    else if(!length.empty()) {
+        size_t len = 0;
+        for(char ch : length) {
+            if(ch < '0' || ch > '9' || len > MAX_BODY_SIZE) { return Fail_(len > MAX_BODY_SIZE ? 413 : 400); }
+            len = len * 10 + (ch - '0');
+        }
+        if(len > MAX_BODY_SIZE) {
+            LOG_WARN("Request body too large: %zu", len);
+            return Fail_(413);
+        }
+        bodyMode_ = len > 0 ? FIXED_LENGTH : NO_BODY;
+        bodyRemaining_ = len;
+    }
+    if(bodyMode_ == NO_BODY) {
+        return FinishBody_();
+    }
+
+    string_view expect = header_.Get(HttpHeader::EXPECT);
+    if(!expect.empty()) {
+        if(!PerfectHash::EqualsIgnoreCase(expect, "100-continue")) {
+            return Fail_(417);
+        }
+        expectContinue_ = (version_ == "1.1");
+    }
+
+    string_view type = header_.Get(HttpHeader::CONTENT_TYPE);
+    string_view boundary = MultipartParser::GetBoundary(type);
+    if(!boundary.empty()) {
+        bodyType_ = BODY_MULTIPART;
+        multipart_.Init(boundary);
+    }
+    else if(type == "application/x-www-form-urlencoded") {
+        bodyType_ = BODY_FORM;
+    }
+    state_ = BODY;
+    return true;
 }
 
 //解析请求数据
-//数据行不为空则是POST请求
-void HttpRequest::ParseBody_(const string& line) {
-    body_ = line;
+//按 Content-Length 或分块编码读取，读到的数据立即交给对应的处理方式，不在读缓冲区中堆积
+bool HttpRequest::ParseBody_(Buffer& buff) {
+    if(buff.ReadableBytes()) {
+        //已经开始收到请求体，不需要再发100 Continue
+        expectContinue_ = false;
+    }
+    if(bodyMode_ == CHUNKED) {
+        return ParseChunked_(buff);
+    }
+    size_t len = min(buff.ReadableBytes(), bodyRemaining_);
+    if(len > 0) {
+        if(!ConsumeBody_(buff.Peek(), len)) {
+            return false;
+        }
+        buff.Retrieve(len);
+        bodyRemaining_ -= len;
+    }
+    return bodyRemaining_ > 0 || FinishBody_();
+}
+
+//解析分块传输编码: 十六进制长度行、数据、CRLF，长度为0的分块后跟可选的尾部字段和空行
+bool HttpRequest::ParseChunked_(Buffer& buff) {
+    while(state_ == BODY && buff.ReadableBytes()) {
+        string_view data(buff.Peek(), buff.ReadableBytes());
+        if(chunkState_ == CHUNK_DATA) {
+            size_t len = min(data.size(), bodyRemaining_);
+            if(!ConsumeBody_(data.data(), len)) {
+                return false;
+            }
+            buff.Retrieve(len);
+            bodyRemaining_ -= len;
+            if(bodyRemaining_ == 0) { chunkState_ = CHUNK_DATA_CRLF; }
+            continue;
+        }
+        if(chunkState_ == CHUNK_DATA_CRLF) {
+            if(data.size() < 2) { break; }
+            if(data.compare(0, 2, "\r\n") != 0) { return Fail_(400); }
+            buff.Retrieve(2);
+            chunkState_ = CHUNK_SIZE;
+            continue;
+        }
+
+        //长度行和尾部字段都需要完整的一行
+        size_t lineEnd = data.find("\r\n");
+        if(lineEnd == string_view::npos) {
+            if(data.size() > MAX_HEADER_SIZE) { return Fail_(400); }
+            break;
+        }
+        string_view line = data.substr(0, lineEnd);
+        buff.Retrieve(lineEnd + 2);
+        if(chunkState_ == CHUNK_TRAILER) {
+            if(line.empty() && !FinishBody_()) {
+                return false;
+            }
+            continue;
+        }
+        //CHUNK_SIZE：忽略 ";" 之后的分块扩展
+        size_t size = 0;
+        line = line.substr(0, line.find(';'));
+        if(line.empty()) { return Fail_(400); }
+        for(char ch : line) {
+            int digit = ConverHex(ch);
+            if(ch >= '0' && ch <= '9') { digit = ch - '0'; }
+            else if(digit == ch) { return Fail_(400); }
+            size = size * 16 + digit;
+            if(size > MAX_BODY_SIZE) { return Fail_(413); }
+        }
+        bodyRemaining_ = size;
+        chunkState_ = size > 0 ? CHUNK_DATA : CHUNK_TRAILER;
+    }
+    return true;
+}
+
+//把一段请求体交给对应的处理方式
+bool HttpRequest::ConsumeBody_(const char* data, size_t len) {
+    bodyReceived_ += len;
+    if(bodyReceived_ > MAX_BODY_SIZE) {
+        return Fail_(413);
+    }
+    switch(bodyType_)
+    {
+    case BODY_FORM:
+        if(body_.size() + len > MAX_FORM_SIZE) {
+            return Fail_(413);
+        }
+        body_.append(data, len);
+        break;
+    case BODY_MULTIPART:
+        if(!multipart_.Feed(data, len)) {
+            return Fail_(code_ == 413 ? 413 : 400);
+        }
+        break;
+    default:
+        if(bodyHandler_ && !bodyHandler_(data, len)) {
+            return Fail_(400);
+        }
+        break;
+    }
+    return true;
+}
+
+//请求体接收完毕
+bool HttpRequest::FinishBody_() {
+    if(bodyType_ == BODY_MULTIPART && !multipart_.IsFinish()) {
+        LOG_WARN("Multipart body truncated");
+        return Fail_(400);
+    }
+    state_ = FINISH;
+    expectContinue_ = false;
     ParsePost_();
+    LOG_DEBUG("Body len:%zu, files:%zu", bodyReceived_, files_.size());
+    return true;
+}
+
+//解析失败，记录要返回的状态码；出错的连接不再保持
+bool HttpRequest::Fail_(int code) {
+    code_ = code;
+    keepAlive_ = false;
+    expectContinue_ = false;
     state_ = FINISH;
-    LOG_DEBUG("Body:%s, len:%d", line.c_str(), line.size());
+    return false;
 }
 
 //字母转为16进制数
@@ -135,33 +374,87 @@ int HttpRequest::ConverHex(char ch) {
     return ch;
 }
 
-//处理POST请求数据及登录注册问题
+//处理POST请求数据；登录注册等业务逻辑由路由处理函数完成
 void HttpRequest::ParsePost_() {
-    if(method_ == "POST" && header_["Content-Type"] == "application/x-www-form-urlencoded") {
+    if(method_ == "POST" && bodyType_ == BODY_FORM) {
         ParseFromUrlencoded_();
-        if(DEFAULT_HTML_TAG.count(path_)) {
-            int tag = DEFAULT_HTML_TAG.find(path_)->second;
-            LOG_DEBUG("Tag:%d", tag);
-            if(tag == 0 || tag == 1) {
-                //检查登录还是注册
-                bool isLogin = (tag == 1);
-                if(UserVerify(post_["username"], post_["password"], isLogin)) {
-                    path_ = "/welcome.html";
-                } 
-                else {
-                    path_ = "/error.html";
-                }
-            }
-        }
     }   
 }
 
+//multipart中的普通字段放入post_，文件写入临时文件
+bool HttpRequest::OnPartBegin_(const MultipartParser::Part& part) {
+    partValue_.clear();
+    if(!part.IsFile() || uploadHandler_) {
+        return true;
+    }
+    string tmpPath = string(UPLOAD_DIR) + "/webserver-upload-XXXXXX";
+    uploadFd_ = mkstemp(&tmpPath[0]);
+    if(uploadFd_ < 0) {
+        LOG_ERROR("Create upload file error: %s", tmpPath.c_str());
+        return false;
+    }
+    files_.push_back({ part.name, part.filename, part.contentType, tmpPath, 0 });
+    return true;
+}
+
+bool HttpRequest::OnPartData_(const MultipartParser::Part& part, const char* data, size_t len) {
+    if(!part.IsFile()) {
+        if(partValue_.size() + len > MAX_FORM_SIZE) {
+            code_ = 413;
+            return false;
+        }
+        partValue_.append(data, len);
+        return true;
+    }
+    if(uploadHandler_) {
+        return uploadHandler_(part, data, len);
+    }
+    while(len > 0) {
+        ssize_t n = ::write(uploadFd_, data, len);
+        if(n < 0) {
+            if(errno == EINTR) { continue; }
+            LOG_ERROR("Write upload file error: %d", errno);
+            return false;
+        }
+        data += n;
+        len -= n;
+        files_.back().size += n;
+    }
+    return true;
+}
+
+bool HttpRequest::OnPartEnd_(const MultipartParser::Part& part) {
+    if(!part.IsFile()) {
+        post_[std::pmr::string(part.name, mr_)] = partValue_;
+        return true;
+    }
+    if(uploadFd_ >= 0) {
+        close(uploadFd_);
+        uploadFd_ = -1;
+        LOG_INFO("Upload %s(%s) %zu bytes -> %s", files_.back().filename.c_str(),
+                 files_.back().contentType.c_str(), files_.back().size, files_.back().tmpPath.c_str());
+    }
+    return true;
+}
+
+//删除上一个请求留下的临时文件
+void HttpRequest::ClearUploads_() {
+    if(uploadFd_ >= 0) {
+        close(uploadFd_);
+        uploadFd_ = -1;
+    }
+    for(const UploadFile& file : files_) {
+        unlink(file.tmpPath.c_str());
+    }
+    files_.clear();
+}
+
 //解析POST请求数据
 void HttpRequest::ParseFromUrlencoded_() {
     //请求数据为空
     if(body_.size() == 0) { return; }
 
-    string key, value;
+    std::pmr::string key(mr_), value(mr_);
     int num = 0;
     int n = body_.size();
     int i = 0, j = 0;
@@ -171,7 +464,7 @@ void HttpRequest::ParseFromUrlencoded_() {
         char ch = body_[i];
         switch (ch) {
         case '=':
-            key = body_.substr(j, i - j);
+            key.assign(body_, j, i - j);
             j = i + 1;
             break;
         case '+':
@@ -184,7 +477,7 @@ void HttpRequest::ParseFromUrlencoded_() {
             i += 2;
             break;
         case '&':
-            value = body_.substr(j, i - j);
+            value.assign(body_, j, i - j);
             j = i + 1;
             post_[key] = value;
             LOG_DEBUG("%s = %s", key.c_str(), value.c_str());
@@ -195,103 +488,66 @@ void HttpRequest::ParseFromUrlencoded_() {
     }
     assert(j <= i);
     if(post_.count(key) == 0 && j < i) {
-        value = body_.substr(j, i - j);
+        value.assign(body_, j, i - j);
         post_[key] = value;
     }
 }
 
-//注册，登录请求解析
-bool HttpRequest::UserVerify(const string &name, const string &pwd, bool isLogin) {
-    if(name == "" || pwd == "") { return false; }
-    LOG_INFO("Verify name:%s pwd:%s", name.c_str(), pwd.c_str());
-    MYSQL* sql;
-    SqlConnRAII(&sql,  SqlConnPool::Instance());
-    assert(sql);
-    
-    bool flag = false;
-    unsigned int j = 0;
-    char order[256] = { 0 };
-    MYSQL_FIELD *fields = nullptr;
-    MYSQL_RES *res = nullptr;
-    
-    if(!isLogin) { flag = true; }
-    /* 查询用户及密码 */
-    snprintf(order, 256, "SELECT username, password FROM user WHERE username='%s' LIMIT 1", name.c_str());
-    LOG_DEBUG("%s", order);
-
-    if(mysql_query(sql, order)) { 
-        mysql_free_result(res);
-        return false; 
-    }
-    res = mysql_store_result(sql);
-    j = mysql_num_fields(res);
-    fields = mysql_fetch_fields(res);
-
-    while(MYSQL_ROW row = mysql_fetch_row(res)) {
-        LOG_DEBUG("MYSQL ROW: %s %s", row[0], row[1]);
-        string password(row[1]);
-        /* 登录行为 */
-        if(isLogin) {
-            if(pwd == password) { flag = true; }
-            else {
-                flag = false;
-                LOG_DEBUG("pwd error!");
-            }
-        } 
-        else {
-            //数据库中有结果但是注册行为 
-            flag = false; 
-            LOG_DEBUG("user used!");
-        }
-    }
-    mysql_free_result(res);
-
-    /* 注册行为 且 用户名未被使用*/
-    if(!isLogin && flag == true) {
-        LOG_DEBUG("regirster!");
-        bzero(order, 256);
-        snprintf(order, 256,"INSERT INTO user(username, password) VALUES('%s','%s')", name.c_str(), pwd.c_str());
-        LOG_DEBUG( "%s", order);
-        if(mysql_query(sql, order)) { 
-            LOG_DEBUG( "Insert error!");
-            flag = false; 
-        }
-        flag = true;
-    }
-    //手动释放数据库连接
-    SqlConnPool::Instance()->FreeConn(sql);
-    LOG_DEBUG( "UserVerify success!!");
-    return flag;
-}
-
-std::string HttpRequest::path() const{
+const std::pmr::string& HttpRequest::path() const{
     return path_;
 }
 
-std::string& HttpRequest::path(){
-    return path_;
-}
-std::string HttpRequest::method() const {
+const std::pmr::string& HttpRequest::method() const {
     return method_;
 }
 
-std::string HttpRequest::version() const {
+const std::pmr::string& HttpRequest::version() const {
     return version_;
 }
 
+string_view HttpRequest::GetParam(string_view name) const {
+    return params_.Get(name);
+}
+
+string_view HttpRequest::GetHeader(HttpHeader::HEADER_ID id) const {
+    return header_.Get(id);
+}
+
+string_view HttpRequest::GetHeader(string_view name) const {
+    return header_.Get(name);
+}
+
+//Cookie: a=1; b=2，逐段比较名字，不拆成表
+string_view HttpRequest::GetCookie(string_view name) const {
+    string_view cookies = header_.Get(HttpHeader::COOKIE);
+    while(!cookies.empty()) {
+        size_t end = cookies.find(';');
+        string_view pair = cookies.substr(0, end);
+        cookies = end == string_view::npos ? string_view() : cookies.substr(end + 1);
+        while(!pair.empty() && pair.front() == ' ') { pair.remove_prefix(1); }
+        size_t eq = pair.find('=');
+        if(eq != string_view::npos && pair.substr(0, eq) == name) {
+            return pair.substr(eq + 1);
+        }
+    }
+    return {};
+}
+
 //获取值
 std::string HttpRequest::GetPost(const std::string& key) const {
     assert(key != "");
-    if(post_.count(key) == 1) {
-        return post_.find(key)->second;
+    auto it = post_.find(std::pmr::string(key, mr_));
+    if(it != post_.end()) {
+        return std::string(it->second);
     }
     return "";
 }
 
 std::string HttpRequest::GetPost(const char* key) const {
     assert(key != nullptr);
-    if(post_.count(key) == 1) {
-        return post_.find(key)->second;
+    auto it = post_.find(std::pmr::string(key, mr_));
+    if(it != post_.end()) {
+        return std::string(it->second);
     }
     return "";
 }
\ No newline at end of file
@@ -7,16 +7,20 @@
 #define HTTP_REQUEST_H
 
 #include <unordered_map>
-#include <unordered_set>
+#include <memory_resource>
 #include <string>
-#include <regex>
+#include <string_view>
+#include <algorithm>
+#include <vector>
+#include <functional>
 #include <errno.h>     
-#include <mysql/mysql.h>  //mysql
 
 #include "../buffer/buffer.h"
 #include "../log/log.h"
-#include "../pool/sqlconnpool.h"
-#include "../pool/sqlconnRAII.h"
+#include "httpheader.h"
+#include "multipart.h"
+#include "router.h"
+#include "perfecthash.h"
 
 class HttpRequest {
 public:
@@ -40,48 +44,143 @@ public:
         CLOSED_CONNECTION,
     };
     
-    HttpRequest() { Init(); }
-    ~HttpRequest() = default;
+    //上传文件的信息，文件内容落盘到临时文件
+    struct UploadFile {
+        std::string name;
+        std::string filename;
+        std::string contentType;
+        std::string tmpPath;
+        size_t size;
+    };
+
+    // 设置后，上传文件的内容按块交给回调处理，不再写临时文件
+    typedef std::function<bool(const MultipartParser::Part& part, const char* data, size_t len)> UploadHandler;
+    // 设置后，非表单类型的请求体按块交给回调处理，否则丢弃
+    typedef std::function<bool(const char* data, size_t len)> BodyHandler;
 
+    // 解析过程中的字符串和容器都从mr分配，通常是连接持有的请求级内存区
+    explicit HttpRequest(std::pmr::memory_resource* mr = std::pmr::get_default_resource());
+    ~HttpRequest();
+
+    // 开始新请求，丢掉上一个请求在内存区上的全部存储
     void Init();
+    // 返回false表示请求有误，错误码由ErrorCode()给出；请求没收完时返回true且IsFinish()为false
     bool parse(Buffer& buff);
 
-    std::string path() const;
-    std::string& path();
-    std::string method() const;
-    std::string version() const;
+    bool IsFinish() const { return state_ == FINISH; }
+    // 还没有收到新请求的任何数据
+    bool IsIdle() const { return state_ == REQUEST_LINE; }
+    // 头部已收完，正在收请求体
+    bool InBody() const { return state_ == BODY; }
+    int ErrorCode() const { return code_; }
+
+    // 客户端带了 Expect: 100-continue 且还没开始发送请求体
+    bool ExpectContinue() const { return expectContinue_; }
+    void ContinueSent() { expectContinue_ = false; }
+
+    const std::pmr::string& path() const;
+    const std::pmr::string& method() const;
+    const std::pmr::string& version() const;
     std::string GetPost(const std::string& key) const;
     std::string GetPost(const char* key) const;
+    const std::vector<UploadFile>& files() const { return files_; }
+
+    // 路由匹配出的路径参数，值指向path_
+    RouteParams& params() { return params_; }
+    std::string_view GetParam(std::string_view name) const;
 
     bool IsKeepAlive() const;
 
+    // 头部的值指向读缓冲区，只在本次请求处理期间有效
+    std::string_view GetHeader(HttpHeader::HEADER_ID id) const;
+    std::string_view GetHeader(std::string_view name) const;
+    // Cookie头中名为name的值，没有时为空；同样指向读缓冲区
+    std::string_view GetCookie(std::string_view name) const;
+
+    void SetUploadHandler(const UploadHandler& handler) { uploadHandler_ = handler; }
+    void SetBodyHandler(const BodyHandler& handler) { bodyHandler_ = handler; }
+
     /* 
     todo 
-    void HttpConn::ParseFormData() {}
     void HttpConn::ParseJson() {}
     */
 
+    static const size_t MAX_HEADER_SIZE = 8 * 1024;         //请求行加头部的上限
+    static const size_t MAX_BODY_SIZE = 32 * 1024 * 1024;    //请求体上限
+    static const size_t MAX_FORM_SIZE = 64 * 1024;           //缓存在内存中的表单数据上限
+    static const char* UPLOAD_DIR;                           //上传文件的临时目录
+
 private:
+    //请求体的传输方式
+    enum BODY_MODE {
+        NO_BODY,
+        FIXED_LENGTH,
+        CHUNKED,
+    };
+
+    //分块传输的子状态
+    enum CHUNK_STATE {
+        CHUNK_SIZE,
+        CHUNK_DATA,
+        CHUNK_DATA_CRLF,
+        CHUNK_TRAILER,
+    };
+
+    //请求体的内容类型
+    enum BODY_TYPE {
+        BODY_OTHER,
+        BODY_FORM,
+        BODY_MULTIPART,
+    };
 
     //HTTP请求报文由请求行（request line）、请求头部（header）、空行和请求数据四个部分组成。
     //解析HTTP请求报文
-    bool ParseRequestLine_(const std::string& line);
-    void ParseHeader_(const std::string& line);
-    void ParseBody_(const std::string& line);
+    bool ParseHeaderBlock_(Buffer& buff);
+    bool ParseRequestLine_(std::string_view line);
+    bool ParseHeader_(std::string_view line);
+    bool BeginBody_();
+    bool ParseBody_(Buffer& buff);
+    bool ParseChunked_(Buffer& buff);
+    bool ConsumeBody_(const char* data, size_t len);
+    bool FinishBody_();
+    bool Fail_(int code);
 
     void ParsePath_();
     void ParsePost_();
     void ParseFromUrlencoded_();
 
-    static bool UserVerify(const std::string& name, const std::string& pwd, bool isLogin);
+    bool OnPartBegin_(const MultipartParser::Part& part);
+    bool OnPartData_(const MultipartParser::Part& part, const char* data, size_t len);
+    bool OnPartEnd_(const MultipartParser::Part& part);
+    void ClearUploads_();
 
     PARSE_STATE state_;
-    std::string method_, path_, version_, body_;
-    std::unordered_map<std::string, std::string> header_;
-    std::unordered_map<std::string, std::string> post_;
-
-    static const std::unordered_set<std::string> DEFAULT_HTML;
-    static const std::unordered_map<std::string, int> DEFAULT_HTML_TAG;
+    int code_;
+    bool keepAlive_;
+    bool expectContinue_;
+    std::pmr::memory_resource* mr_;
+    std::pmr::string method_, path_, version_, body_;
+    HttpHeader header_;
+    std::string_view headerBlock_;  //本次解析出的头部所在的原始字节
+    size_t headerScan_;     //上次查找头部结束符的位置，避免重复扫描
+
+    BODY_MODE bodyMode_;
+    BODY_TYPE bodyType_;
+    CHUNK_STATE chunkState_;
+    size_t bodyRemaining_;  //定长请求体或当前分块剩余的字节数
+    size_t bodyReceived_;
+
+    std::pmr::unordered_map<std::pmr::string, std::pmr::string> post_;
+    RouteParams params_;
+
+    MultipartParser multipart_;
+    std::pmr::string partValue_;     //当前普通表单字段的值
+    int uploadFd_;              //当前上传文件的临时文件
+    std::vector<UploadFile> files_;
+    UploadHandler uploadHandler_;
+    BodyHandler bodyHandler_;
+
+    static const PerfectHash::Map<std::string_view, std::string_view, 7> DEFAULT_HTML;
     static int ConverHex(char ch);
 };
 
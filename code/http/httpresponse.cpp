@@ -9,72 +9,113 @@ using namespace std;
 
 // HTTP响应也由四个部分组成，分别是：状态行、消息报头、空行和响应正文。
 
-////根据请求路径后缀得到返回文件类型
-const unordered_map<string, string> HttpResponse::SUFFIX_TYPE = {
-    { ".html",  "text/html" },
-    { ".xml",   "text/xml" },
-    { ".xhtml", "application/xhtml+xml" },
-    { ".txt",   "text/plain" },
-    { ".rtf",   "application/rtf" },
-    { ".pdf",   "application/pdf" },
-    { ".word",  "application/nsword" },
-    { ".png",   "image/png" },
-    { ".gif",   "image/gif" },
-    { ".jpg",   "image/jpeg" },
-    { ".jpeg",  "image/jpeg" },
-    { ".au",    "audio/basic" },
-    { ".mpeg",  "video/mpeg" },
-    { ".mpg",   "video/mpeg" },
-    { ".avi",   "video/x-msvideo" },
-    { ".gz",    "application/x-gzip" },
-    { ".tar",   "application/x-tar" },
-    { ".css",   "text/css "},
-    { ".js",    "text/javascript "},
-};
+////根据请求路径后缀得到返回文件类型，值为完整的Content-type头部
+constexpr PerfectHash::Map<string_view, string_view, 19> HttpResponse::SUFFIX_TYPE = PerfectHash::Make<string_view, string_view>({
+    { ".html",  "Content-type: text/html\r\n" },
+    { ".xml",   "Content-type: text/xml\r\n" },
+    { ".xhtml", "Content-type: application/xhtml+xml\r\n" },
+    { ".txt",   "Content-type: text/plain\r\n" },
+    { ".rtf",   "Content-type: application/rtf\r\n" },
+    { ".pdf",   "Content-type: application/pdf\r\n" },
+    { ".word",  "Content-type: application/nsword\r\n" },
+    { ".png",   "Content-type: image/png\r\n" },
+    { ".gif",   "Content-type: image/gif\r\n" },
+    { ".jpg",   "Content-type: image/jpeg\r\n" },
+    { ".jpeg",  "Content-type: image/jpeg\r\n" },
+    { ".au",    "Content-type: audio/basic\r\n" },
+    { ".mpeg",  "Content-type: video/mpeg\r\n" },
+    { ".mpg",   "Content-type: video/mpeg\r\n" },
+    { ".avi",   "Content-type: video/x-msvideo\r\n" },
+    { ".gz",    "Content-type: application/x-gzip\r\n" },
+    { ".tar",   "Content-type: application/x-tar\r\n" },
+    { ".css",   "Content-type: text/css\r\n" },
+    { ".js",    "Content-type: text/javascript\r\n" },
+});
 
 //响应中的状态码信息
-const unordered_map<int, string> HttpResponse::CODE_STATUS = {
-    { 200, "OK" },
-    { 400, "Bad Request" },
-    { 403, "Forbidden" },
-    { 404, "Not Found" },
-};
+constexpr PerfectHash::Map<int, HttpResponse::Status, 9> HttpResponse::CODE_STATUS = PerfectHash::Make<int, HttpResponse::Status>({
+    { 200, { "HTTP/1.1 200 OK\r\n",          "OK" } },
+    { 400, { "HTTP/1.1 400 Bad Request\r\n", "Bad Request" } },
+    { 401, { "HTTP/1.1 401 Unauthorized\r\n", "Unauthorized" } },
+    { 403, { "HTTP/1.1 403 Forbidden\r\n",   "Forbidden" } },
+    { 404, { "HTTP/1.1 404 Not Found\r\n",   "Not Found" } },
+    { 413, { "HTTP/1.1 413 Payload Too Large\r\n", "Payload Too Large" } },
+    { 417, { "HTTP/1.1 417 Expectation Failed\r\n", "Expectation Failed" } },
+    { 431, { "HTTP/1.1 431 Request Header Fields Too Large\r\n", "Request Header Fields Too Large" } },
+    { 503, { "HTTP/1.1 503 Service Unavailable\r\n", "Service Unavailable" } },
+});
 
 // 错误码信息
-const unordered_map<int, string> HttpResponse::CODE_PATH = {
+constexpr PerfectHash::Map<int, string_view, 7> HttpResponse::CODE_PATH = PerfectHash::Make<int, string_view>({
     { 400, "/400.html" },
     { 403, "/403.html" },
     { 404, "/404.html" },
-};
+    { 413, "/400.html" },
+    { 417, "/400.html" },
+    { 431, "/400.html" },
+    { 503, "/400.html" },
+});
 
-HttpResponse::HttpResponse() {
+HttpResponse::HttpResponse(std::pmr::memory_resource* mr): mr_(mr), path_(mr), filePath_(mr), content_(mr), headers_(mr) {
     code_ = -1;
-    path_ = srcDir_ = "";
     isKeepAlive_ = false;
     mmFile_ = nullptr; 
     mmFileStat_ = { 0 };
+    hasContent_ = false;
 };
 
 HttpResponse::~HttpResponse() {
     UnmapFile();
 }
 
-void HttpResponse::Init(const string& srcDir, string& path, bool isKeepAlive, int code){
-    assert(srcDir != "");
+void HttpResponse::Clear() {
+    //用swap丢掉旧存储，赋值会保留
+    for(std::pmr::string* str : { &path_, &filePath_, &content_, &headers_ }) {
+        std::pmr::string(mr_).swap(*str);
+    }
+    hasContent_ = false;
+}
+
+void HttpResponse::Init(string_view srcDir, string_view path, bool isKeepAlive, int code){
+    assert(!srcDir.empty());
     // 内存位置不为空，先释放内存
     if(mmFile_) { UnmapFile(); }
     code_ = code;
     isKeepAlive_ = isKeepAlive;
-    path_ = path;
+    path_.assign(path.data(), path.size());
     srcDir_ = srcDir;
     mmFile_ = nullptr; 
     mmFileStat_ = { 0 };
+    hasContent_ = false;
+    content_.clear();
+    headers_.clear();
+}
+
+void HttpResponse::SetContent(string_view content, string_view contentType) {
+    hasContent_ = true;
+    content_.assign(content.data(), content.size());
+    contentType_ = contentType;
+}
+
+void HttpResponse::AddHeader(string_view name, string_view value) {
+    headers_.append(name.data(), name.size()).append(": ");
+    headers_.append(value.data(), value.size()).append("\r\n");
 }
 
 // 生成响应报文
-void HttpResponse::MakeResponse(Buffer& buff) {
+void HttpResponse::MakeResponse(ChainBuffer& buff) {
+    /* 处理函数生成的内容，不对应文件 */
+    if(hasContent_) {
+        if(code_ == -1) { code_ = 200; }
+        AddStateLine_(buff);
+        AddHeader_(buff);
+        AddDynamicContent_(buff);
+        return;
+    }
+    /* 请求本身有误时直接返回错误页面，不再检查请求的文件 */
+    if(code_ >= 400) {}
     /* 判断请求的资源文件 */
-    if(stat((srcDir_ + path_).data(), &mmFileStat_) < 0 || S_ISDIR(mmFileStat_.st_mode)) {
+    else if(stat(FilePath_(), &mmFileStat_) < 0 || S_ISDIR(mmFileStat_.st_mode)) {
         code_ = 404;
     }
     else if(!(mmFileStat_.st_mode & S_IROTH)) {
@@ -100,67 +141,79 @@ size_t HttpResponse::FileLen() const {
 
 // 检查是否为错误码
 void HttpResponse::ErrorHtml_() {
-    if(CODE_PATH.count(code_) == 1) {
-        path_ = CODE_PATH.find(code_)->second;
+    if(const string_view* path = CODE_PATH.Find(code_)) {
+        path_.assign(path->data(), path->size());
 
         // stat函数用于取得指定文件的文件属性，并将文件属性存储在结构体stat里
         // 获取文件属性，存储在statbuf中
         // int stat(const char *pathname, struct stat *statbuf);
-        stat((srcDir_ + path_).data(), &mmFileStat_);
+        stat(FilePath_(), &mmFileStat_);
     }
 }
 
 //第一行为状态行，由HTTP协议版本号， 状态码， 状态消息 三部分组成
-void HttpResponse::AddStateLine_(Buffer& buff) {
-    string status;
-    if(CODE_STATUS.count(code_) == 1) {
-        status = CODE_STATUS.find(code_)->second;
-    }
-    else {
+void HttpResponse::AddStateLine_(ChainBuffer& buff) {
+    const Status* status = CODE_STATUS.Find(code_);
+    if(!status) {
         code_ = 400;
-        status = CODE_STATUS.find(400)->second;
+        status = CODE_STATUS.Find(400);
     }
     //HTTP响应添加状态行
-    buff.Append("HTTP/1.1 " + to_string(code_) + " " + status + "\r\n");
+    buff.Append(status->line);
 }
 
 //第二行和第三行为消息报头
-//消息报头主要包含MIME类型和编码类型
-void HttpResponse::AddHeader_(Buffer& buff) {
-    buff.Append("Connection: ");
+//消息报头主要包含MIME类型和编码类型；Date取自每秒刷新一次的共享缓存
+void HttpResponse::AddHeader_(ChainBuffer& buff) {
     if(isKeepAlive_) {
-        buff.Append("keep-alive\r\n");
-        buff.Append("keep-alive: max=6, timeout=120\r\n");
+        buff.Append("Connection: keep-alive\r\n"
+                    "keep-alive: max=6, timeout=120\r\n");
     } else{
-        buff.Append("close\r\n");
+        buff.Append("Connection: close\r\n");
     }
-    buff.Append("Content-type: " + GetFileType_() + "\r\n");
+    buff.Append(hasContent_ ? contentType_ : GetFileType_());
+    if(!headers_.empty()) { buff.Append(headers_); }
+    HttpDate::Append(buff);
+    buff.Append("Server: TinyWebServer\r\n");
 }
 
 //响应正文内容；添加文本content
-void HttpResponse::AddContent_(Buffer& buff) {
+void HttpResponse::AddContent_(ChainBuffer& buff) {
     //以只读的方式打开
-    int srcFd = open((srcDir_ + path_).data(), O_RDONLY);
+    int srcFd = open(FilePath_(), O_RDONLY);
     if(srcFd < 0) { 
         // "File NotFound!!!"
-        ErrorContent(buff,  srcDir_ + path_);
+        ErrorContent(buff, filePath_);
         return; 
     }
 
     /* 将文件映射到内存提高文件的访问速度 
         MAP_PRIVATE 建立一个写入时拷贝的私有映射*/
-    LOG_DEBUG("file path %s", (srcDir_ + path_).data());
+    LOG_DEBUG("file path %s", filePath_.c_str());
+
+    //空文件不需要映射（mmap长度为0会失败）
+    if(mmFileStat_.st_size == 0) {
+        close(srcFd);
+        AppendContentLength_(buff, 0);
+        return;
+    }
 
     // 用于将一个文件或其他对象映射到内存，提高文件的访问速度。
     // PROT_READ 表示页内容可以被读取；MAP_PRIVATE 建立一个写入时拷贝的私有映射，内存区域的写入不会影响到原文件
-    int* mmRet = (int*)mmap(0, mmFileStat_.st_size, PROT_READ, MAP_PRIVATE, srcFd, 0);
-    if(*mmRet == -1) {
+    void* mmRet = mmap(0, mmFileStat_.st_size, PROT_READ, MAP_PRIVATE, srcFd, 0);
+    close(srcFd);
+    if(mmRet == MAP_FAILED) {
+        mmFileStat_.st_size = 0;
         ErrorContent(buff, "File NotFound!!!!!");
         return; 
     }
     mmFile_ = (char*)mmRet;
-    close(srcFd);
-    buff.Append("Content-length: " + to_string(mmFileStat_.st_size) + "\r\n\r\n");
+    AppendContentLength_(buff, mmFileStat_.st_size);
+}
+
+void HttpResponse::AddDynamicContent_(ChainBuffer& buff) {
+    AppendContentLength_(buff, content_.size());
+    buff.Append(content_);
 }
 
 void HttpResponse::UnmapFile() {
@@ -173,37 +226,76 @@ void HttpResponse::UnmapFile() {
     }
 }
 
-string HttpResponse::GetFileType_() {
+string_view HttpResponse::GetFileType_() {
     /* 判断文件类型 */
 
-    //根据请求路径得到返回文件类型
+    //根据请求路径得到返回文件类型，后缀直接在path_上切片，不再拷贝
     string::size_type idx = path_.find_last_of('.');
-    if(idx == string::npos) {
-        return "text/plain";
+    if(idx != string::npos) {
+        if(const string_view* type = SUFFIX_TYPE.Find(string_view(path_).substr(idx))) {
+            return *type;
+        }
     }
-    string suffix = path_.substr(idx);
-    if(SUFFIX_TYPE.count(suffix) == 1) {
-        return SUFFIX_TYPE.find(suffix)->second;
-    }
-    return "text/plain";
+    return "Content-type: text/plain\r\n";
 }
 
 //response返回错误页面
-void HttpResponse::ErrorContent(Buffer& buff, string message) 
+//先算出正文长度写Content-length，再逐段追加正文，不拼接临时string
+void HttpResponse::ErrorContent(ChainBuffer& buff, string_view message) 
 {
-    string body;
-    string status;
-    body += "<html><title>Error</title>";
-    body += "<body bgcolor=\"ffffff\">";
-    if(CODE_STATUS.count(code_) == 1) {
-        status = CODE_STATUS.find(code_)->second;
+    const string_view head = "<html><title>Error</title><body bgcolor=\"ffffff\">";
+    const string_view tail = "<hr><em>TinyWebServer</em></body></html>";
+    string_view status = "Bad Request";
+    if(const Status* st = CODE_STATUS.Find(code_)) {
+        status = st->text;
+    }
+    char code[16];
+    size_t codeLen = snprintf(code, sizeof(code), "%d", code_);
+
+    size_t len = head.size() + codeLen + 3 + status.size() + 1 + 3 + message.size() + 4 + tail.size();
+    AppendContentLength_(buff, len);
+    buff.Append(head);
+    buff.Append(code, codeLen);
+    buff.Append(" : ");
+    buff.Append(status);
+    buff.Append("\n<p>");
+    buff.Append(message);
+    buff.Append("</p>");
+    buff.Append(tail);
+}
+
+//拼出文件的完整路径
+const char* HttpResponse::FilePath_() {
+    filePath_.assign(srcDir_.data(), srcDir_.size());
+    filePath_.append(path_);
+    return filePath_.c_str();
+}
+
+//两位一组查表转换，从低位往高位写入栈上的临时区域
+void HttpResponse::AppendNumber_(ChainBuffer& buff, size_t num) {
+    static const char DIGITS[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    char tmp[24];
+    char* p = tmp + sizeof(tmp);
+    while(num >= 100) {
+        size_t i = (num % 100) * 2;
+        num /= 100;
+        *--p = DIGITS[i + 1];
+        *--p = DIGITS[i];
+    }
+    if(num >= 10) {
+        *--p = DIGITS[num * 2 + 1];
+        *--p = DIGITS[num * 2];
     } else {
-        status = "Bad Request";
+        *--p = static_cast<char>('0' + num);
     }
-    body += to_string(code_) + " : " + status  + "\n";
-    body += "<p>" + message + "</p>";
-    body += "<hr><em>TinyWebServer</em></body></html>";
+    buff.Append(p, tmp + sizeof(tmp) - p);
+}
 
-    buff.Append("Content-length: " + to_string(body.size()) + "\r\n\r\n");
-    buff.Append(body);
+void HttpResponse::AppendContentLength_(ChainBuffer& buff, size_t len) {
+    buff.Append("Content-length: ");
+    AppendNumber_(buff, len);
+    buff.Append("\r\n\r\n");
 }
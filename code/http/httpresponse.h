@@ -6,50 +6,85 @@
 #ifndef HTTP_RESPONSE_H
 #define HTTP_RESPONSE_H
 
-#include <unordered_map>
+#include <string>
+#include <string_view>
+#include <memory_resource>
 #include <fcntl.h>       // open
 #include <unistd.h>      // close
 #include <sys/stat.h>    // stat
 #include <sys/mman.h>    // mmap, munmap
 
-#include "../buffer/buffer.h"
+#include "../buffer/chainbuffer.h"
 #include "../log/log.h"
+#include "perfecthash.h"
+#include "httpdate.h"
 
 class HttpResponse {
 public:
-    HttpResponse();
+    // 路径和动态内容从mr分配，通常是连接持有的请求级内存区
+    explicit HttpResponse(std::pmr::memory_resource* mr = std::pmr::get_default_resource());
     ~HttpResponse();
 
-    void Init(const std::string& srcDir, std::string& path, bool isKeepAlive = false, int code = -1);
-    void MakeResponse(Buffer& buff);
+    // 丢掉在内存区上的存储，内存区Reset之前调用
+    void Clear();
+    void Init(std::string_view srcDir, std::string_view path, bool isKeepAlive = false, int code = -1);
+    void MakeResponse(ChainBuffer& buff);
     void UnmapFile();
     char* File();
     size_t FileLen() const;
-    void ErrorContent(Buffer& buff, std::string message);
+    void ErrorContent(ChainBuffer& buff, std::string_view message);
     int Code() const { return code_; }
 
+    // 供路由处理函数修改响应：改为返回另一个文件，或直接返回动态生成的内容
+    void SetPath(std::string_view path) { path_.assign(path.data(), path.size()); }
+    void SetCode(int code) { code_ = code; }
+    // contentType 为完整的头部片段，如 "Content-type: application/json\r\n"，需为静态字符串
+    void SetContent(std::string_view content, std::string_view contentType);
+    // 追加一行响应头，如 AddHeader("Set-Cookie", "sid=...; Path=/")
+    void AddHeader(std::string_view name, std::string_view value);
+
 private:
-    void AddStateLine_(Buffer &buff);
-    void AddHeader_(Buffer &buff);
-    void AddContent_(Buffer &buff);
+    void AddStateLine_(ChainBuffer& buff);
+    void AddHeader_(ChainBuffer& buff);
+    void AddContent_(ChainBuffer& buff);
+    void AddDynamicContent_(ChainBuffer& buff);
 
     void ErrorHtml_();
-    std::string GetFileType_();
+    std::string_view GetFileType_();
+    const char* FilePath_();
+
+    //直接在缓冲区中格式化，不产生临时string
+    static void AppendNumber_(ChainBuffer& buff, size_t num);
+    static void AppendContentLength_(ChainBuffer& buff, size_t len);
 
     int code_;
     bool isKeepAlive_;
 
-    std::string path_;
-    std::string srcDir_;
+    std::pmr::memory_resource* mr_;
+    std::pmr::string path_;
+    std::string_view srcDir_;
+    std::pmr::string filePath_;  //srcDir_ + path_
+
+    bool hasContent_;   //是否为处理函数生成的动态内容
+    std::pmr::string content_;
+    std::string_view contentType_;
+    std::pmr::string headers_;  //处理函数追加的头部，已按报文格式拼好
     
     char* mmFile_; 
     // stat函数用于取得指定文件的文件属性，并将文件属性存储在结构体stat里
     // 主要包含文件类型和权限，文件大小和字节数
     struct stat mmFileStat_;
 
-    static const std::unordered_map<std::string, std::string> SUFFIX_TYPE;
-    static const std::unordered_map<int, std::string> CODE_STATUS;
-    static const std::unordered_map<int, std::string> CODE_PATH;
+    // 状态行与状态描述，状态行已按报文格式拼好
+    struct Status {
+        std::string_view line;
+        std::string_view text;
+    };
+
+    //编译期完美哈希表，值为拼好的头部片段，查表不分配内存
+    static const PerfectHash::Map<std::string_view, std::string_view, 19> SUFFIX_TYPE;
+    static const PerfectHash::Map<int, Status, 9> CODE_STATUS;
+    static const PerfectHash::Map<int, std::string_view, 7> CODE_PATH;
 };
 
 
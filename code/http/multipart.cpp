@@ -0,0 +1,198 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "multipart.h"
+#include "perfecthash.h"
+
+using namespace std;
+
+static string_view Trim(string_view s) {
+    while(!s.empty() && (s.front() == ' ' || s.front() == '\t')) { s.remove_prefix(1); }
+    while(!s.empty() && (s.back() == ' ' || s.back() == '\t')) { s.remove_suffix(1); }
+    return s;
+}
+
+static string_view Unquote(string_view s) {
+    if(s.size() >= 2 && s.front() == '"' && s.back() == '"') {
+        return s.substr(1, s.size() - 2);
+    }
+    return s;
+}
+
+// 在 "a; key=value; key2="value"" 这样的参数列表里查找参数值
+static string_view GetParam(string_view params, string_view key) {
+    while(!params.empty()) {
+        size_t semi = params.find(';');
+        string_view item = Trim(params.substr(0, semi));
+        params = semi == string_view::npos ? string_view() : params.substr(semi + 1);
+        size_t eq = item.find('=');
+        if(eq != string_view::npos && PerfectHash::EqualsIgnoreCase(Trim(item.substr(0, eq)), key)) {
+            return Unquote(Trim(item.substr(eq + 1)));
+        }
+    }
+    return string_view();
+}
+
+MultipartParser::MultipartParser() {
+    state_ = FINISH;
+}
+
+void MultipartParser::Init(string_view boundary) {
+    state_ = PREAMBLE;
+    delimiter_.assign("\r\n--");
+    delimiter_.append(boundary.data(), boundary.size());
+    carry_.clear();
+    part_ = Part();
+}
+
+void MultipartParser::SetCallBack(const PartCallBack& onBegin, const DataCallBack& onData, const PartCallBack& onEnd) {
+    onBegin_ = onBegin;
+    onData_ = onData;
+    onEnd_ = onEnd;
+}
+
+string_view MultipartParser::GetBoundary(string_view contentType) {
+    const string_view type = "multipart/form-data";
+    if(!PerfectHash::EqualsIgnoreCase(contentType.substr(0, type.size()), type)) {
+        return string_view();
+    }
+    string_view boundary = GetParam(contentType.substr(type.size()), "boundary");
+    // RFC 2046: boundary 长度为1~70
+    if(boundary.empty() || boundary.size() > 70) { return string_view(); }
+    return boundary;
+}
+
+// 喂入一段请求体
+// 有上次遗留的字节时，只补上判定它们所需的新数据开头（分隔符的长度，或一个分块头部的上限），
+// 遗留字节判定完后在调用方的内存上接着解析，只把新数据里无法判定的尾部拷贝到carry_
+bool MultipartParser::Feed(const char* data, size_t len) {
+    if(state_ == ERROR) { return false; }
+    while(!carry_.empty() && len > 0 && state_ != ERROR) {
+        size_t old = carry_.size();
+        size_t take = min(len, state_ == PART_HEADER ? MAX_PART_HEADER : delimiter_.size());
+        carry_.append(data, take);
+        size_t used = Parse_(carry_.data(), carry_.size());
+        if(used >= old) {
+            data += used - old;
+            len -= used - old;
+            carry_.clear();
+            break;
+        }
+        carry_.erase(0, used);
+        data += take;
+        len -= take;
+    }
+    if(carry_.empty() && state_ != ERROR) {
+        size_t used = Parse_(data, len);
+        carry_.assign(data + used, len - used);
+    }
+    if(state_ != ERROR && carry_.size() > MAX_PART_HEADER + delimiter_.size()) {
+        state_ = ERROR;
+    }
+    return state_ != ERROR;
+}
+
+// 返回已经确定归属的字节数，剩余字节要等更多数据才能判断
+size_t MultipartParser::Parse_(const char* data, size_t len) {
+    string_view in(data, len);
+    string_view dashBoundary = string_view(delimiter_).substr(2);
+    size_t pos = 0;
+    while(pos < len) {
+        switch(state_)
+        {
+        case PREAMBLE: {
+            //第一个分隔符之前的内容直接丢弃
+            size_t idx = in.find(dashBoundary, pos);
+            if(idx == string_view::npos) {
+                return len > dashBoundary.size() ? max(pos, len - dashBoundary.size() + 1) : pos;
+            }
+            pos = idx + dashBoundary.size();
+            state_ = BOUNDARY_TAIL;
+            break;
+        }
+        case BOUNDARY_TAIL:
+            //分隔符后跟"--"表示结束，跟CRLF表示下一个分块
+            if(len - pos < 2) { return pos; }
+            if(in.compare(pos, 2, "--") == 0) {
+                state_ = FINISH;
+                return len;
+            }
+            if(in.compare(pos, 2, "\r\n") != 0) {
+                state_ = ERROR;
+                return pos;
+            }
+            pos += 2;
+            state_ = PART_HEADER;
+            break;
+        case PART_HEADER: {
+            size_t idx = in.find("\r\n\r\n", pos);
+            if(idx == string_view::npos) {
+                if(len - pos > MAX_PART_HEADER) { state_ = ERROR; }
+                return pos;
+            }
+            if(!ParsePartHeader_(in.substr(pos, idx - pos)) || (onBegin_ && !onBegin_(part_))) {
+                state_ = ERROR;
+                return pos;
+            }
+            pos = idx + 4;
+            state_ = PART_DATA;
+            break;
+        }
+        case PART_DATA: {
+            size_t idx = in.find(delimiter_, pos);
+            //末尾可能是分隔符的前半段，先留着
+            size_t end = idx;
+            if(idx == string_view::npos) {
+                end = len > delimiter_.size() ? max(pos, len - delimiter_.size() + 1) : pos;
+            }
+            if(end > pos && onData_ && !onData_(part_, data + pos, end - pos)) {
+                state_ = ERROR;
+                return pos;
+            }
+            if(idx == string_view::npos) { return end; }
+            if(onEnd_ && !onEnd_(part_)) {
+                state_ = ERROR;
+                return pos;
+            }
+            pos = idx + delimiter_.size();
+            state_ = BOUNDARY_TAIL;
+            break;
+        }
+        case FINISH:
+            //结束分隔符之后的内容直接丢弃
+            return len;
+        default:
+            return pos;
+        }
+    }
+    return pos;
+}
+
+// 解析分块头部，取出 Content-Disposition 中的 name/filename 和 Content-Type
+bool MultipartParser::ParsePartHeader_(string_view block) {
+    part_ = Part();
+    bool hasDisposition = false;
+    while(!block.empty()) {
+        size_t lineEnd = block.find("\r\n");
+        string_view line = block.substr(0, lineEnd);
+        block = lineEnd == string_view::npos ? string_view() : block.substr(lineEnd + 2);
+
+        size_t colon = line.find(':');
+        if(colon == string_view::npos) { continue; }
+        string_view name = Trim(line.substr(0, colon));
+        string_view value = Trim(line.substr(colon + 1));
+        if(PerfectHash::EqualsIgnoreCase(name, "Content-Disposition")) {
+            string_view field = GetParam(value, "name");
+            string_view filename = GetParam(value, "filename");
+            part_.name.assign(field.data(), field.size());
+            part_.filename.assign(filename.data(), filename.size());
+            hasDisposition = true;
+        }
+        else if(PerfectHash::EqualsIgnoreCase(name, "Content-Type")) {
+            part_.contentType.assign(value.data(), value.size());
+        }
+    }
+    return hasDisposition;
+}
@@ -0,0 +1,67 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef MULTIPART_H
+#define MULTIPART_H
+
+#include <string>
+#include <string_view>
+#include <functional>
+
+// multipart/form-data 的流式解析器
+// 请求体可以分多次喂入，每个分块的数据一到就通过回调交出去，解析器自身只保留可能跨越边界的少量尾部字节
+class MultipartParser {
+public:
+    struct Part {
+        std::string name;
+        std::string filename;
+        std::string contentType;
+        bool IsFile() const { return !filename.empty(); }
+    };
+
+    // 回调返回false表示中止解析（如超出大小限制）
+    typedef std::function<bool(const Part& part)> PartCallBack;
+    typedef std::function<bool(const Part& part, const char* data, size_t len)> DataCallBack;
+
+    MultipartParser();
+    ~MultipartParser() = default;
+
+    void Init(std::string_view boundary);
+    void SetCallBack(const PartCallBack& onBegin, const DataCallBack& onData, const PartCallBack& onEnd);
+
+    bool Feed(const char* data, size_t len);
+
+    bool IsFinish() const { return state_ == FINISH; }
+    bool IsError() const { return state_ == ERROR; }
+
+    // 从Content-Type中取出boundary参数，没有时返回空
+    static std::string_view GetBoundary(std::string_view contentType);
+
+private:
+    enum PARSE_STATE {
+        PREAMBLE,
+        BOUNDARY_TAIL,
+        PART_HEADER,
+        PART_DATA,
+        FINISH,
+        ERROR,
+    };
+
+    size_t Parse_(const char* data, size_t len);
+    bool ParsePartHeader_(std::string_view block);
+
+    static const size_t MAX_PART_HEADER = 4096;
+
+    PARSE_STATE state_;
+    std::string delimiter_; // "\r\n--" + boundary
+    std::string carry_;     // 上一次没能确定归属的尾部字节
+    Part part_;
+
+    PartCallBack onBegin_;
+    DataCallBack onData_;
+    PartCallBack onEnd_;
+};
+
+#endif //MULTIPART_H
@@ -0,0 +1,122 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+// 编译期构建的完美哈希表
+// 构造时搜索一个让所有键落在不同槽位的种子，查表时只需一次哈希和一次比较
+// 全部在编译期完成：没有堆分配，也没有静态对象的动态初始化
+namespace PerfectHash {
+
+constexpr char ToLower(char ch) {
+    return (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch - 'A' + 'a') : ch;
+}
+
+// 忽略大小写比较（HTTP头部字段名不区分大小写）
+constexpr bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+    if(a.size() != b.size()) { return false; }
+    for(size_t i = 0; i < a.size(); i++) {
+        if(ToLower(a[i]) != ToLower(b[i])) { return false; }
+    }
+    return true;
+}
+
+// FNV-1a
+template<bool ICase>
+constexpr uint32_t Hash(std::string_view key, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for(char ch : key) {
+        h ^= static_cast<unsigned char>(ICase ? ToLower(ch) : ch);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+template<bool ICase>
+constexpr uint32_t Hash(int key, uint32_t seed) {
+    uint32_t h = static_cast<uint32_t>(key) ^ seed;
+    h *= 0x9E3779B1u;
+    return h ^ (h >> 15);
+}
+
+template<typename K, typename V>
+struct Entry {
+    K key{};
+    V value{};
+};
+
+template<typename K, typename V, size_t N, bool ICase = false>
+class Map {
+public:
+    static_assert(N > 0 && N < 0xFF, "PerfectHash::Map supports 1..254 entries");
+
+    constexpr explicit Map(const Entry<K, V> (&entries)[N]): entries_(), slots_(), seed_(0) {
+        for(size_t i = 0; i < N; i++) { entries_[i] = entries[i]; }
+        while(!TrySeed_(++seed_)) {
+            // 键重复时永远找不到种子，在编译期报错
+            if(seed_ > MAX_SEED) { throw "PerfectHash: duplicate keys"; }
+        }
+    }
+
+    constexpr const V* Find(const K& key) const {
+        uint8_t idx = slots_[Hash<ICase>(key, seed_) & (SLOTS - 1)];
+        if(idx == EMPTY || !KeyEquals_(entries_[idx].key, key)) { return nullptr; }
+        return &entries_[idx].value;
+    }
+
+    constexpr size_t size() const { return N; }
+    constexpr const Entry<K, V>* begin() const { return entries_.data(); }
+    constexpr const Entry<K, V>* end() const { return entries_.data() + N; }
+
+private:
+    // 槽位数取不小于2N的2的幂，装载率低于一半时很快就能找到种子
+    static constexpr size_t SlotCount_() {
+        size_t n = 1;
+        while(n < 2 * N) { n <<= 1; }
+        return n;
+    }
+    static constexpr size_t SLOTS = SlotCount_();
+    static constexpr uint8_t EMPTY = 0xFF;
+    static constexpr uint32_t MAX_SEED = 1u << 16;
+
+    static constexpr bool KeyEquals_(const K& a, const K& b) {
+        if constexpr(ICase && std::is_same<K, std::string_view>::value) {
+            return EqualsIgnoreCase(a, b);
+        } else {
+            return a == b;
+        }
+    }
+
+    constexpr bool TrySeed_(uint32_t seed) {
+        for(size_t i = 0; i < SLOTS; i++) { slots_[i] = EMPTY; }
+        for(size_t i = 0; i < N; i++) {
+            size_t slot = Hash<ICase>(entries_[i].key, seed) & (SLOTS - 1);
+            if(slots_[slot] != EMPTY) { return false; }
+            slots_[slot] = static_cast<uint8_t>(i);
+        }
+        return true;
+    }
+
+    std::array<Entry<K, V>, N> entries_;
+    std::array<uint8_t, SLOTS> slots_;
+    uint32_t seed_;
+};
+
+// 由初始化列表推导表的大小: auto m = PerfectHash::Make<K, V>({ {k, v}, ... });
+template<typename K, typename V, bool ICase = false, size_t N>
+constexpr Map<K, V, N, ICase> Make(const Entry<K, V> (&entries)[N]) {
+    return Map<K, V, N, ICase>(entries);
+}
+
+} // namespace PerfectHash
+
+#endif //PERFECT_HASH_H
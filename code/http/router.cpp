@@ -0,0 +1,171 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "router.h"
+#include "perfecthash.h"
+#include "../log/log.h"
+
+using namespace std;
+
+bool RouteParams::Push(string_view name, string_view value) {
+    if(cnt_ >= MAX_PARAMS) { return false; }
+    params_[cnt_++] = { name, value };
+    return true;
+}
+
+string_view RouteParams::Get(string_view name) const {
+    for(size_t i = 0; i < cnt_; i++) {
+        if(params_[i].first == name) { return params_[i].second; }
+    }
+    return string_view();
+}
+
+// 树节点：prefix为本节点对应的静态片段
+// 静态子节点按首字符索引，参数子节点和通配子节点各至多一个
+struct Router::Node {
+    string prefix;
+    string indices;
+    vector<unique_ptr<Node>> children;
+    unique_ptr<Node> param;
+    string paramName;
+    unique_ptr<Node> wildcard;
+    string wildcardName;
+    int route = -1;
+};
+
+Router::Router() = default;
+
+Router::~Router() = default;
+
+int Router::MethodIndex_(string_view method) {
+    static constexpr auto METHODS = PerfectHash::Make<string_view, METHOD>({
+        { "GET", GET }, { "POST", POST }, { "PUT", PUT }, { "DELETE", DELETE },
+        { "HEAD", HEAD }, { "PATCH", PATCH }, { "OPTIONS", OPTIONS },
+    });
+    const METHOD* m = METHODS.Find(method);
+    return m ? *m : -1;
+}
+
+void Router::Add(string_view method, string_view pattern, const Handler& handler,
+                 EXEC_POLICY policy, EXEC_LANE lane) {
+    assert(policy != ASYNC && lane < LANE_COUNT);
+    Insert_(method, pattern, { policy, lane, handler, nullptr });
+}
+
+void Router::AddAsync(string_view method, string_view pattern, const AsyncHandler& handler) {
+    Insert_(method, pattern, { ASYNC, LANE_IO, nullptr, handler });
+}
+
+//在调用线程开始执行，协程结束时调用done
+void Router::AddCo(string_view method, string_view pattern, const CoHandler& handler) {
+    AddAsync(method, pattern, [handler](HttpRequest& req, HttpResponse& resp, const DoneCallBack& done) {
+        handler(req, resp).Detach(done);
+    });
+}
+
+void Router::Insert_(string_view method, string_view pattern, Route route) {
+    int m = MethodIndex_(method);
+    assert(m >= 0 && !pattern.empty() && pattern[0] == '/');
+    if(!trees_[m]) {
+        trees_[m].reset(new Node());
+    }
+    routes_.push_back(move(route));
+    InsertNode_(trees_[m].get(), pattern, routes_.size() - 1);
+    LOG_DEBUG("Route %.*s %.*s", (int)method.size(), method.data(), (int)pattern.size(), pattern.data());
+}
+
+// pattern为去掉node前缀后剩余的部分
+void Router::InsertNode_(Node* node, string_view pattern, int routeIdx) {
+    if(pattern.empty()) {
+        //同一路径重复注册
+        assert(node->route < 0);
+        node->route = routeIdx;
+        return;
+    }
+    if(pattern[0] == ':') {
+        string_view name = pattern.substr(1, pattern.find('/') - 1);
+        if(!node->param) {
+            node->param.reset(new Node());
+            node->paramName.assign(name.data(), name.size());
+        }
+        //同一位置的参数名必须一致
+        assert(node->paramName == name);
+        InsertNode_(node->param.get(), pattern.substr(name.size() + 1), routeIdx);
+        return;
+    }
+    if(pattern[0] == '*') {
+        assert(!node->wildcard);
+        node->wildcard.reset(new Node());
+        node->wildcardName.assign(pattern.data() + 1, pattern.size() - 1);
+        node->wildcard->route = routeIdx;
+        return;
+    }
+
+    //静态片段，与已有子节点的公共前缀部分合并
+    string_view seg = pattern.substr(0, pattern.find_first_of(":*"));
+    size_t i = node->indices.find(seg[0]);
+    if(i == string::npos) {
+        node->indices.push_back(seg[0]);
+        node->children.emplace_back(new Node());
+        node->children.back()->prefix.assign(seg.data(), seg.size());
+        InsertNode_(node->children.back().get(), pattern.substr(seg.size()), routeIdx);
+        return;
+    }
+    Node* child = node->children[i].get();
+    size_t common = 0;
+    while(common < seg.size() && common < child->prefix.size() && seg[common] == child->prefix[common]) {
+        common++;
+    }
+    if(common < child->prefix.size()) {
+        //拆分子节点：公共前缀成为新的中间节点
+        unique_ptr<Node> mid(new Node());
+        mid->prefix = child->prefix.substr(0, common);
+        node->children[i]->prefix.erase(0, common);
+        mid->indices.push_back(node->children[i]->prefix[0]);
+        mid->children.push_back(move(node->children[i]));
+        node->children[i] = move(mid);
+        child = node->children[i].get();
+    }
+    InsertNode_(child, pattern.substr(common), routeIdx);
+}
+
+const Router::Route* Router::Match(string_view method, string_view path, RouteParams& params) const {
+    params.Clear();
+    int m = MethodIndex_(method);
+    if(m < 0 || !trees_[m]) {
+        return nullptr;
+    }
+    int idx = MatchNode_(trees_[m].get(), path, params);
+    return idx < 0 ? nullptr : &routes_[idx];
+}
+
+// 静态子节点优先，其次参数段，最后通配段；失败时回退并撤销已记录的参数
+int Router::MatchNode_(const Node* node, string_view path, RouteParams& params) {
+    if(path.empty() && node->route >= 0) {
+        return node->route;
+    }
+    if(!path.empty()) {
+        size_t i = node->indices.find(path[0]);
+        if(i != string::npos) {
+            const Node* child = node->children[i].get();
+            if(path.compare(0, child->prefix.size(), child->prefix) == 0) {
+                int idx = MatchNode_(child, path.substr(child->prefix.size()), params);
+                if(idx >= 0) { return idx; }
+            }
+        }
+    }
+    if(node->param) {
+        string_view seg = path.substr(0, path.find('/'));
+        if(!seg.empty() && params.Push(node->paramName, seg)) {
+            int idx = MatchNode_(node->param.get(), path.substr(seg.size()), params);
+            if(idx >= 0) { return idx; }
+            params.Pop();
+        }
+    }
+    if(node->wildcard && params.Push(node->wildcardName, path)) {
+        return node->wildcard->route;
+    }
+    return -1;
+}
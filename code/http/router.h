@@ -0,0 +1,107 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include <array>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <deque>
+
+#include "../pool/coroutine.h"
+
+class HttpRequest;
+class HttpResponse;
+
+// 路径参数，名字指向路由表，值指向请求路径；定长数组，匹配时不分配内存
+class RouteParams {
+public:
+    static const size_t MAX_PARAMS = 8;
+
+    RouteParams(): cnt_(0) {}
+
+    void Clear() { cnt_ = 0; }
+    bool Push(std::string_view name, std::string_view value);
+    void Pop() { if(cnt_) { cnt_--; } }
+    std::string_view Get(std::string_view name) const;
+    size_t size() const { return cnt_; }
+
+private:
+    std::array<std::pair<std::string_view, std::string_view>, MAX_PARAMS> params_;
+    size_t cnt_;
+};
+
+// 基于压缩前缀树（radix tree）的路由表，按请求方法分树
+// 支持静态路径、":name" 参数段和末尾的 "*name" 通配段，匹配优先级依次递减
+// 查找只沿路径走一遍，耗时与路径长度成正比；没有命中的请求按静态文件处理
+class Router {
+public:
+    //处理函数的执行方式
+    enum EXEC_POLICY {
+        INLINE,     //在解析请求的线程中直接执行
+        POOL,       //提交到lane指定的执行通道运行
+        ASYNC,      //处理函数自行安排执行，完成后调用done；协程处理函数也按此方式执行
+    };
+
+    //执行通道，各自有独立的线程和排队上限，一条通道拥塞不影响其他通道
+    enum EXEC_LANE {
+        LANE_IO,    //连接读写、请求解析和静态文件
+        LANE_DB,    //会阻塞在数据库上的处理
+        LANE_CPU,   //计算量大的处理
+        LANE_COUNT,
+    };
+
+    typedef std::function<void(HttpRequest& req, HttpResponse& resp)> Handler;
+    typedef std::function<void()> DoneCallBack;
+    typedef std::function<void(HttpRequest& req, HttpResponse& resp, const DoneCallBack& done)> AsyncHandler;
+    typedef std::function<CoTask<>(HttpRequest& req, HttpResponse& resp)> CoHandler;
+
+    struct Route {
+        EXEC_POLICY policy;
+        EXEC_LANE lane;
+        Handler handler;
+        AsyncHandler asyncHandler;
+    };
+
+    Router();
+    ~Router();
+
+    // pattern 形如 "/api/user/:name" 或 "/static/*file"；需在服务器开始处理请求前注册完
+    void Add(std::string_view method, std::string_view pattern, const Handler& handler,
+             EXEC_POLICY policy = INLINE, EXEC_LANE lane = LANE_CPU);
+    void AddAsync(std::string_view method, std::string_view pattern, const AsyncHandler& handler);
+    // 协程处理函数：co_await时挂起，不占线程，由reactor恢复；协程返回即处理完
+    void AddCo(std::string_view method, std::string_view pattern, const CoHandler& handler);
+
+    const Route* Match(std::string_view method, std::string_view path, RouteParams& params) const;
+
+private:
+    struct Node;
+
+    enum METHOD {
+        GET = 0,
+        POST,
+        PUT,
+        DELETE,
+        HEAD,
+        PATCH,
+        OPTIONS,
+        METHOD_COUNT,
+    };
+
+    static int MethodIndex_(std::string_view method);
+    void Insert_(std::string_view method, std::string_view pattern, Route route);
+    static void InsertNode_(Node* node, std::string_view pattern, int routeIdx);
+    static int MatchNode_(const Node* node, std::string_view path, RouteParams& params);
+
+    std::array<std::unique_ptr<Node>, METHOD_COUNT> trees_;
+    // deque追加元素时已有元素地址不变，Match返回的指针一直有效
+    std::deque<Route> routes_;
+};
+
+#endif //ROUTER_H
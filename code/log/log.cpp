@@ -4,6 +4,7 @@
  * @copyleft Apache 2.0
  */ 
 #include "log.h"
+#include "../pool/affinity.h"
 
 using namespace std;
 
@@ -46,6 +47,11 @@ void Log::SetLevel(int level) {
     level_ = level;
 }
 
+bool Log::PinWriter(const std::vector<int>& cpus) {
+    if(!writeThread_) { return false; }
+    return CpuAffinity::Pin(writeThread_->native_handle(), cpus);
+}
+
 //可选择的参数有日志等级、日志路径、最大行数以及最长日志条队列
 void Log::init(int level = 1, const char* path, const char* suffix,
     int maxQueueSize) {
@@ -151,6 +157,8 @@ void Log::write(int level, const char *format, ...) {
 
         //写入内容格式：时间 + 内容
         //时间格式化，snprintf成功返回写字符的总数，其中不包括结尾的null字符
+        //缓冲区的存储按需分配，写入前先确保有空间
+        buff_.EnsureWriteable(128);
         int n = snprintf(buff_.BeginWrite(), 128, "%d-%02d-%02d %02d:%02d:%02d.%06ld ",
                     t.tm_year + 1900, t.tm_mon + 1, t.tm_mday,
                     t.tm_hour, t.tm_min, t.tm_sec, now.tv_usec);
@@ -163,6 +171,13 @@ void Log::write(int level, const char *format, ...) {
         //内容格式化，用于向字符串中打印数据、数据格式用户自定义，返回写入到字符数组str中的字符个数(不包含终止符)
         int m = vsnprintf(buff_.BeginWrite(), buff_.WritableBytes(), format, vaList);
         va_end(vaList);
+        //空间不够时扩容后重新格式化
+        if(m >= 0 && static_cast<size_t>(m) >= buff_.WritableBytes()) {
+            buff_.EnsureWriteable(m + 1);
+            va_start(vaList, format);
+            m = vsnprintf(buff_.BeginWrite(), buff_.WritableBytes(), format, vaList);
+            va_end(vaList);
+        }
 
         buff_.HasWritten(m);
         buff_.Append("\n\0", 2);
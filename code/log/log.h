@@ -14,6 +14,7 @@
 #include <stdarg.h>           // vastart va_end
 #include <assert.h>
 #include <sys/stat.h>         //mkdir
+#include <vector>
 #include "blockqueue.h"
 #include "../buffer/buffer.h"
 
@@ -48,6 +49,9 @@ public:
     int GetLevel();
     void SetLevel(int level);
     bool IsOpen() { return isOpen_; }
+
+    // 把异步写线程限制在cpus上，同步模式下没有写线程，返回false
+    bool PinWriter(const std::vector<int>& cpus);
     
 private:
     Log();
@@ -11,10 +11,13 @@ int main() {
     daemon(1, 0); 
 
     WebServer server(
-        1316, 3, 60000, false,             /* 端口 ET模式 timeoutMs 优雅退出  */
+        1316, 3, 60000, false,             /* 端口 ET模式 长连接空闲超时ms 优雅退出  */
         3306, "root", "Zxk_1201", "serverdb", /* Mysql配置 */
-        12, 2, false, 1, 1024);             /* 连接池数量 线程池数量 日志开关 日志等级 日志异步队列容量 */
-    // 服务器为两核，线程池数量设为2；关闭日志防止I/O过高
+        12, 0, false, 1, 1024,              /* 连接池数量 线程池常驻线程数(0按CPU数) 日志开关 日志等级 日志异步队列容量 */
+        nullptr, nullptr, nullptr,          /* reactor、工作线程、日志写线程绑定的CPU列表，如"0-3,8"；nullptr不绑定 */
+        nullptr,                            /* 本机用户日志文件，如"./users.log"；nullptr使用Mysql */
+        nullptr);                           /* Mysql只读副本，如"10.0.0.2:3306,10.0.0.3:3306"；nullptr不做读写分离 */
+    // 线程池按CPU数起步，数据库调用阻塞导致排队时自动扩容；关闭日志防止I/O过高
     server.Start();
 } 
   
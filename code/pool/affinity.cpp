@@ -0,0 +1,142 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "affinity.h"
+
+#include <sched.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <algorithm>
+
+thread_local int CpuAffinity::currentNode_ = -1;
+
+std::vector<int> CpuAffinity::Parse(const char* spec) {
+    std::vector<int> cpus;
+    if(!spec) { return cpus; }
+    const char* p = spec;
+    while(*p && !isspace(static_cast<unsigned char>(*p))) {
+        char* end;
+        long first = strtol(p, &end, 10);
+        if(end == p || first < 0) { return {}; }
+        long last = first;
+        p = end;
+        if(*p == '-') {
+            last = strtol(p + 1, &end, 10);
+            if(end == p + 1 || last < first) { return {}; }
+            p = end;
+        }
+        if(last >= CPU_SETSIZE) { return {}; }
+        for(long cpu = first; cpu <= last; cpu++) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+        if(*p == ',') { p++; }
+        else if(*p && !isspace(static_cast<unsigned char>(*p))) { return {}; }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+//连续的CPU合并成区间
+std::string CpuAffinity::ToString(const std::vector<int>& cpus) {
+    std::string str;
+    for(size_t i = 0; i < cpus.size(); ) {
+        size_t j = i;
+        while(j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) { j++; }
+        if(!str.empty()) { str += ','; }
+        str += std::to_string(cpus[i]);
+        if(j > i) {
+            str += '-';
+            str += std::to_string(cpus[j]);
+        }
+        i = j + 1;
+    }
+    return str;
+}
+
+std::vector<int> CpuAffinity::Allowed() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if(sched_getaffinity(0, sizeof(set), &set) != 0) { return cpus; }
+    for(int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if(CPU_ISSET(cpu, &set)) { cpus.push_back(cpu); }
+    }
+    return cpus;
+}
+
+std::vector<int> CpuAffinity::Exclude(const std::vector<int>& cpus) {
+    std::vector<int> rest;
+    for(int cpu : Allowed()) {
+        if(!std::binary_search(cpus.begin(), cpus.end(), cpu)) { rest.push_back(cpu); }
+    }
+    return rest;
+}
+
+bool CpuAffinity::Pin(pthread_t thread, const std::vector<int>& cpus) {
+    if(cpus.empty()) { return false; }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+}
+
+bool CpuAffinity::PinSelf(const std::vector<int>& cpus) {
+    if(!Pin(pthread_self(), cpus)) { return false; }
+    currentNode_ = NodeOf(cpus[0]);
+    return true;
+}
+
+//下标为CPU编号，值为所在节点；只读一次
+const std::vector<int>& CpuAffinity::CpuNodes_() {
+    static const std::vector<int> nodes = [] {
+        std::vector<int> nodes;
+        DIR* dir = opendir("/sys/devices/system/node");
+        if(!dir) { return nodes; }
+        while(struct dirent* entry = readdir(dir)) {
+            int node;
+            if(sscanf(entry->d_name, "node%d", &node) != 1) { continue; }
+            char path[300];
+            snprintf(path, sizeof(path), "/sys/devices/system/node/%s/cpulist", entry->d_name);
+            FILE* fp = fopen(path, "r");
+            if(!fp) { continue; }
+            char line[4096] = {0};
+            if(fgets(line, sizeof(line), fp)) {
+                for(int cpu : Parse(line)) {
+                    if(static_cast<size_t>(cpu) >= nodes.size()) { nodes.resize(cpu + 1, 0); }
+                    nodes[cpu] = node;
+                }
+            }
+            fclose(fp);
+        }
+        closedir(dir);
+        return nodes;
+    }();
+    return nodes;
+}
+
+int CpuAffinity::NodeOf(int cpu) {
+    const std::vector<int>& nodes = CpuNodes_();
+    if(cpu < 0 || static_cast<size_t>(cpu) >= nodes.size()) { return 0; }
+    return nodes[cpu];
+}
+
+int CpuAffinity::NodeCount() {
+    const std::vector<int>& nodes = CpuNodes_();
+    if(nodes.empty()) { return 1; }
+    return *std::max_element(nodes.begin(), nodes.end()) + 1;
+}
+
+int CpuAffinity::CurrentNode() {
+    if(currentNode_ < 0) {
+        currentNode_ = NodeOf(sched_getcpu());
+    }
+    return currentNode_;
+}
@@ -0,0 +1,42 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <pthread.h>
+#include <vector>
+#include <string>
+
+// 线程绑核与NUMA节点查询
+// CPU集合用"0-3,8"这样的列表表示；节点拓扑从/sys/devices/system/node读取，读不到时所有CPU都算作节点0
+// 内存按“首次写入”落在写入线程所在的节点上，所以线程绑定后自己申请并初始化的内存就是本地内存
+class CpuAffinity {
+public:
+    // 解析CPU列表，格式错误返回空集合
+    static std::vector<int> Parse(const char* spec);
+    static std::string ToString(const std::vector<int>& cpus);
+
+    // 当前进程允许使用的CPU
+    static std::vector<int> Allowed();
+    // 在Allowed()中去掉cpus
+    static std::vector<int> Exclude(const std::vector<int>& cpus);
+
+    // 把线程限制在cpus上，cpus为空时不做任何事；失败返回false，线程保持原来的绑定
+    static bool Pin(pthread_t thread, const std::vector<int>& cpus);
+    static bool PinSelf(const std::vector<int>& cpus);
+
+    static int NodeOf(int cpu);
+    static int NodeCount();
+    // 调用线程所在的节点，PinSelf后按绑定的CPU确定，否则按首次调用时运行的CPU确定
+    static int CurrentNode();
+
+private:
+    static const std::vector<int>& CpuNodes_();
+    static thread_local int currentNode_;
+};
+
+#endif //AFFINITY_H
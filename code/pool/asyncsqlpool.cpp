@@ -0,0 +1,435 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "asyncsqlpool.h"
+#include "../log/log.h"
+
+#include <chrono>
+
+using namespace std;
+
+static int64_t NowMs() {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+AsyncSqlPool::AsyncSqlPool(): epoller_(nullptr), port_(0), connectTimeoutMs_(CONNECT_TIMEOUT_MS),
+    queryTimeoutMs_(QUERY_TIMEOUT_MS), timer_(nullptr), timerMs_(0) {}
+
+AsyncSqlPool::~AsyncSqlPool() {
+    Close();
+}
+
+AsyncSqlPool* AsyncSqlPool::Instance() {
+    static AsyncSqlPool pool;
+    return &pool;
+}
+
+//其他线程只往incoming_里放，队列由空变非空时唤醒reactor来取
+void AsyncSqlPool::Query(string sql, vector<string> params, Callback cb) {
+    if(!epoller_) {
+        SqlResult result;
+        result.error = "AsyncSqlPool unavailable";
+        cb(result);
+        return;
+    }
+    bool wake;
+    {
+        lock_guard<mutex> locker(mtx_);
+        wake = incoming_.empty();
+        incoming_.push_back({ move(sql), move(params), move(cb) });
+    }
+    if(wake) {
+        wakeup_.Post([this] { Drain_(); });
+    }
+}
+
+AsyncSqlPool::QueryAwaiter AsyncSqlPool::Query(string sql, vector<string> params) {
+    return QueryAwaiter(this, move(sql), move(params));
+}
+
+void AsyncSqlPool::Drain_() {
+    vector<Request> reqs;
+    {
+        lock_guard<mutex> locker(mtx_);
+        reqs.swap(incoming_);
+    }
+    int64_t deadline = NowMs() + queryTimeoutMs_;
+    for(Request& req : reqs) {
+        req.deadlineMs = deadline;
+        if(pending_.size() >= MAX_PENDING) {
+            SqlResult result;
+            result.error = "AsyncSqlPool busy";
+            req.cb(result);
+            continue;
+        }
+        pending_.push_back(move(req));
+    }
+    Dispatch_();
+}
+
+void AsyncSqlPool::FailPending_(const char* error) {
+    while(!pending_.empty()) {
+        Request req = move(pending_.front());
+        pending_.pop_front();
+        SqlResult result;
+        result.error = error;
+        req.cb(result);
+    }
+}
+
+#ifdef MYSQL_WAIT_READ
+
+bool AsyncSqlPool::Init(Epoller* epoller, TimingWheel* timer, const char* host, int port,
+                        const char* user, const char* pwd,
+                        const char* dbName, int connSize,
+                        int connectTimeoutMs, int queryTimeoutMs) {
+    assert(epoller && timer && connSize > 0);
+    epoller_ = epoller;
+    timer_ = timer;
+    connectTimeoutMs_ = connectTimeoutMs;
+    queryTimeoutMs_ = queryTimeoutMs;
+    host_ = host;
+    port_ = port;
+    user_ = user;
+    pwd_ = pwd;
+    dbName_ = dbName;
+    conns_.resize(connSize);
+    epoller_->AddFd(wakeup_.GetFd(), EPOLLIN);
+    for(Conn& conn : conns_) {
+        Connect_(conn);
+    }
+    return true;
+}
+
+void AsyncSqlPool::Connect_(Conn& conn) {
+    conn.connectMs = NowMs();
+    conn.sql = mysql_init(nullptr);
+    if(!conn.sql) {
+        LOG_ERROR("MySql init error!");
+        return;
+    }
+    mysql_options(conn.sql, MYSQL_OPT_NONBLOCK, 0);
+    MYSQL* ret = nullptr;
+    int status = mysql_real_connect_start(&ret, conn.sql, host_.c_str(), user_.c_str(), pwd_.c_str(),
+                                          dbName_.c_str(), port_, nullptr, 0);
+    conn.state = CONNECTING;
+    conn.fd = mysql_get_socket(conn.sql);
+    if(conn.fd >= 0) {
+        if(static_cast<size_t>(conn.fd) >= fdConn_.size()) { fdConn_.resize(conn.fd + 1, -1); }
+        fdConn_[conn.fd] = &conn - &conns_[0];
+        epoller_->AddFd(conn.fd, 0);
+    }
+    if(status) {
+        conn.deadlineMs = conn.connectMs + connectTimeoutMs_;
+        Arm_(conn.deadlineMs);
+        Watch_(conn, status);
+        return;
+    }
+    if(!ret) {
+        LOG_ERROR("MySql Connect error! %s", mysql_error(conn.sql));
+        Broken_(conn);
+        return;
+    }
+    conn.state = IDLE;
+}
+
+bool AsyncSqlPool::OnEvent(int fd, uint32_t events) {
+    if(!epoller_) { return false; }
+    if(fd == wakeup_.GetFd()) {
+        wakeup_.Run();
+        return true;
+    }
+    if(fd < 0 || static_cast<size_t>(fd) >= fdConn_.size() || fdConn_[fd] < 0) { return false; }
+    int ready = 0;
+    if(events & (EPOLLIN | EPOLLHUP | EPOLLERR)) { ready |= MYSQL_WAIT_READ; }
+    if(events & EPOLLOUT) { ready |= MYSQL_WAIT_WRITE; }
+    if(events & EPOLLPRI) { ready |= MYSQL_WAIT_EXCEPT; }
+    Advance_(conns_[fdConn_[fd]], ready);
+    return true;
+}
+
+//按当前状态调用对应的_cont接口，返回非0表示还要等fd
+void AsyncSqlPool::Advance_(Conn& conn, int ready) {
+    int status = 0;
+    switch(conn.state) {
+    case CONNECTING: {
+        MYSQL* ret = nullptr;
+        status = mysql_real_connect_cont(&ret, conn.sql, ready);
+        if(status) { break; }
+        if(!ret) {
+            LOG_ERROR("MySql Connect error! %s", mysql_error(conn.sql));
+            Broken_(conn);
+            return;
+        }
+        conn.state = IDLE;
+        Watch_(conn, 0);
+        Dispatch_();
+        return;
+    }
+    case QUERYING: {
+        int err = 0;
+        status = mysql_real_query_cont(&err, conn.sql, ready);
+        if(status) { break; }
+        AfterQuery_(conn, err);
+        return;
+    }
+    case STORING: {
+        MYSQL_RES* res = nullptr;
+        status = mysql_store_result_cont(&res, conn.sql, ready);
+        if(status) { break; }
+        AfterStore_(conn, res);
+        return;
+    }
+    default:
+        //空闲连接上有事件说明服务端断开了
+        Broken_(conn);
+        Dispatch_();
+        return;
+    }
+    Watch_(conn, status);
+}
+
+//转义只按连接的字符集处理，不访问网络
+string AsyncSqlPool::Bind_(MYSQL* sql, const string& text, const vector<string>& params) {
+    string order;
+    size_t next = 0;
+    for(char ch : text) {
+        if(ch != '?' || next == params.size()) {
+            order += ch;
+            continue;
+        }
+        const string& param = params[next++];
+        size_t start = order.size();
+        order.resize(start + param.size() * 2 + 1);
+        unsigned long len = mysql_real_escape_string(sql, &order[start], param.data(), param.size());
+        order.resize(start + len);
+        order.insert(order.begin() + start, '\'');
+        order += '\'';
+    }
+    return order;
+}
+
+void AsyncSqlPool::StartQuery_(Conn& conn) {
+    conn.state = QUERYING;
+    conn.deadlineMs = conn.req.deadlineMs;
+    Arm_(conn.deadlineMs);
+    if(!conn.req.params.empty()) {
+        conn.req.sql = Bind_(conn.sql, conn.req.sql, conn.req.params);
+    }
+    int err = 0;
+    int status = mysql_real_query_start(&err, conn.sql, conn.req.sql.data(), conn.req.sql.size());
+    if(status) {
+        Watch_(conn, status);
+        return;
+    }
+    AfterQuery_(conn, err);
+}
+
+void AsyncSqlPool::AfterQuery_(Conn& conn, int err) {
+    if(err) {
+        Fail_(conn, mysql_error(conn.sql));
+        return;
+    }
+    //没有结果集的语句（INSERT等）只取影响的行数
+    if(mysql_field_count(conn.sql) == 0) {
+        SqlResult result;
+        result.ok = true;
+        result.affectedRows = mysql_affected_rows(conn.sql);
+        Finish_(conn, result);
+        return;
+    }
+    conn.state = STORING;
+    MYSQL_RES* res = nullptr;
+    int status = mysql_store_result_start(&res, conn.sql);
+    if(status) {
+        Watch_(conn, status);
+        return;
+    }
+    AfterStore_(conn, res);
+}
+
+//结果集已经全部读到本地，取行不会再访问网络
+void AsyncSqlPool::AfterStore_(Conn& conn, MYSQL_RES* res) {
+    if(!res) {
+        Fail_(conn, mysql_error(conn.sql));
+        return;
+    }
+    SqlResult result;
+    result.ok = true;
+    unsigned int fields = mysql_num_fields(res);
+    result.rows.reserve(mysql_num_rows(res));
+    while(MYSQL_ROW row = mysql_fetch_row(res)) {
+        unsigned long* lengths = mysql_fetch_lengths(res);
+        result.rows.emplace_back(fields);
+        for(unsigned int i = 0; i < fields; i++) {
+            if(row[i]) { result.rows.back()[i].assign(row[i], lengths[i]); }
+        }
+    }
+    mysql_free_result(res);
+    Finish_(conn, result);
+}
+
+void AsyncSqlPool::Finish_(Conn& conn, SqlResult& result) {
+    Request req = move(conn.req);
+    conn.req = Request();
+    conn.state = IDLE;
+    Watch_(conn, 0);
+    req.cb(result);
+    Dispatch_();
+}
+
+//连接层面的错误（断线、超时）之后连接不能再用，关掉等下次重连
+void AsyncSqlPool::Fail_(Conn& conn, const char* error) {
+    unsigned int err = mysql_errno(conn.sql);
+    LOG_WARN("AsyncSqlPool query error: %s", error);
+    SqlResult result;
+    result.error = error;
+    Request req = move(conn.req);
+    conn.req = Request();
+    if(err == 2006 || err == 2013) {   //CR_SERVER_GONE_ERROR, CR_SERVER_LOST
+        Broken_(conn);
+    } else {
+        conn.state = IDLE;
+        Watch_(conn, 0);
+    }
+    req.cb(result);
+    Dispatch_();
+}
+
+void AsyncSqlPool::Broken_(Conn& conn, const char* error) {
+    if(conn.fd >= 0) {
+        epoller_->DelFd(conn.fd);
+        fdConn_[conn.fd] = -1;
+        conn.fd = -1;
+    }
+    if(conn.sql) {
+        mysql_close(conn.sql);
+        conn.sql = nullptr;
+    }
+    conn.state = DISCONNECTED;
+    if(conn.req.cb) {
+        Request req = move(conn.req);
+        conn.req = Request();
+        SqlResult result;
+        result.error = error;
+        req.cb(result);
+    }
+}
+
+//定时节点只会提前不会推后；到期时已经完成的查询不影响，重新按剩下的最早截止时间设置
+void AsyncSqlPool::Arm_(int64_t deadlineMs) {
+    if(timerEntry_.Pending() && timerMs_ <= deadlineMs) { return; }
+    timerMs_ = deadlineMs;
+    timer_->add(&timerEntry_, static_cast<int>(max<int64_t>(deadlineMs - NowMs(), 0)), &AsyncSqlPool::OnTimer_, this);
+}
+
+void AsyncSqlPool::OnTimer_(void* pool, void*) {
+    static_cast<AsyncSqlPool*>(pool)->Expire_();
+}
+
+//超时的连接直接关掉：客户端库的句柄停在半途的操作上不能再用
+//查询超时说明不了数据库不可用，马上重连；连接超时则按RECONNECT_MS重连
+//排队的查询按到达顺序排列，截止时间也是递增的
+void AsyncSqlPool::Expire_() {
+    int64_t now = NowMs();
+    for(Conn& conn : conns_) {
+        if(conn.state != CONNECTING && conn.state != QUERYING && conn.state != STORING) { continue; }
+        if(conn.deadlineMs > now) { continue; }
+        if(conn.state == CONNECTING) {
+            LOG_WARN("AsyncSqlPool connect timeout");
+            Broken_(conn);
+        } else {
+            LOG_WARN("AsyncSqlPool query timeout: %s", conn.req.sql.c_str());
+            Broken_(conn, "query timeout");
+            Connect_(conn);
+        }
+    }
+    while(!pending_.empty() && pending_.front().deadlineMs <= now) {
+        Request req = move(pending_.front());
+        pending_.pop_front();
+        SqlResult result;
+        result.error = "query timeout";
+        req.cb(result);
+    }
+    Dispatch_();
+
+    //回调和Dispatch_可能已经设置了定时节点，这里只会把它提前
+    for(const Conn& conn : conns_) {
+        if(conn.state == CONNECTING || conn.state == QUERYING || conn.state == STORING) {
+            Arm_(conn.deadlineMs);
+        }
+    }
+}
+
+//空闲时只留错误和挂断事件（epoll总会报告），用来发现服务端断开
+void AsyncSqlPool::Watch_(Conn& conn, int status) {
+    uint32_t events = 0;
+    if(status & MYSQL_WAIT_READ) { events |= EPOLLIN; }
+    if(status & MYSQL_WAIT_WRITE) { events |= EPOLLOUT; }
+    if(status & MYSQL_WAIT_EXCEPT) { events |= EPOLLPRI; }
+    epoller_->ModFd(conn.fd, events);
+}
+
+//按先来先服务把排队的查询交给空闲连接；断开的连接按间隔重连，全部不可用时让排队的查询失败
+void AsyncSqlPool::Dispatch_() {
+    bool usable = false;
+    int64_t now = NowMs();
+    for(Conn& conn : conns_) {
+        if(conn.state == DISCONNECTED && !pending_.empty() && now - conn.connectMs >= RECONNECT_MS) {
+            Connect_(conn);
+        }
+        if(conn.state == IDLE && !pending_.empty()) {
+            conn.req = move(pending_.front());
+            pending_.pop_front();
+            StartQuery_(conn);
+        }
+        usable = usable || conn.state != DISCONNECTED;
+    }
+    if(!usable) {
+        FailPending_("database unavailable");
+    }
+    //还在排队的查询也有截止时间
+    if(!pending_.empty()) {
+        Arm_(pending_.front().deadlineMs);
+    }
+}
+
+void AsyncSqlPool::Close() {
+    if(!epoller_) { return; }
+    timer_->cancel(&timerEntry_);
+    for(Conn& conn : conns_) {
+        Broken_(conn);
+    }
+    {
+        lock_guard<mutex> locker(mtx_);
+        for(Request& req : incoming_) {
+            pending_.push_back(move(req));
+        }
+        incoming_.clear();
+    }
+    FailPending_("AsyncSqlPool closed");
+    epoller_->DelFd(wakeup_.GetFd());
+    epoller_ = nullptr;
+}
+
+#else
+
+// 客户端库没有非阻塞接口
+bool AsyncSqlPool::Init(Epoller*, TimingWheel*, const char*, int, const char*, const char*, const char*, int, int, int) {
+    LOG_INFO("MySql client has no non-blocking API, AsyncSqlPool disabled");
+    return false;
+}
+
+bool AsyncSqlPool::OnEvent(int, uint32_t) {
+    return false;
+}
+
+void AsyncSqlPool::Dispatch_() {
+    FailPending_("AsyncSqlPool unsupported");
+}
+
+void AsyncSqlPool::Close() {}
+
+#endif
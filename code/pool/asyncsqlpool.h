@@ -0,0 +1,159 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef ASYNC_SQL_POOL_H
+#define ASYNC_SQL_POOL_H
+
+#include <mysql/mysql.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <functional>
+
+#include "../server/epoller.h"
+#include "../server/completionqueue.h"
+#include "../timer/timingwheel.h"
+#include "coroutine.h"
+
+// 查询结果，字段值都拷贝成字符串，NULL为空串
+struct SqlResult {
+    bool ok = false;
+    std::string error;
+    std::vector<std::vector<std::string>> rows;
+    uint64_t affectedRows = 0;
+};
+
+// 非阻塞的数据库连接池，所有连接都由reactor线程驱动
+// 连接、查询、取结果用客户端库的非阻塞接口（mysql_real_query_start/_cont等）分步执行，
+// 连接的socket注册到Epoller，可读写时继续下一步；等待数据库期间不占用任何线程，几条连接就能让大量查询排队执行
+// 每个查询从reactor取到起queryTimeoutMs内没完成（含排队）就以失败回调，正在执行的连接断开重连；建立连接另有超时
+// 客户端库没有非阻塞接口（MariaDB Connector/C提供）时Init返回false，使用方改用SqlConnPool
+class AsyncSqlPool {
+public:
+    typedef std::function<void(SqlResult& result)> Callback;
+    class QueryAwaiter;
+
+    //局部静态变量单例模式
+    static AsyncSqlPool* Instance();
+
+    static const int CONNECT_TIMEOUT_MS = 3000;
+    static const int QUERY_TIMEOUT_MS = 5000;
+
+    // 在reactor线程调用，开始建立connSize条连接，不等待连接完成；超时由同一线程的时间轮timer驱动
+    bool Init(Epoller* epoller, TimingWheel* timer, const char* host, int port,
+              const char* user, const char* pwd,
+              const char* dbName, int connSize,
+              int connectTimeoutMs = CONNECT_TIMEOUT_MS, int queryTimeoutMs = QUERY_TIMEOUT_MS);
+
+    // 任意线程调用；cb在reactor线程执行，应尽快返回；Init没有成功时直接在调用线程以失败回调
+    // sql中的?依次换成params，按连接的字符集转义并加引号，语句中的?都视为参数
+    void Query(std::string sql, std::vector<std::string> params, Callback cb);
+    // 协程中使用：SqlResult result = co_await AsyncSqlPool::Instance()->Query(sql, { name });
+    QueryAwaiter Query(std::string sql, std::vector<std::string> params = {});
+
+    // reactor线程收到事件时调用，fd不属于连接池时返回false
+    bool OnEvent(int fd, uint32_t events);
+
+    // 关闭所有连接，排队的查询以失败回调
+    void Close();
+
+private:
+    AsyncSqlPool();
+    ~AsyncSqlPool();
+
+    enum STATE {
+        DISCONNECTED,
+        CONNECTING,
+        IDLE,
+        QUERYING,   //发送查询、等待执行结果
+        STORING,    //读取结果集
+    };
+
+    struct Request {
+        std::string sql;
+        std::vector<std::string> params;
+        Callback cb;
+        int64_t deadlineMs = 0;
+    };
+
+    struct Conn {
+        MYSQL* sql = nullptr;
+        int fd = -1;
+        STATE state = DISCONNECTED;
+        Request req;
+        int64_t connectMs = 0;  //上次开始连接的时间，断线后限制重连频率
+        int64_t deadlineMs = 0; //正在进行的连接或查询的截止时间
+    };
+
+    static const size_t MAX_PENDING = 1024;    //排队上限，超过后直接失败
+    static const int RECONNECT_MS = 1000;
+
+    void Connect_(Conn& conn);
+    void Advance_(Conn& conn, int ready);
+    void StartQuery_(Conn& conn);
+    static std::string Bind_(MYSQL* sql, const std::string& text, const std::vector<std::string>& params);
+    void AfterQuery_(Conn& conn, int err);
+    void AfterStore_(Conn& conn, MYSQL_RES* res);
+    void Finish_(Conn& conn, SqlResult& result);
+    void Fail_(Conn& conn, const char* error);
+    void Broken_(Conn& conn, const char* error = "connection lost");
+    void Arm_(int64_t deadlineMs);
+    void Expire_();
+    static void OnTimer_(void* pool, void*);
+    void Watch_(Conn& conn, int status);
+    void Drain_();
+    void Dispatch_();
+    void FailPending_(const char* error);
+
+    Epoller* epoller_;
+    std::string host_, user_, pwd_, dbName_;
+    int port_;
+    int connectTimeoutMs_;
+    int queryTimeoutMs_;
+
+    TimingWheel* timer_;
+    TimerEntry timerEntry_;     // 按最早的截止时间设置，到期后检查所有连接和排队的查询
+    int64_t timerMs_;           // timerEntry_的到期时刻
+
+    std::vector<Conn> conns_;
+    std::vector<int> fdConn_;       // 下标为fd，值为conns_下标，-1表示不是连接池的fd
+    std::deque<Request> pending_;   // 等待空闲连接的查询，只在reactor线程访问
+
+    std::mutex mtx_;
+    std::vector<Request> incoming_; // 其他线程投递、reactor还没取走的查询
+    CompletionQueue wakeup_;
+};
+
+// 查询完成后协程在reactor线程恢复
+class AsyncSqlPool::QueryAwaiter {
+public:
+    QueryAwaiter(AsyncSqlPool* pool, std::string sql, std::vector<std::string> params):
+        pool_(pool), sql_(std::move(sql)), params_(std::move(params)) {}
+
+    //连接池不可用时不挂起，直接返回失败
+    bool await_ready() {
+        if(pool_->epoller_) { return false; }
+        result_.error = "AsyncSqlPool unavailable";
+        return true;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        pool_->Query(std::move(sql_), std::move(params_), [this, resumer = CoResumer(handle)](SqlResult& result) {
+            result_ = std::move(result);
+            resumer();
+        });
+    }
+
+    SqlResult await_resume() { return std::move(result_); }
+
+private:
+    AsyncSqlPool* pool_;
+    std::string sql_;
+    std::vector<std::string> params_;
+    SqlResult result_;
+};
+
+#endif //ASYNC_SQL_POOL_H
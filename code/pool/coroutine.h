@@ -0,0 +1,162 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory_resource>
+#include <optional>
+#include <utility>
+#include <assert.h>
+
+// 协程帧从哪里分配：处理请求的协程用所属连接的内存区，请求结束时随内存区一起回收
+// 启动协程和每次恢复前由CoFrameScope设置，作用域内新建的协程帧都从这里分配；没有设置时用全局堆
+class CoFrameScope {
+public:
+    explicit CoFrameScope(std::pmr::memory_resource* mr): prev_(current_) { current_ = mr; }
+    ~CoFrameScope() { current_ = prev_; }
+
+    CoFrameScope(const CoFrameScope&) = delete;
+    CoFrameScope& operator=(const CoFrameScope&) = delete;
+
+    static std::pmr::memory_resource* Current() { return current_; }
+
+private:
+    std::pmr::memory_resource* prev_;
+    static inline thread_local std::pmr::memory_resource* current_ = nullptr;
+};
+
+// 在别的线程恢复协程：记下挂起时的帧来源，恢复时重新设置
+// 只有两个指针，可以放进Task
+class CoResumer {
+public:
+    CoResumer(): mr_(nullptr) {}
+    explicit CoResumer(std::coroutine_handle<> handle): handle_(handle), mr_(CoFrameScope::Current()) {}
+
+    void operator()() const {
+        CoFrameScope scope(mr_);
+        handle_.resume();
+    }
+
+private:
+    std::coroutine_handle<> handle_;
+    std::pmr::memory_resource* mr_;
+};
+
+// 所有CoTask共用的promise部分：帧分配、挂起点和结束后的去向
+struct CoPromiseBase {
+    // 帧前面留一个头记下来源，释放时还给同一处
+    static const size_t HEADER = alignof(std::max_align_t);
+
+    static void* operator new(size_t size) {
+        std::pmr::memory_resource* mr = CoFrameScope::Current();
+        void* mem = mr ? mr->allocate(size + HEADER, HEADER) : ::operator new(size + HEADER);
+        *static_cast<std::pmr::memory_resource**>(mem) = mr;
+        return static_cast<char*>(mem) + HEADER;
+    }
+
+    static void operator delete(void* ptr, size_t size) {
+        void* mem = static_cast<char*>(ptr) - HEADER;
+        std::pmr::memory_resource* mr = *static_cast<std::pmr::memory_resource**>(mem);
+        if(mr) { mr->deallocate(mem, size + HEADER, HEADER); }
+        else { ::operator delete(mem); }
+    }
+
+    // 结束时回到等待者；没有等待者（Detach启动）时销毁帧并调用done
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template<class Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            CoPromiseBase& promise = handle.promise();
+            if(promise.continuation) { return promise.continuation; }
+            std::function<void()> done = std::move(promise.done);
+            handle.destroy();
+            if(done) { done(); }
+            return std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    // 创建后先挂起，由co_await或Detach开始执行
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+
+    // 与线程池任务一致，异常不跨越处理函数
+    void unhandled_exception() const noexcept { std::terminate(); }
+
+    std::coroutine_handle<> continuation;
+    std::function<void()> done;
+};
+
+template<class T>
+struct CoPromiseResult {
+    template<class U>
+    void return_value(U&& value) { result.emplace(std::forward<U>(value)); }
+    T Take() { return std::move(*result); }
+
+    std::optional<T> result;
+};
+
+template<>
+struct CoPromiseResult<void> {
+    void return_void() const noexcept {}
+    void Take() const noexcept {}
+};
+
+// 协程的返回类型，co_await它时才开始执行，执行完直接切回等待者，不经过任何调度
+// 协程的参数按值传：挂起期间调用者的临时对象已经不在了
+template<class T = void>
+class CoTask {
+public:
+    struct promise_type : CoPromiseBase, CoPromiseResult<T> {
+        CoTask get_return_object() {
+            return CoTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+    };
+
+    CoTask(CoTask&& other) noexcept: handle_(std::exchange(other.handle_, nullptr)) {}
+    CoTask& operator=(CoTask&& other) noexcept {
+        if(this != &other) {
+            if(handle_) { handle_.destroy(); }
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+    ~CoTask() {
+        if(handle_) { handle_.destroy(); }
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+        handle_.promise().continuation = caller;
+        return handle_;
+    }
+
+    T await_resume() {
+        return handle_.promise().Take();
+    }
+
+    // 在当前线程开始执行，不再有等待者；结束后帧自行销毁并调用done
+    void Detach(std::function<void()> done) && {
+        assert(handle_);
+        handle_.promise().done = std::move(done);
+        std::exchange(handle_, nullptr).resume();
+    }
+
+private:
+    explicit CoTask(std::coroutine_handle<promise_type> handle): handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+#endif //COROUTINE_H
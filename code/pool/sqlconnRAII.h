@@ -14,9 +14,9 @@
 class SqlConnRAII {
 public:
     //双指针对MYSQL *con修改
-    SqlConnRAII(MYSQL** sql, SqlConnPool *connpool) {
+    SqlConnRAII(MYSQL** sql, SqlConnPool *connpool, int timeoutMs = SqlConnPool::ACQUIRE_TIMEOUT_MS) {
         assert(connpool);
-        *sql = connpool->GetConn();
+        *sql = connpool->GetConn(timeoutMs);
         sql_ = *sql;
         connpool_ = connpool;
     }
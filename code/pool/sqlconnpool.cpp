@@ -5,12 +5,22 @@
  */ 
 
 #include "sqlconnpool.h"
+
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+#include <ctype.h>
+#include <strings.h>
+
 using namespace std;
+using namespace std::chrono;
 
-SqlConnPool::SqlConnPool() {
-    useCount_ = 0;
-    freeCount_ = 0;
-}
+mutex SqlConnPool::stmtMtx_;
+vector<string> SqlConnPool::stmtSql_;
+vector<bool> SqlConnPool::stmtRead_;
+
+SqlConnPool::SqlConnPool(): MAX_CONN_(0), brokenCount_(0), unopened_(0), warm_(0), port_(0), isClose_(true),
+                            acquired_(0), timeouts_(0), reconnects_(0), waitHist_{} {}
 
 SqlConnPool* SqlConnPool::Instance() {
     static SqlConnPool connPool;
@@ -19,75 +29,383 @@ SqlConnPool* SqlConnPool::Instance() {
 
 void SqlConnPool::Init(const char* host, int port,
             const char* user,const char* pwd, const char* dbName,
-            int connSize = 10) {
+            int connSize, int warmSize) {
     assert(connSize > 0);
-    //创建ConnSize条数据库连接，连接池初始化
-    for (int i = 0; i < connSize; i++) {
-        MYSQL *sql = nullptr;
-        sql = mysql_init(sql);
-        if (!sql) {
-            LOG_ERROR("MySql init error!");
-            assert(sql);
-        }
-        sql = mysql_real_connect(sql, host,
-                                 user, pwd,
-                                 dbName, port, nullptr, 0);
-        if (!sql) {
-            LOG_ERROR("MySql Connect error!");
-        }
-        connQue_.push(sql);
-    }
+    host_ = host;
+    port_ = port;
+    user_ = user;
+    pwd_ = pwd;
+    dbName_ = dbName;
+    //不在这里连接：连接慢或连不上时也不耽误服务器开始监听，由后台线程建立
     MAX_CONN_ = connSize;
-    //sem_init() 初始化一个定位在 sem 的匿名信号量。value 参数指定信号量的初始值。 pshared 参数指明信号量是由进程内线程共享，还是由进程之间共享。
-    sem_init(&semId_, 0, MAX_CONN_);
+    unopened_ = connSize;
+    warm_ = min(max(warmSize, 1), connSize);
+    isClose_ = false;
+    keeper_ = thread(&SqlConnPool::KeepAlive_, this);
+}
+
+MYSQL* SqlConnPool::Connect_() {
+    MYSQL *sql = mysql_init(nullptr);
+    if (!sql) {
+        LOG_ERROR("MySql init error!");
+        return nullptr;
+    }
+    //数据库不可达时不要让重连卡住太久
+    unsigned int timeout = CONNECT_TIMEOUT_S;
+    mysql_options(sql, MYSQL_OPT_CONNECT_TIMEOUT, &timeout);
+    if (!mysql_real_connect(sql, host_.c_str(), user_.c_str(), pwd_.c_str(),
+                            dbName_.c_str(), port_, nullptr, 0)) {
+        LOG_ERROR("MySql Connect error! %s", mysql_error(sql));
+        mysql_close(sql);
+        return nullptr;
+    }
+    return sql;
 }
 
-// {
-// std::lock_guard<std::mutex> mylockguard(mylock);
-// /*...
-//     中间用来写需要加锁的内容
-// */
-// }
+//连接和它的预编译语句一起关闭
+void SqlConnPool::Close_(MYSQL* sql) {
+    vector<MYSQL_STMT*> stmts;
+    {
+        lock_guard<mutex> locker(mtx_);
+        auto it = stmts_.find(sql);
+        if(it != stmts_.end()) {
+            stmts.swap(it->second);
+            stmts_.erase(it);
+        }
+    }
+    for(MYSQL_STMT* stmt : stmts) {
+        if(stmt) { mysql_stmt_close(stmt); }
+    }
+    mysql_close(sql);
+}
 
 //当有请求时，从数据库连接池中返回一个可用连接
-MYSQL* SqlConnPool::GetConn() {
+//有人在排队时新来的也要排在后面，连接由FreeConn按顺序直接交给等待者
+MYSQL* SqlConnPool::GetConn(int timeoutMs) {
+    steady_clock::time_point start = steady_clock::now();
     MYSQL *sql = nullptr;
-    if(connQue_.empty()){
+    unique_lock<mutex> locker(mtx_);
+    if(waiters_.empty() && !connQue_.empty()) {
+        sql = connQue_.front().conn;
+        connQue_.pop_front();
+    }
+    else if(!isClose_ && timeoutMs > 0) {
+        Waiter waiter;
+        waiters_.push_back(&waiter);
+        //还有没打开的连接时让后台线程去连
+        if(unopened_ > 0) { keeperCond_.notify_one(); }
+        waiter.cond.wait_until(locker, start + milliseconds(timeoutMs),
+                               [&] { return waiter.conn || isClose_; });
+        sql = waiter.conn;
+        //超时：交出连接时会把等待者移出队列，还在队列中说明没有拿到
+        if(!sql) { waiters_.erase(find(waiters_.begin(), waiters_.end(), &waiter)); }
+    }
+    if(!sql) {
+        timeouts_++;
         LOG_WARN("SqlConnPool busy!");
         return nullptr;
     }
+    acquired_++;
+    int64_t waitUs = duration_cast<microseconds>(steady_clock::now() - start).count();
+    int bucket = 0;
+    while(bucket < WAIT_BUCKETS - 1 && waitUs >= WAIT_BUCKET_US[bucket]) { bucket++; }
+    waitHist_[bucket]++;
+    return sql;
+}
 
-    //取出连接，信号量原子减1，为0则等待
-    sem_wait(&semId_);
-    //需要加锁的内容
-    {
-        lock_guard<mutex> locker(mtx_);
-        sql = connQue_.front();
-        connQue_.pop();
+//调用时已持有锁
+void SqlConnPool::Release_(MYSQL* sql) {
+    if(!waiters_.empty()) {
+        Waiter* waiter = waiters_.front();
+        waiters_.pop_front();
+        waiter->conn = sql;
+        waiter->cond.notify_one();
+        return;
     }
-    return sql;
+    connQue_.push_back({ sql, steady_clock::now() });
 }
 
 //释放当前使用的连接，将连接返还连接池
 void SqlConnPool::FreeConn(MYSQL* sql) {
     assert(sql);
+    {
+        lock_guard<mutex> locker(mtx_);
+        if(!broken_.erase(sql)) {
+            Release_(sql);
+            return;
+        }
+        brokenCount_++;
+    }
+    //已断开的连接关掉，由后台线程重连
+    Close_(sql);
+    keeperCond_.notify_one();
+}
+
+//空闲太久的连接先从池中取出，ping期间不会被人拿走；ping不通的关掉，和断开的连接一起重连
+//有断开或要打开的连接时按RECONNECT_MS重试，否则每KEEPALIVE_MS检查一次
+void SqlConnPool::KeepAlive_() {
+    unique_lock<mutex> locker(mtx_);
+    while(!isClose_) {
+        Replenish_(locker);
+        if(isClose_) { break; }
+        keeperCond_.wait_for(locker, milliseconds(brokenCount_ || OpenWanted_() ? RECONNECT_MS : KEEPALIVE_MS));
+        if(isClose_) { break; }
+        steady_clock::time_point idleSince = steady_clock::now() - milliseconds(KEEPALIVE_MS);
+        vector<MYSQL*> idle;
+        while(!connQue_.empty() && connQue_.front().since <= idleSince) {
+            idle.push_back(connQue_.front().conn);
+            connQue_.pop_front();
+        }
+        locker.unlock();
+
+        vector<MYSQL*> alive;
+        for(MYSQL* sql : idle) {
+            if(mysql_ping(sql) == 0) {
+                alive.push_back(sql);
+                continue;
+            }
+            LOG_WARN("MySql ping error: %s", mysql_error(sql));
+            Close_(sql);
+        }
+
+        locker.lock();
+        brokenCount_ += idle.size() - alive.size();
+        for(MYSQL* sql : alive) { Release_(sql); }
+    }
+}
+
+//还没连够warmSize条时补足，另外每个排队的取连接者打开一条
+int SqlConnPool::OpenWanted_() const {
+    int opened = MAX_CONN_ - unopened_;
+    return min(unopened_, max(warm_ - opened, 0) + static_cast<int>(waiters_.size()));
+}
+
+bool SqlConnPool::IsReady_() const {
+    return !isClose_ && MAX_CONN_ > 0 && MAX_CONN_ - unopened_ - brokenCount_ >= warm_;
+}
+
+//先连一条探路，数据库连不上时不必每条都等到超时；连上了其余的并行连，每连上一条立即放回池中
+void SqlConnPool::Replenish_(unique_lock<mutex>& locker) {
+    int reconnect = brokenCount_;
+    int open = OpenWanted_();
+    if(reconnect + open == 0) { return; }
+    locker.unlock();
+    MYSQL* first = Connect_();
+    locker.lock();
+    if(!first) { return; }
+    Opened_(first, reconnect > 0);
+    if(reconnect > 0) { reconnect--; }
+    else { open--; }
+    locker.unlock();
+
+    vector<thread> connectors;
+    for(int i = 0; i < reconnect + open; i++) {
+        connectors.emplace_back([this, isReconnect = i < reconnect] {
+            MYSQL* sql = Connect_();
+            if(!sql) { return; }
+            lock_guard<mutex> locker(mtx_);
+            Opened_(sql, isReconnect);
+        });
+    }
+    for(thread& connector : connectors) { connector.join(); }
+    locker.lock();
+    LOG_INFO("SqlConnPool connected, %d of %d open", MAX_CONN_ - unopened_ - brokenCount_, MAX_CONN_);
+}
+
+void SqlConnPool::Opened_(MYSQL* sql, bool reconnect) {
+    if(reconnect) {
+        brokenCount_--;
+        reconnects_++;
+    } else {
+        unopened_--;
+    }
+    Release_(sql);
+    readyCond_.notify_all();
+}
+
+bool SqlConnPool::IsReady() {
+    lock_guard<mutex> locker(mtx_);
+    return IsReady_();
+}
+
+bool SqlConnPool::WaitReady(int timeoutMs) {
+    unique_lock<mutex> locker(mtx_);
+    return readyCond_.wait_for(locker, milliseconds(timeoutMs), [this] { return IsReady_() || isClose_; }) && !isClose_;
+}
+
+SqlConnPool::Stats SqlConnPool::GetStats() {
     lock_guard<mutex> locker(mtx_);
-    connQue_.push(sql);
-    //释放连接原子加1
-    sem_post(&semId_);
+    Stats stats;
+    stats.total = MAX_CONN_;
+    stats.free = connQue_.size();
+    stats.broken = brokenCount_;
+    stats.unopened = unopened_;
+    stats.inUse = MAX_CONN_ - stats.free - brokenCount_ - unopened_;
+    stats.waiting = waiters_.size();
+    stats.acquired = acquired_;
+    stats.timeouts = timeouts_;
+    stats.reconnects = reconnects_;
+    stats.waitHist = waitHist_;
+    return stats;
 }
 
-//销毁数据库连接池
+//销毁数据库连接池；正在使用中的连接归还后不再关闭
 void SqlConnPool::ClosePool() {
+    {
+        lock_guard<mutex> locker(mtx_);
+        isClose_ = true;
+        for(Waiter* waiter : waiters_) { waiter->cond.notify_one(); }
+    }
+    readyCond_.notify_all();
+    keeperCond_.notify_one();
+    if(keeper_.joinable()) { keeper_.join(); }
+
     lock_guard<mutex> locker(mtx_);
+    //预编译语句属于连接，先于连接关闭
+    for(auto& conn : stmts_) {
+        for(MYSQL_STMT* stmt : conn.second) {
+            if(stmt) { mysql_stmt_close(stmt); }
+        }
+    }
+    stmts_.clear();
     while(!connQue_.empty()) {
-        auto item = connQue_.front();
-        connQue_.pop();
-        mysql_close(item);
+        mysql_close(connQue_.front().conn);
+        connQue_.pop_front();
+    }
+
+    //清理和释放库使用的资源避免内存泄露；副本的连接池先于主库关闭，由主库释放
+    if(this == Instance()) { mysql_library_end(); }
+}
+
+int SqlConnPool::RegisterStmt(const char* sql) {
+    assert(sql);
+    const char* verb = sql;
+    while(isspace(static_cast<unsigned char>(*verb))) { verb++; }
+    lock_guard<mutex> locker(stmtMtx_);
+    stmtSql_.push_back(sql);
+    stmtRead_.push_back(strncasecmp(verb, "SELECT", 6) == 0);
+    return stmtSql_.size() - 1;
+}
+
+bool SqlConnPool::IsReadStmt(int id) {
+    lock_guard<mutex> locker(stmtMtx_);
+    assert(id >= 0 && static_cast<size_t>(id) < stmtRead_.size());
+    return stmtRead_[id];
+}
+
+//缓存按连接分开，连接同一时刻只被一个线程持有，只有查找缓存需要加锁
+MYSQL_STMT* SqlConnPool::GetStmt_(MYSQL* sql, int id) {
+    vector<MYSQL_STMT*>* cache;
+    string text;
+    {
+        lock_guard<mutex> locker(mtx_);
+        cache = &stmts_[sql];
+        if(cache->size() <= static_cast<size_t>(id) || !(*cache)[id]) {
+            lock_guard<mutex> stmtLocker(stmtMtx_);
+            assert(id >= 0 && static_cast<size_t>(id) < stmtSql_.size());
+            if(cache->size() <= static_cast<size_t>(id)) { cache->resize(stmtSql_.size(), nullptr); }
+            text = stmtSql_[id];
+        }
+        else { return (*cache)[id]; }
+    }
+    MYSQL_STMT* stmt = mysql_stmt_init(sql);
+    if(!stmt) {
+        LOG_ERROR("MySql stmt init error!");
+        return nullptr;
+    }
+    if(mysql_stmt_prepare(stmt, text.data(), text.size())) {
+        LOG_ERROR("MySql prepare error: %s, %s", mysql_stmt_error(stmt), text.c_str());
+        mysql_stmt_close(stmt);
+        return nullptr;
+    }
+    lock_guard<mutex> locker(mtx_);
+    (*cache)[id] = stmt;
+    return stmt;
+}
+
+void SqlConnPool::DropStmt_(MYSQL* sql, int id) {
+    MYSQL_STMT* stmt;
+    {
+        lock_guard<mutex> locker(mtx_);
+        stmt = stmts_[sql][id];
+        stmts_[sql][id] = nullptr;
     }
+    if(stmt) { mysql_stmt_close(stmt); }
+}
+
+bool SqlConnPool::Execute(MYSQL* sql, int id, initializer_list<string_view> params,
+                          vector<vector<string>>* rows) {
+    assert(sql);
+    MYSQL_STMT* stmt = GetStmt_(sql, id);
+    if(stmt && Run_(stmt, params, rows)) { return true; }
+    if(stmt) {
+        LOG_WARN("MySql execute error: %s", mysql_stmt_error(stmt));
+        DropStmt_(sql, id);
+    }
+    unsigned int err = mysql_errno(sql);
+    if(err == 2006 || err == 2013) {   //CR_SERVER_GONE_ERROR, CR_SERVER_LOST
+        lock_guard<mutex> locker(mtx_);
+        broken_.insert(sql);
+    }
+    return false;
+}
+
+//参数和结果都绑定为字符串，类型转换交给服务端
+bool SqlConnPool::Run_(MYSQL_STMT* stmt, initializer_list<string_view> params,
+                       vector<vector<string>>* rows) {
+    //is_null在不同客户端库中是bool*或my_bool*
+    typedef remove_pointer_t<decltype(MYSQL_BIND::is_null)> Flag;
+    assert(params.size() <= MAX_PARAMS && params.size() == mysql_stmt_param_count(stmt));
+    MYSQL_BIND binds[MAX_PARAMS] = {};
+    unsigned long lengths[MAX_PARAMS];
+    size_t i = 0;
+    for(string_view param : params) {
+        lengths[i] = param.size();
+        binds[i].buffer_type = MYSQL_TYPE_STRING;
+        binds[i].buffer = const_cast<char*>(param.data());
+        binds[i].buffer_length = param.size();
+        binds[i].length = &lengths[i];
+        i++;
+    }
+    if(mysql_stmt_bind_param(stmt, binds) || mysql_stmt_execute(stmt)) { return false; }
 
-    //清理和释放库使用的资源避免内存泄露
-    mysql_library_end();        
+    unsigned int fields = mysql_stmt_field_count(stmt);
+    if(fields == 0) { return true; }
+    //结果全部读到本地，字段超长时才能按列补取
+    if(mysql_stmt_store_result(stmt)) { return false; }
+    vector<MYSQL_BIND> results(fields);
+    vector<unsigned long> fieldLens(fields);
+    unique_ptr<Flag[]> nulls(new Flag[fields]());
+    string buffer(static_cast<size_t>(fields) * FIELD_BUFFER, '\0');
+    for(unsigned int j = 0; j < fields; j++) {
+        results[j].buffer_type = MYSQL_TYPE_STRING;
+        results[j].buffer = &buffer[j * FIELD_BUFFER];
+        results[j].buffer_length = FIELD_BUFFER;
+        results[j].length = &fieldLens[j];
+        results[j].is_null = &nulls[j];
+    }
+    bool ok = !mysql_stmt_bind_result(stmt, results.data());
+    int ret = 0;
+    while(ok && ((ret = mysql_stmt_fetch(stmt)) == 0 || ret == MYSQL_DATA_TRUNCATED)) {
+        if(!rows) { continue; }
+        rows->emplace_back(fields);
+        for(unsigned int j = 0; j < fields; j++) {
+            if(nulls[j]) { continue; }
+            string& value = rows->back()[j];
+            if(fieldLens[j] <= FIELD_BUFFER) {
+                value.assign(&buffer[j * FIELD_BUFFER], fieldLens[j]);
+                continue;
+            }
+            value.resize(fieldLens[j]);
+            MYSQL_BIND column = {};
+            column.buffer_type = MYSQL_TYPE_STRING;
+            column.buffer = &value[0];
+            column.buffer_length = fieldLens[j];
+            ok = !mysql_stmt_fetch_column(stmt, &column, j, 0);
+        }
+    }
+    mysql_stmt_free_result(stmt);
+    return ok && ret == MYSQL_NO_DATA;
 }
 
 //当前空闲的连接数
@@ -2,46 +2,142 @@
  * @Author       : mark
  * @Date         : 2020-06-16
  * @copyleft Apache 2.0
- */ 
+ */
 #ifndef SQLCONNPOOL_H
 #define SQLCONNPOOL_H
 
 #include <mysql/mysql.h>
 #include <string>
-#include <queue>
+#include <string_view>
+#include <deque>
+#include <vector>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <initializer_list>
 #include <mutex>
-#include <semaphore.h>
+#include <condition_variable>
 #include <thread>
 #include "../log/log.h"
 
 //使用单例模式和队列创建数据库连接池，实现对数据库连接资源的复用。
 //数据库连接池的定义
+//取连接按先来先到排队，归还的连接直接交给排在最前面的等待者；等到期限还没拿到就返回nullptr，不会无限阻塞
+//Init立即返回，连接都由后台线程建立：先并行连上warmSize条，其余的等取连接要排队时再连
+//后台线程定期ping空闲连接，断开的连接关闭后由它重连
+//Instance()连主库；读写分离时各副本另有一个连接池，由SqlRouter创建，语句编号在所有连接池中通用
 class SqlConnPool {
 public:
-    //局部静态变量单例模式
+    //等待时间分布的桶上限（微秒），最后一个桶收其余的
+    static constexpr int WAIT_BUCKET_US[] = { 100, 1000, 10000, 100000, 1000000 };
+    static const int WAIT_BUCKETS = sizeof(WAIT_BUCKET_US) / sizeof(WAIT_BUCKET_US[0]) + 1;
+
+    struct Stats {
+        int total;      //连接总数，含断开待重连的
+        int free;
+        int inUse;
+        int broken;     //断开待重连的
+        int unopened;   //还没用到、没有打开的
+        int waiting;    //正在排队等连接的线程数
+        uint64_t acquired;
+        uint64_t timeouts;
+        uint64_t reconnects;
+        std::array<uint64_t, WAIT_BUCKETS> waitHist; //拿到连接前的等待时间分布
+    };
+
+    //局部静态变量单例模式，主库的连接池
     static SqlConnPool *Instance();
 
-    MYSQL *GetConn(); //获取数据库连接
+    SqlConnPool();
+    ~SqlConnPool();
+
+    static const int ACQUIRE_TIMEOUT_MS = 500;
+    static const int WARM_SIZE = 2;
+
+    MYSQL *GetConn(int timeoutMs = ACQUIRE_TIMEOUT_MS); //获取数据库连接，timeoutMs内没有空闲连接返回nullptr
     void FreeConn(MYSQL * conn); //释放连接
     int GetFreeConnCount(); //获取连接
+    Stats GetStats();
 
     void Init(const char* host, int port,
-              const char* user,const char* pwd, 
-              const char* dbName, int connSize); //初始化连接池
+              const char* user,const char* pwd,
+              const char* dbName, int connSize, int warmSize = WARM_SIZE); //初始化连接池
     void ClosePool(); //销毁所有连接
 
+    // 连上的连接（含正在使用的）不少于warmSize条时就绪
+    bool IsReady();
+    // 等到就绪或超时，返回是否就绪
+    bool WaitReady(int timeoutMs);
+
+    // 登记一条带?参数的语句，返回语句编号；各连接第一次执行时才预编译，之后复用
+    static int RegisterStmt(const char* sql);
+    // 以SELECT开头的是读语句，读写分离时可以发往副本
+    static bool IsReadStmt(int id);
+    // 在持有的连接sql上执行编号为id的语句，参数和结果都按字符串传递，rows不为空时取回全部结果行（NULL为空串）
+    // 出错时关闭这条预编译语句，下次重新预编译；连接已断开时归还后由后台线程重连
+    bool Execute(MYSQL* sql, int id, std::initializer_list<std::string_view> params,
+                 std::vector<std::vector<std::string>>* rows = nullptr);
+
 private:
-    SqlConnPool();
-    ~SqlConnPool();
+    static constexpr int KEEPALIVE_MS = 30000;      //空闲超过这么久的连接ping一次
+    static constexpr int RECONNECT_MS = 1000;       //有断开的连接时重连的间隔
+    static const int CONNECT_TIMEOUT_S = 3;
+    static const size_t MAX_PARAMS = 16;
+    static const unsigned long FIELD_BUFFER = 256;  //结果字段先按此长度取，更长的再单独取一次
+
+    //排队等连接的线程，归还的连接直接放进conn
+    struct Waiter {
+        std::condition_variable cond;
+        MYSQL* conn = nullptr;
+    };
+
+    struct Idle {
+        MYSQL* conn;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    MYSQL* Connect_();
+    void Close_(MYSQL* sql);
+    void Release_(MYSQL* sql);
+    void KeepAlive_();
+    //以下调用时已持有锁
+    int OpenWanted_() const;
+    bool IsReady_() const;
+    void Replenish_(std::unique_lock<std::mutex>& locker);
+    void Opened_(MYSQL* sql, bool reconnect);
+    MYSQL_STMT* GetStmt_(MYSQL* sql, int id);
+    void DropStmt_(MYSQL* sql, int id);
+    static bool Run_(MYSQL_STMT* stmt, std::initializer_list<std::string_view> params,
+                     std::vector<std::vector<std::string>>* rows);
 
     int MAX_CONN_; //最大连接数
-    int useCount_; //当前已使用的连接数
-    int freeCount_; //当前空闲的连接数
+    int brokenCount_; //断开待重连的连接数
+    int unopened_;  //还没打开的连接数
+    int warm_;      //就绪需要连上的连接数
+    std::string host_, user_, pwd_, dbName_;
+    int port_;
 
-    std::queue<MYSQL *> connQue_; //连接池
+    std::deque<Idle> connQue_; //连接池，队首是最早归还的
+    std::deque<Waiter*> waiters_;   //等连接的线程，先来先得
+    std::unordered_set<MYSQL*> broken_;   //执行时发现已断开的连接，归还时不再放回池中
+    static std::mutex stmtMtx_;
+    static std::vector<std::string> stmtSql_;   //下标为语句编号
+    static std::vector<bool> stmtRead_;
+    std::unordered_map<MYSQL*, std::vector<MYSQL_STMT*>> stmts_;   //每条连接已预编译的语句，下标为语句编号
     std::mutex mtx_;
-    sem_t semId_;
+
+    bool isClose_;
+    std::condition_variable readyCond_;
+    std::condition_variable keeperCond_;
+    std::thread keeper_;
+
+    uint64_t acquired_;
+    uint64_t timeouts_;
+    uint64_t reconnects_;
+    std::array<uint64_t, WAIT_BUCKETS> waitHist_;
 };
 
 
-#endif // SQLCONNPOOL_H
\ No newline at end of file
+#endif // SQLCONNPOOL_H
@@ -0,0 +1,164 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "sqlrouter.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+using namespace std;
+using namespace std::chrono;
+
+SqlRouter::SqlRouter(): next_(0), stickyMs_(0), maxLagS_(MAX_LAG_S), primaryReads_(0), stickyReads_(0),
+                        writtenCount_(0), isClose_(true) {}
+
+SqlRouter::~SqlRouter() {
+    Close();
+}
+
+SqlRouter* SqlRouter::Instance() {
+    static SqlRouter router;
+    return &router;
+}
+
+void SqlRouter::Init(const char* replicas, const char* user, const char* pwd, const char* dbName, int connSize,
+                     int stickyMs, int maxLagS) {
+    assert(replicas_.empty());
+    stickyMs_ = stickyMs;
+    maxLagS_ = maxLagS;
+    for(const char* p = replicas; p && *p; ) {
+        const char* end = strchr(p, ',');
+        string item(p, end ? end - p : strlen(p));
+        p = end ? end + 1 : p + item.size();
+        if(item.empty()) { continue; }
+        unique_ptr<Replica> replica(new Replica);
+        size_t colon = item.rfind(':');
+        replica->host = item.substr(0, colon);
+        replica->port = colon == string::npos ? 3306 : atoi(item.c_str() + colon + 1);
+        replica->pool.Init(replica->host.c_str(), replica->port, user, pwd, dbName, connSize);
+        replicas_.push_back(move(replica));
+    }
+    if(replicas_.empty()) { return; }
+    //副本的连接也在后台建立，查到复制状态之前读都走主库
+    isClose_ = false;
+    checker_ = thread(&SqlRouter::Run_, this);
+}
+
+void SqlRouter::Close() {
+    {
+        lock_guard<mutex> locker(mtx_);
+        isClose_ = true;
+    }
+    cond_.notify_one();
+    if(checker_.joinable()) { checker_.join(); }
+    for(auto& replica : replicas_) { replica->pool.ClosePool(); }
+}
+
+SqlConnPool* SqlRouter::Route(int id, string_view key) {
+    SqlConnPool* primary = SqlConnPool::Instance();
+    if(replicas_.empty() || !SqlConnPool::IsReadStmt(id)) { return primary; }
+    if(!key.empty() && IsSticky_(key)) {
+        stickyReads_++;
+        primaryReads_++;
+        return primary;
+    }
+    size_t count = replicas_.size();
+    size_t start = next_.fetch_add(1, memory_order_relaxed);
+    for(size_t i = 0; i < count; i++) {
+        Replica& replica = *replicas_[(start + i) % count];
+        if(replica.healthy.load(memory_order_relaxed)) {
+            replica.reads++;
+            return &replica.pool;
+        }
+    }
+    primaryReads_++;
+    return primary;
+}
+
+void SqlRouter::MarkWritten(string_view key) {
+    if(replicas_.empty() || stickyMs_ <= 0 || key.empty()) { return; }
+    steady_clock::time_point until = steady_clock::now() + milliseconds(stickyMs_);
+    lock_guard<mutex> locker(stickyMtx_);
+    auto it = written_.find(key);
+    if(it != written_.end()) { it->second = until; }
+    else { written_.emplace(key, until); }
+    writtenCount_ = written_.size();
+}
+
+bool SqlRouter::IsSticky_(string_view key) {
+    if(writtenCount_.load(memory_order_relaxed) == 0) { return false; }
+    lock_guard<mutex> locker(stickyMtx_);
+    auto it = written_.find(key);
+    return it != written_.end() && it->second > steady_clock::now();
+}
+
+//8.0.22起是SHOW REPLICA STATUS和Seconds_Behind_Source，之前的版本用旧名字
+//不是副本（没有结果行）或复制线程停止（NULL）时返回-1
+int SqlRouter::QueryLag_(SqlConnPool* pool) {
+    MYSQL* sql;
+    SqlConnRAII sqlRAII(&sql, pool);
+    if(!sql) { return -1; }
+    for(const char* order : { "SHOW REPLICA STATUS", "SHOW SLAVE STATUS" }) {
+        if(mysql_query(sql, order)) { continue; }
+        MYSQL_RES* res = mysql_store_result(sql);
+        if(!res) { return -1; }
+        int lag = -1;
+        unsigned int num = mysql_num_fields(res);
+        MYSQL_FIELD* fields = mysql_fetch_fields(res);
+        MYSQL_ROW row = mysql_fetch_row(res);
+        for(unsigned int i = 0; row && i < num; i++) {
+            if((!strcmp(fields[i].name, "Seconds_Behind_Source") || !strcmp(fields[i].name, "Seconds_Behind_Master"))
+               && row[i]) {
+                lag = atoi(row[i]);
+            }
+        }
+        mysql_free_result(res);
+        return lag;
+    }
+    LOG_WARN("Query replica status failed: %s", mysql_error(sql));
+    return -1;
+}
+
+void SqlRouter::CheckReplicas_() {
+    for(auto& replica : replicas_) {
+        int lag = QueryLag_(&replica->pool);
+        bool healthy = lag >= 0 && lag <= maxLagS_;
+        if(healthy != replica->healthy.load()) {
+            LOG_WARN("Replica %s:%d %s, lag %d s", replica->host.c_str(), replica->port,
+                     healthy ? "available" : "unavailable", lag);
+        }
+        replica->lagS = lag;
+        replica->healthy = healthy;
+    }
+    //过期的写入记录顺便清掉
+    lock_guard<mutex> locker(stickyMtx_);
+    steady_clock::time_point now = steady_clock::now();
+    for(auto it = written_.begin(); it != written_.end();) {
+        if(it->second <= now) { it = written_.erase(it); }
+        else { ++it; }
+    }
+    writtenCount_ = written_.size();
+}
+
+void SqlRouter::Run_() {
+    unique_lock<mutex> locker(mtx_);
+    while(!isClose_) {
+        locker.unlock();
+        CheckReplicas_();
+        locker.lock();
+        cond_.wait_for(locker, milliseconds(LAG_CHECK_MS));
+    }
+}
+
+SqlRouter::Stats SqlRouter::GetStats() {
+    Stats stats;
+    stats.primaryReads = primaryReads_;
+    stats.stickyReads = stickyReads_;
+    for(auto& replica : replicas_) {
+        stats.replicas.push_back({ replica->host, replica->port, replica->healthy.load(), replica->lagS.load(),
+                                   replica->reads.load(), replica->pool.GetStats() });
+    }
+    return stats;
+}
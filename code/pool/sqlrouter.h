@@ -0,0 +1,110 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+
+#ifndef SQL_ROUTER_H
+#define SQL_ROUTER_H
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <string_view>
+#include <functional>
+#include <unordered_map>
+#include <condition_variable>
+
+#include "../log/log.h"
+#include "sqlconnpool.h"
+#include "sqlconnRAII.h"
+
+// 读写分离：写语句走主库（SqlConnPool::Instance()），读语句轮流分给各副本的连接池
+// 刚写过的键在stickyMs内读也走主库，保证读到自己的写入
+// 后台线程每LAG_CHECK_MS在各副本上查复制状态；落后超过maxLagS、复制停止或查不到的副本暂不分配，全都不可用时读也走主库
+class SqlRouter {
+public:
+    static const int STICKY_MS = 2000;
+    static const int MAX_LAG_S = 5;
+    static constexpr int LAG_CHECK_MS = 1000;
+
+    struct ReplicaStats {
+        std::string host;
+        int port;
+        bool healthy;
+        int lagS;           //-1表示查不到
+        uint64_t reads;
+        SqlConnPool::Stats pool;
+    };
+
+    struct Stats {
+        uint64_t primaryReads;  //没有可用副本或刚写过而走主库的读
+        uint64_t stickyReads;   //其中因为刚写过的
+        std::vector<ReplicaStats> replicas;
+    };
+
+    //局部静态变量单例模式
+    static SqlRouter* Instance();
+
+    // 主库的连接池初始化之后调用；replicas形如"host:port,host:port"，其余参数和主库相同
+    // replicas为空时不做读写分离；stickyMs为0时不保证读到自己的写入
+    void Init(const char* replicas, const char* user, const char* pwd, const char* dbName, int connSize,
+              int stickyMs = STICKY_MS, int maxLagS = MAX_LAG_S);
+    // 关闭各副本的连接池，在主库之前调用
+    void Close();
+
+    // 执行编号为id的语句应该使用的连接池；key是语句读写的用户名等，为空时不考虑读自己的写入
+    SqlConnPool* Route(int id, std::string_view key = {});
+    // 在主库写入key成功后调用
+    void MarkWritten(std::string_view key);
+
+    Stats GetStats();
+    // Init之后不再变，不加锁
+    size_t ReplicaCount() const { return replicas_.size(); }
+
+private:
+    SqlRouter();
+    ~SqlRouter();
+
+    struct Replica {
+        std::string host;
+        int port;
+        SqlConnPool pool;
+        std::atomic<bool> healthy{ false };
+        std::atomic<int> lagS{ -1 };
+        std::atomic<uint64_t> reads{ 0 };
+    };
+
+    // 用string_view直接查表，不为查找构造string
+    struct KeyHash {
+        typedef void is_transparent;
+        size_t operator()(std::string_view key) const { return std::hash<std::string_view>()(key); }
+    };
+
+    static int QueryLag_(SqlConnPool* pool);
+    bool IsSticky_(std::string_view key);
+    void CheckReplicas_();
+    void Run_();
+
+    std::vector<std::unique_ptr<Replica>> replicas_;    //Init之后不再变
+    std::atomic<size_t> next_;
+    int stickyMs_;
+    int maxLagS_;
+    std::atomic<uint64_t> primaryReads_;
+    std::atomic<uint64_t> stickyReads_;
+
+    std::mutex stickyMtx_;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point, KeyHash, std::equal_to<>> written_;
+    std::atomic<size_t> writtenCount_;  //为0时读不加锁
+
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    bool isClose_;
+    std::thread checker_;
+};
+
+#endif //SQL_ROUTER_H
@@ -0,0 +1,93 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+
+#ifndef TASK_H
+#define TASK_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+// 线程池任务：只能移动的可调用对象，闭包直接存放在对象内部，构造和移动都不分配内存
+// 闭包超过INLINE_SIZE时编译报错，需要更多状态时改为捕获指针
+// 加上任务队列的序号和入队时间戳正好一个缓存行，槽位不会跨缓存行
+class Task {
+public:
+    static const size_t INLINE_SIZE = 32;
+
+    Task() noexcept: invoke_(nullptr), manage_(nullptr) {}
+
+    Task(std::nullptr_t) noexcept: Task() {}
+
+    template<class F, class = std::enable_if_t<!std::is_same<std::decay_t<F>, Task>::value>>
+    Task(F&& fn) {
+        typedef std::decay_t<F> Fn;
+        static_assert(sizeof(Fn) <= INLINE_SIZE, "closure is too large for Task, capture a pointer instead");
+        static_assert(alignof(Fn) <= alignof(void*), "closure alignment is too large for Task");
+        static_assert(std::is_nothrow_move_constructible<Fn>::value, "closure must be nothrow movable");
+        new(storage_) Fn(std::forward<F>(fn));
+        invoke_ = [](void* fn) { (*static_cast<Fn*>(fn))(); };
+        //dst为空时只析构src，否则把src移动到dst后析构src
+        manage_ = [](void* dst, void* src) {
+            if(dst) { new(dst) Fn(std::move(*static_cast<Fn*>(src))); }
+            static_cast<Fn*>(src)->~Fn();
+        };
+    }
+
+    Task(Task&& other) noexcept: invoke_(other.invoke_), manage_(other.manage_) {
+        if(manage_) {
+            manage_(storage_, other.storage_);
+            other.invoke_ = nullptr;
+            other.manage_ = nullptr;
+        }
+    }
+
+    Task& operator=(Task&& other) noexcept {
+        if(this != &other) {
+            Reset_();
+            invoke_ = other.invoke_;
+            manage_ = other.manage_;
+            if(manage_) {
+                manage_(storage_, other.storage_);
+                other.invoke_ = nullptr;
+                other.manage_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    Task& operator=(std::nullptr_t) noexcept {
+        Reset_();
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { Reset_(); }
+
+    explicit operator bool() const { return invoke_ != nullptr; }
+
+    void operator()() { invoke_(storage_); }
+
+private:
+    void Reset_() {
+        if(manage_) {
+            manage_(nullptr, storage_);
+            invoke_ = nullptr;
+            manage_ = nullptr;
+        }
+    }
+
+    void (*invoke_)(void* fn);
+    void (*manage_)(void* dst, void* src);
+    alignas(void*) unsigned char storage_[INLINE_SIZE];
+};
+
+static_assert(sizeof(Task) == 48, "Task should share one cache line with a queue sequence number and an enqueue timestamp");
+
+#endif //TASK_H
@@ -0,0 +1,678 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <utility>
+#include <assert.h>
+
+#include "task.h"
+#include "affinity.h"
+
+// 工作窃取线程池，接口与ThreadPool相同
+// 外部线程（如reactor）提交的任务进入无锁的MPMC注入队列；工作线程提交的任务压入自己的Chase-Lev双端队列
+// 工作线程先从自己的队列尾部取，再从注入队列成批取，最后随机挑一个线程从它的队列头部偷
+// 只有在没有线程正在找任务时才唤醒睡眠的线程，找到任务的线程再接力唤醒下一个，避免一次提交惊醒所有线程
+// 给定cpus时第i个线程绑定到cpus[i % cpus.size()]，窃取时先找同一NUMA节点上的线程
+// maxThreads大于threadCount时线程数可伸缩：任务排队时间持续超过targetWaitUs就加线程，最多maxThreads个；
+// 睡眠超过idleMs的线程退出，至少保留threadCount个
+// queueLimit大于0时排队的任务数有上限，超过后TryAddTask拒绝提交
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(size_t threadCount = 8, const std::vector<int>& cpus = {},
+                              size_t maxThreads = 0, int targetWaitUs = 2000, int idleMs = 30000,
+                              size_t queueLimit = 0)
+        : pool_(std::make_shared<Pool>(threadCount, std::max(threadCount, maxThreads), cpus,
+                                       targetWaitUs, idleMs, queueLimit)) {
+        assert(threadCount > 0);
+        for(size_t i = 0; i < threadCount; i++) {
+            pool_->Spawn(i);
+        }
+    }
+
+    WorkStealingPool() = default;
+
+    WorkStealingPool(WorkStealingPool&&) = default;
+
+    //剩余任务执行完后线程退出
+    ~WorkStealingPool() {
+        if(static_cast<bool>(pool_)) {
+            pool_->Close();
+        }
+    }
+
+    template<class F>
+    void AddTask(F&& task) {
+        pool_->Submit(Task(std::forward<F>(task)));
+    }
+
+    // 排队的任务达到queueLimit时不提交，返回false
+    template<class F>
+    bool TryAddTask(F&& task) {
+        if(!pool_->Admit()) { return false; }
+        pool_->Submit(Task(std::forward<F>(task)));
+        return true;
+    }
+
+    // 一次提交多个任务，只做一次入队同步和一次唤醒；tasks中的任务被移走
+    void AddTasks(Task* tasks, size_t cnt) {
+        pool_->SubmitBatch(tasks, cnt);
+    }
+
+    struct Stats {
+        size_t threads;
+        size_t minThreads;
+        size_t maxThreads;
+        uint64_t tasks;         //已执行的任务数
+        double avgWaitUs;       //任务从提交到开始执行的平均时间
+        double avgRunUs;
+        uint64_t maxWaitUs;
+        uint64_t recentWaitUs;  //各线程最近排队时间（指数平均）中的最大值，伸缩依据
+        uint64_t grown;         //累计新增的线程数
+        uint64_t retired;       //累计退出的线程数
+        size_t queued;          //排队中的任务数，只在设置了queueLimit时统计
+        size_t queueLimit;
+        uint64_t rejected;      //因排队超限被拒绝的任务数
+    };
+
+    Stats GetStats() const {
+        return pool_->GetStats();
+    }
+
+private:
+    static const size_t CACHE_LINE = 64;
+
+    // 有界的多生产者多消费者队列（Dmitry Vyukov），任务直接存放在槽位中
+    class InjectQueue {
+    public:
+        explicit InjectQueue(size_t capacity): mask_(capacity - 1), cells_(capacity) {
+            assert((capacity & mask_) == 0);
+            for(size_t i = 0; i < capacity; i++) {
+                cells_[i].seq.store(i, std::memory_order_relaxed);
+            }
+            enqueuePos_.store(0, std::memory_order_relaxed);
+            dequeuePos_.store(0, std::memory_order_relaxed);
+        }
+
+        bool Push(Task& task, int64_t enqueueNs) {
+            Cell* cell;
+            size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+            while(true) {
+                cell = &cells_[pos & mask_];
+                size_t seq = cell->seq.load(std::memory_order_acquire);
+                intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+                if(dif == 0) {
+                    if(enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) { break; }
+                }
+                else if(dif < 0) { return false; }  //队列已满
+                else { pos = enqueuePos_.load(std::memory_order_relaxed); }
+            }
+            cell->task = std::move(task);
+            cell->enqueueNs.store(enqueueNs, std::memory_order_relaxed);
+            cell->seq.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        // 一次CAS占住连续cnt个空槽位再逐个写入，空槽位不够时返回0由调用方逐个入队
+        size_t PushBatch(Task* tasks, size_t cnt, int64_t enqueueNs) {
+            if(cnt == 0 || cnt > mask_ + 1) { return 0; }
+            size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+            while(true) {
+                //槽位只可能被消费者变空，在CAS成功之前检查过的空槽位不会被别人占用
+                bool ready = true;
+                for(size_t i = 0; i < cnt; i++) {
+                    if(cells_[(pos + i) & mask_].seq.load(std::memory_order_acquire) != pos + i) {
+                        ready = false;
+                        break;
+                    }
+                }
+                if(!ready) {
+                    size_t cur = enqueuePos_.load(std::memory_order_relaxed);
+                    if(cur == pos) { return 0; }
+                    pos = cur;
+                    continue;
+                }
+                if(enqueuePos_.compare_exchange_weak(pos, pos + cnt, std::memory_order_relaxed)) { break; }
+            }
+            for(size_t i = 0; i < cnt; i++) {
+                Cell& cell = cells_[(pos + i) & mask_];
+                cell.task = std::move(tasks[i]);
+                cell.enqueueNs.store(enqueueNs, std::memory_order_relaxed);
+                cell.seq.store(pos + i + 1, std::memory_order_release);
+            }
+            return cnt;
+        }
+
+        bool Pop(Task& task, int64_t& enqueueNs) {
+            Cell* cell;
+            size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+            while(true) {
+                cell = &cells_[pos & mask_];
+                size_t seq = cell->seq.load(std::memory_order_acquire);
+                intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+                if(dif == 0) {
+                    if(dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) { break; }
+                }
+                else if(dif < 0) { return false; }  //队列为空
+                else { pos = dequeuePos_.load(std::memory_order_relaxed); }
+            }
+            task = std::move(cell->task);
+            cell->task = nullptr;
+            enqueueNs = cell->enqueueNs.load(std::memory_order_relaxed);
+            cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool Empty() const {
+            return dequeuePos_.load(std::memory_order_acquire) >= enqueuePos_.load(std::memory_order_acquire);
+        }
+
+        // 队头任务的入队时间，队列为空返回0；只用于估计排队时间，不要求精确
+        int64_t OldestNs() const {
+            size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+            const Cell& cell = cells_[pos & mask_];
+            if(cell.seq.load(std::memory_order_acquire) != pos + 1) { return 0; }
+            return cell.enqueueNs.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct alignas(CACHE_LINE) Cell {
+            std::atomic<size_t> seq;
+            Task task;
+            std::atomic<int64_t> enqueueNs;
+        };
+        static_assert(sizeof(Cell) == CACHE_LINE, "a queue cell should fill exactly one cache line");
+        const size_t mask_;
+        std::vector<Cell> cells_;
+        alignas(CACHE_LINE) std::atomic<size_t> enqueuePos_;
+        alignas(CACHE_LINE) std::atomic<size_t> dequeuePos_;
+    };
+
+    // 工作线程自己的任务节点，从线程本地的空闲链表分配
+    struct Node {
+        Task task;
+        Node* next;
+        int64_t enqueueNs;
+    };
+
+    // 节点在哪个线程释放就进哪个线程的空闲链表，被偷走的节点由窃取者回收
+    class NodeCache {
+    public:
+        ~NodeCache() {
+            while(head_) {
+                Node* node = head_;
+                head_ = node->next;
+                delete node;
+            }
+        }
+        static Node* Alloc(Task& task, int64_t enqueueNs) {
+            NodeCache& cache = Local_();
+            Node* node = cache.head_;
+            if(node) {
+                cache.head_ = node->next;
+                cache.count_--;
+                node->task = std::move(task);
+                node->enqueueNs = enqueueNs;
+                return node;
+            }
+            return new Node{ std::move(task), nullptr, enqueueNs };
+        }
+        static void Free(Node* node) {
+            NodeCache& cache = Local_();
+            node->task = nullptr;
+            if(cache.count_ >= MAX_CACHED) {
+                delete node;
+                return;
+            }
+            node->next = cache.head_;
+            cache.head_ = node;
+            cache.count_++;
+        }
+    private:
+        static const size_t MAX_CACHED = 1024;
+        static NodeCache& Local_() {
+            static thread_local NodeCache cache;
+            return cache;
+        }
+        Node* head_ = nullptr;
+        size_t count_ = 0;
+    };
+
+    // Chase-Lev工作窃取双端队列（按 Lê 等人给出的C11内存序）
+    // 只有所属线程在尾部Push/Pop，其他线程在头部Steal；容量固定，满了由调用方改投注入队列
+    class WorkDeque {
+    public:
+        static const int64_t CAPACITY = 1024;
+
+        WorkDeque(): top_(0), bottom_(0) {
+            for(auto& slot : buffer_) { slot.store(nullptr, std::memory_order_relaxed); }
+        }
+
+        bool Push(Node* node) {
+            int64_t b = bottom_.load(std::memory_order_relaxed);
+            int64_t t = top_.load(std::memory_order_acquire);
+            if(b - t >= CAPACITY) { return false; }
+            buffer_[b & (CAPACITY - 1)].store(node, std::memory_order_relaxed);
+            //窃取者acquire读bottom_后能看到节点内容
+            bottom_.store(b + 1, std::memory_order_release);
+            return true;
+        }
+
+        Node* Pop() {
+            int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+            bottom_.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = top_.load(std::memory_order_relaxed);
+            Node* node = nullptr;
+            if(t <= b) {
+                node = buffer_[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+                if(t == b) {
+                    //只剩最后一个，和窃取者竞争
+                    if(!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                        node = nullptr;
+                    }
+                    bottom_.store(b + 1, std::memory_order_relaxed);
+                }
+            } else {
+                bottom_.store(b + 1, std::memory_order_relaxed);
+            }
+            return node;
+        }
+
+        Node* Steal() {
+            int64_t t = top_.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = bottom_.load(std::memory_order_acquire);
+            if(t >= b) { return nullptr; }
+            Node* node = buffer_[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+            if(!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return node;
+        }
+
+        bool Empty() const {
+            return bottom_.load(std::memory_order_acquire) <= top_.load(std::memory_order_acquire);
+        }
+
+    private:
+        alignas(CACHE_LINE) std::atomic<int64_t> top_;
+        alignas(CACHE_LINE) std::atomic<int64_t> bottom_;
+        std::atomic<Node*> buffer_[CAPACITY];
+    };
+
+    struct alignas(CACHE_LINE) Worker {
+        WorkDeque deque;
+        uint32_t seed;  //挑选窃取对象的随机数状态
+        int cpu;        //绑定的CPU，-1表示不绑定
+        int node;
+        std::atomic<bool> active{false};    //槽位上有没有线程
+        //统计，只由槽位上的线程写
+        std::atomic<uint64_t> tasks{0};
+        std::atomic<uint64_t> waitNs{0};
+        std::atomic<uint64_t> runNs{0};
+        std::atomic<uint64_t> maxWaitNs{0};
+        std::atomic<int64_t> recentWaitNs{0};
+    };
+
+    static int64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    struct Pool : std::enable_shared_from_this<Pool> {
+        static const size_t INJECT_CAPACITY = 4096;
+        static const size_t INJECT_BATCH = 8;   //每次从注入队列搬到本地队列的任务数
+
+        Pool(size_t minThreads, size_t maxThreads, const std::vector<int>& cpus, int targetWaitUs, int idleMs,
+             size_t queueLimit)
+            : workers(maxThreads), inject(INJECT_CAPACITY), minThreads(minThreads),
+              targetWaitNs(static_cast<int64_t>(targetWaitUs) * 1000), idleMs(idleMs), queueLimit(queueLimit) {
+            for(size_t i = 0; i < maxThreads; i++) {
+                workers[i].seed = static_cast<uint32_t>(i * 2654435761u + 1);
+                workers[i].cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+                workers[i].node = cpus.empty() ? 0 : CpuAffinity::NodeOf(workers[i].cpu);
+            }
+        }
+
+        std::vector<Worker> workers;    //按最大线程数分配，没有线程的槽位队列为空
+        InjectQueue inject;
+
+        //注入队列满时的后备队列，正常情况下用不到
+        std::mutex overflowMtx;
+        std::deque<std::pair<Task, int64_t>> overflow;
+        std::atomic<size_t> overflowCnt{0};
+
+        const size_t minThreads;
+        const int64_t targetWaitNs;
+        const int idleMs;
+        std::atomic<size_t> threadCnt{0};
+        std::atomic<int64_t> lastGrowNs{0};
+        std::atomic<uint64_t> grown{0};
+        std::atomic<uint64_t> retired{0};
+
+        const size_t queueLimit;
+        std::atomic<size_t> queued{0};  //不限制排队时不维护，省掉每个任务一次原子操作
+        std::atomic<uint64_t> rejected{0};
+
+        std::atomic<int> searching{0};  //正在找任务的线程数
+        std::atomic<int> sleepers{0};   //睡眠的线程数
+        std::mutex mtx;
+        std::condition_variable cond;
+        uint64_t epoch = 0;             //每次唤醒加一，由mtx保护
+        std::atomic<bool> isClosed{false};
+
+        static thread_local Pool* current;
+        static thread_local size_t currentIdx;
+
+        //检查排队是否超限，多个提交方同时检查时可能略微超出上限
+        bool Admit() {
+            if(queueLimit == 0) { return true; }
+            if(queued.load(std::memory_order_relaxed) >= queueLimit) {
+                rejected++;
+                return false;
+            }
+            return true;
+        }
+
+        void Submit(Task task) {
+            if(queueLimit) { queued++; }
+            int64_t now = NowNs();
+            //工作线程提交的任务优先放进自己的队列
+            if(current == this) {
+                Node* node = NodeCache::Alloc(task, now);
+                if(workers[currentIdx].deque.Push(node)) {
+                    Notify();
+                    return;
+                }
+                task = std::move(node->task);
+                NodeCache::Free(node);
+            }
+            Inject(task, now);
+            Notify();
+            CheckBacklog(now);
+        }
+
+        void SubmitBatch(Task* tasks, size_t cnt) {
+            if(queueLimit) { queued += cnt; }
+            int64_t now = NowNs();
+            if(inject.PushBatch(tasks, cnt, now) == 0) {
+                for(size_t i = 0; i < cnt; i++) {
+                    Inject(tasks[i], now);
+                }
+            }
+            Notify();
+            CheckBacklog(now);
+        }
+
+        void Inject(Task& task, int64_t enqueueNs) {
+            if(!inject.Push(task, enqueueNs)) {
+                std::lock_guard<std::mutex> locker(overflowMtx);
+                overflow.emplace_back(std::move(task), enqueueNs);
+                overflowCnt++;
+            }
+        }
+
+        void Spawn(size_t idx) {
+            workers[idx].active.store(true, std::memory_order_relaxed);
+            threadCnt++;
+            std::thread([pool = shared_from_this(), idx] { pool->Run(idx); }).detach();
+        }
+
+        //所有线程都被阻塞（如等数据库）时没有线程取任务，由提交方看队头任务等了多久
+        void CheckBacklog(int64_t now) {
+            int64_t oldest = inject.OldestNs();
+            if(oldest > 0 && now - oldest > targetWaitNs) {
+                Grow(now);
+            }
+        }
+
+        //每个targetWait周期最多加一个线程，新线程分担后排队时间仍然超标才会继续加
+        void Grow(int64_t now) {
+            if(threadCnt.load(std::memory_order_relaxed) >= workers.size()) { return; }
+            int64_t last = lastGrowNs.load(std::memory_order_relaxed);
+            if(now - last < targetWaitNs || !lastGrowNs.compare_exchange_strong(last, now)) { return; }
+            for(size_t i = 0; i < workers.size(); i++) {
+                bool idle = false;
+                if(!workers[i].active.load(std::memory_order_relaxed) &&
+                    workers[i].active.compare_exchange_strong(idle, true)) {
+                    workers[i].recentWaitNs.store(0, std::memory_order_relaxed);
+                    Spawn(i);
+                    grown++;
+                    return;
+                }
+            }
+        }
+
+        //睡眠超时的线程退出，线程数不少于minThreads
+        bool TryRetire() {
+            size_t cnt = threadCnt.load();
+            while(cnt > minThreads) {
+                if(threadCnt.compare_exchange_weak(cnt, cnt - 1)) { return true; }
+            }
+            return false;
+        }
+
+        void Execute(size_t idx, Task& task, int64_t enqueueNs) {
+            Worker& self = workers[idx];
+            if(queueLimit) { queued--; }
+            int64_t start = NowNs();
+            task();
+            int64_t end = NowNs();
+            uint64_t wait = start > enqueueNs ? start - enqueueNs : 0;
+            self.tasks.store(self.tasks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            self.waitNs.store(self.waitNs.load(std::memory_order_relaxed) + wait, std::memory_order_relaxed);
+            self.runNs.store(self.runNs.load(std::memory_order_relaxed) + (end - start), std::memory_order_relaxed);
+            if(wait > self.maxWaitNs.load(std::memory_order_relaxed)) {
+                self.maxWaitNs.store(wait, std::memory_order_relaxed);
+            }
+            //指数平均，权重1/8，偶尔一次长等待不会触发扩容
+            int64_t recent = self.recentWaitNs.load(std::memory_order_relaxed);
+            recent += (static_cast<int64_t>(wait) - recent) / 8;
+            self.recentWaitNs.store(recent, std::memory_order_relaxed);
+            if(recent > targetWaitNs) {
+                Grow(end);
+            }
+        }
+
+        Stats GetStats() const {
+            Stats stats{};
+            stats.threads = threadCnt.load();
+            stats.minThreads = minThreads;
+            stats.maxThreads = workers.size();
+            uint64_t waitNs = 0, runNs = 0, maxWaitNs = 0;
+            int64_t recentNs = 0;
+            for(const Worker& worker : workers) {
+                stats.tasks += worker.tasks.load(std::memory_order_relaxed);
+                waitNs += worker.waitNs.load(std::memory_order_relaxed);
+                runNs += worker.runNs.load(std::memory_order_relaxed);
+                maxWaitNs = std::max(maxWaitNs, worker.maxWaitNs.load(std::memory_order_relaxed));
+                if(worker.active.load(std::memory_order_relaxed)) {
+                    recentNs = std::max(recentNs, worker.recentWaitNs.load(std::memory_order_relaxed));
+                }
+            }
+            if(stats.tasks > 0) {
+                stats.avgWaitUs = waitNs / 1000.0 / stats.tasks;
+                stats.avgRunUs = runNs / 1000.0 / stats.tasks;
+            }
+            stats.maxWaitUs = maxWaitNs / 1000;
+            stats.recentWaitUs = recentNs / 1000;
+            stats.grown = grown.load();
+            stats.retired = retired.load();
+            stats.queued = queued.load();
+            stats.queueLimit = queueLimit;
+            stats.rejected = rejected.load();
+            return stats;
+        }
+
+        //有线程在找任务时它会看到新任务，不必再唤醒
+        void Notify() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(searching.load(std::memory_order_relaxed) == 0 && sleepers.load(std::memory_order_relaxed) > 0) {
+                Wake();
+            }
+        }
+
+        void Wake() {
+            {
+                std::lock_guard<std::mutex> locker(mtx);
+                epoch++;
+            }
+            cond.notify_one();
+        }
+
+        void Close() {
+            {
+                std::lock_guard<std::mutex> locker(mtx);
+                isClosed = true;
+                epoch++;
+            }
+            cond.notify_all();
+        }
+
+        bool HasWork() {
+            if(!inject.Empty() || overflowCnt.load() > 0) { return true; }
+            for(Worker& worker : workers) {
+                if(!worker.deque.Empty()) { return true; }
+            }
+            return false;
+        }
+
+        //从注入队列取一个任务执行，再搬几个到本地队列供其他线程窃取
+        Node* TakeInjected(size_t idx) {
+            Task task;
+            int64_t enqueueNs;
+            if(!inject.Pop(task, enqueueNs)) {
+                if(overflowCnt.load() == 0) { return nullptr; }
+                std::lock_guard<std::mutex> locker(overflowMtx);
+                if(overflow.empty()) { return nullptr; }
+                task = std::move(overflow.front().first);
+                enqueueNs = overflow.front().second;
+                overflow.pop_front();
+                overflowCnt--;
+            }
+            Node* first = NodeCache::Alloc(task, enqueueNs);
+            for(size_t i = 1; i < INJECT_BATCH; i++) {
+                if(!inject.Pop(task, enqueueNs)) { break; }
+                Node* node = NodeCache::Alloc(task, enqueueNs);
+                if(!workers[idx].deque.Push(node)) {
+                    //本地队列满了就放回注入队列
+                    task = std::move(node->task);
+                    NodeCache::Free(node);
+                    Inject(task, enqueueNs);
+                    break;
+                }
+            }
+            return first;
+        }
+
+        //从随机位置开始依次尝试其他线程的队列，先偷同一节点的，任务用到的数据更可能在本节点的缓存里
+        Node* Steal(size_t idx) {
+            Worker& self = workers[idx];
+            size_t n = workers.size();
+            self.seed ^= self.seed << 13;
+            self.seed ^= self.seed >> 17;
+            self.seed ^= self.seed << 5;
+            size_t start = self.seed % n;
+            for(int remote = 0; remote < 2; remote++) {
+                for(size_t i = 0; i < n; i++) {
+                    size_t victim = (start + i) % n;
+                    if(victim == idx || !workers[victim].active.load(std::memory_order_relaxed) ||
+                        (workers[victim].node != self.node) != static_cast<bool>(remote)) { continue; }
+                    if(Node* node = workers[victim].deque.Steal()) {
+                        return node;
+                    }
+                }
+            }
+            return nullptr;
+        }
+
+        Node* Find(size_t idx) {
+            if(Node* node = workers[idx].deque.Pop()) {
+                return node;
+            }
+            searching++;
+            Node* node = TakeInjected(idx);
+            if(!node) {
+                node = Steal(idx);
+            }
+            //最后一个找任务的线程找到了任务，还有剩余任务时接力唤醒一个
+            if(searching.fetch_sub(1) == 1 && node && sleepers.load() > 0 && HasWork()) {
+                Wake();
+            }
+            return node;
+        }
+
+        void Run(size_t idx) {
+            if(workers[idx].cpu >= 0) {
+                CpuAffinity::PinSelf({ workers[idx].cpu });
+            }
+            current = this;
+            currentIdx = idx;
+            bool retire = false;
+            while(true) {
+                Node* node = Find(idx);
+                if(node) {
+                    Task task = std::move(node->task);
+                    int64_t enqueueNs = node->enqueueNs;
+                    NodeCache::Free(node);
+                    Execute(idx, task, enqueueNs);
+                    continue;
+                }
+                //先登记为睡眠再检查一次，与提交方的“写队列-读sleepers”配对，不会漏掉唤醒
+                std::unique_lock<std::mutex> locker(mtx);
+                uint64_t seen = epoch;
+                locker.unlock();
+                sleepers++;
+                if(HasWork()) {
+                    sleepers--;
+                    continue;
+                }
+                locker.lock();
+                if(isClosed) {
+                    sleepers--;
+                    break;
+                }
+                bool woken = true;
+                if(threadCnt.load() > minThreads && idleMs > 0) {
+                    woken = cond.wait_for(locker, std::chrono::milliseconds(idleMs), [&] { return epoch != seen; });
+                } else {
+                    cond.wait(locker, [&] { return epoch != seen; });
+                }
+                locker.unlock();
+                sleepers--;
+                //退出前再检查一次，与提交方的“写队列-读sleepers”配对，刚提交的任务不会没人处理
+                if(!woken && !isClosed && TryRetire()) {
+                    if(!HasWork()) {
+                        retire = true;
+                        break;
+                    }
+                    threadCnt++;
+                }
+            }
+            current = nullptr;
+            if(retire) {
+                retired++;
+                workers[idx].active.store(false, std::memory_order_release);
+            }
+        }
+    };
+    std::shared_ptr<Pool> pool_;
+};
+
+inline thread_local WorkStealingPool::Pool* WorkStealingPool::Pool::current = nullptr;
+inline thread_local size_t WorkStealingPool::Pool::currentIdx = 0;
+
+#endif //WORK_STEALING_POOL_H
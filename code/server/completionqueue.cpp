@@ -0,0 +1,49 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "completionqueue.h"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <assert.h>
+#include <stdint.h>
+
+CompletionQueue::CompletionQueue(): fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+    assert(fd_ >= 0);
+}
+
+CompletionQueue::~CompletionQueue() {
+    close(fd_);
+}
+
+//队列原来非空说明eventfd已经写过、reactor还没取走，不必再写
+void CompletionQueue::Post(Task task) {
+    bool wake;
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        wake = tasks_.empty();
+        tasks_.emplace_back(std::move(task));
+    }
+    if(wake) {
+        uint64_t one = 1;
+        ssize_t ret = write(fd_, &one, sizeof(one));
+        (void)ret;
+    }
+}
+
+//先清eventfd再取队列，取走之后的Post会重新写eventfd
+void CompletionQueue::Run() {
+    uint64_t cnt;
+    ssize_t ret = read(fd_, &cnt, sizeof(cnt));
+    (void)ret;
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        running_.swap(tasks_);
+    }
+    for(Task& task : running_) {
+        task();
+    }
+    running_.clear();
+}
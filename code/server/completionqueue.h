@@ -0,0 +1,35 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef COMPLETION_QUEUE_H
+#define COMPLETION_QUEUE_H
+
+#include <mutex>
+#include <vector>
+
+#include "../pool/task.h"
+
+// 其他线程交给reactor线程执行的任务，如执行通道处理完请求后的收尾
+// Post放入队列，队列由空变非空时写eventfd；reactor在epoll中监听GetFd()，可读时调用Run
+class CompletionQueue {
+public:
+    CompletionQueue();
+    ~CompletionQueue();
+
+    int GetFd() const { return fd_; }
+
+    void Post(Task task);
+
+    // 只在reactor线程调用，执行已投递的全部任务
+    void Run();
+
+private:
+    int fd_;    // eventfd
+    std::mutex mtx_;
+    std::vector<Task> tasks_;
+    std::vector<Task> running_; // 与tasks_交换后在锁外执行，两者都保留容量
+};
+
+#endif //COMPLETION_QUEUE_H
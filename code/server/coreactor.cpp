@@ -0,0 +1,162 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "coreactor.h"
+
+#include <unistd.h>
+#include <errno.h>
+
+using namespace std;
+
+CoReactor::CoReactor(): epoller_(nullptr) {}
+
+CoReactor* CoReactor::Instance() {
+    static CoReactor reactor;
+    return &reactor;
+}
+
+void CoReactor::Init(Epoller* epoller) {
+    assert(epoller);
+    epoller_ = epoller;
+    epoller_->AddFd(wakeup_.GetFd(), EPOLLIN);
+}
+
+void CoReactor::Close() {
+    if(!epoller_) { return; }
+    {
+        lock_guard<mutex> locker(mtx_);
+        for(auto& waiter : waiters_) {
+            epoller_->DelFd(waiter.first);
+        }
+        waiters_.clear();
+    }
+    timer_.clear();
+    epoller_->DelFd(wakeup_.GetFd());
+    epoller_ = nullptr;
+}
+
+void CoReactor::Post(Task task) {
+    wakeup_.Post(move(task));
+}
+
+int CoReactor::GetNextTick() {
+    return timer_.GetNextTick();
+}
+
+bool CoReactor::OnEvent(int fd, uint32_t events) {
+    if(!epoller_) { return false; }
+    if(fd == wakeup_.GetFd()) {
+        wakeup_.Run();
+        return true;
+    }
+    Task task;
+    {
+        lock_guard<mutex> locker(mtx_);
+        auto it = waiters_.find(fd);
+        if(it == waiters_.end()) { return false; }
+        task = move(it->second);
+    }
+    //EPOLLONESHOT：触发一次后不再通知，直到下一次WaitFd
+    if(task) { task(); }
+    return true;
+}
+
+//fd第一次等待时注册，之后改监听事件；在锁内重新布防，事件处理一定能看到刚放入的任务
+void CoReactor::WaitFd(int fd, uint32_t events, Task task) {
+    assert(epoller_ && fd >= 0);
+    lock_guard<mutex> locker(mtx_);
+    auto it = waiters_.find(fd);
+    if(it == waiters_.end()) {
+        waiters_.emplace(fd, move(task));
+        epoller_->AddFd(fd, events | EPOLLONESHOT);
+    } else {
+        it->second = move(task);
+        epoller_->ModFd(fd, events | EPOLLONESHOT);
+    }
+}
+
+void CoReactor::Forget(int fd) {
+    lock_guard<mutex> locker(mtx_);
+    if(waiters_.erase(fd) && epoller_) {
+        epoller_->DelFd(fd);
+    }
+}
+
+CoReactor::SleepAwaiter CoReactor::SleepFor(int ms) {
+    return SleepAwaiter(ms);
+}
+
+//定时器只在reactor线程操作，加定时也交给reactor；投递会唤醒epoll_wait，之后按新的最近到期时间等待
+void CoReactor::SleepAwaiter::await_suspend(coroutine_handle<> handle) {
+    CoReactor* reactor = CoReactor::Instance();
+    resumer_ = CoResumer(handle);
+    // 等待体在协程帧里，恢复前一直有效，定时节点直接嵌在里面
+    reactor->Post([reactor, this] {
+        reactor->timer_.add(&entry_, ms_, &SleepAwaiter::OnTimeout_, this);
+    });
+}
+
+void CoReactor::SleepAwaiter::OnTimeout_(void* owner, void*) {
+    static_cast<SleepAwaiter*>(owner)->resumer_();
+}
+
+CoConn& CoConn::operator=(CoConn&& other) noexcept {
+    if(this != &other) {
+        Close();
+        fd_ = other.fd_;
+        other.fd_ = -1;
+    }
+    return *this;
+}
+
+void CoConn::Close() {
+    if(fd_ < 0) { return; }
+    CoReactor::Instance()->Forget(fd_);
+    close(fd_);
+    fd_ = -1;
+}
+
+CoConn::IoAwaiter CoConn::read(void* buf, size_t len) {
+    return IoAwaiter(fd_, static_cast<char*>(buf), len, false);
+}
+
+CoConn::IoAwaiter CoConn::write(const void* buf, size_t len) {
+    return IoAwaiter(fd_, static_cast<char*>(const_cast<void*>(buf)), len, true);
+}
+
+void CoConn::IoAwaiter::await_suspend(coroutine_handle<> handle) {
+    resumer_ = CoResumer(handle);
+    Wait_();
+}
+
+//完成（含出错）返回true；需要等fd就绪时返回false
+bool CoConn::IoAwaiter::Try_() {
+    while(true) {
+        ssize_t len = isWrite_ ? ::write(fd_, buf_ + done_, len_ - done_) : ::read(fd_, buf_, len_);
+        if(len < 0) {
+            if(errno == EINTR) { continue; }
+            if(errno == EAGAIN || errno == EWOULDBLOCK) { return false; }
+            result_ = -errno;
+            return true;
+        }
+        if(!isWrite_) {
+            result_ = len;
+            return true;
+        }
+        done_ += len;
+        if(done_ == len_) {
+            result_ = len_;
+            return true;
+        }
+    }
+}
+
+//在reactor线程继续读写，完成后恢复协程，否则继续等
+void CoConn::IoAwaiter::Wait_() {
+    CoReactor::Instance()->WaitFd(fd_, isWrite_ ? EPOLLOUT : EPOLLIN, [this] {
+        if(Try_()) { resumer_(); }
+        else { Wait_(); }
+    });
+}
@@ -0,0 +1,123 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef CO_REACTOR_H
+#define CO_REACTOR_H
+
+#include <mutex>
+#include <unordered_map>
+#include <sys/types.h>
+
+#include "epoller.h"
+#include "completionqueue.h"
+#include "../pool/coroutine.h"
+#include "../timer/timingwheel.h"
+
+// 协程挂起后都由reactor线程恢复：定时到期、fd就绪、或其他线程投递
+// 协程等待期间不占用任何线程，只占一个协程帧
+class CoReactor {
+public:
+    class SleepAwaiter;
+
+    //局部静态变量单例模式
+    static CoReactor* Instance();
+
+    // 在reactor线程进入事件循环前调用
+    void Init(Epoller* epoller);
+    // 丢弃还在等待的协程，它们不会再被恢复
+    void Close();
+
+    // 任意线程调用，task在reactor线程执行
+    void Post(Task task);
+
+    // reactor线程调用：执行到期的定时，返回距下一次到期的毫秒数，没有定时返回-1
+    int GetNextTick();
+
+    // reactor线程收到事件时调用，fd不属于协程时返回false
+    bool OnEvent(int fd, uint32_t events);
+
+    // fd上出现events之一（或出错）时在reactor线程执行task；只等一次，任意线程调用
+    void WaitFd(int fd, uint32_t events, Task task);
+    // 关闭fd前调用，去掉注册和还没触发的等待
+    void Forget(int fd);
+
+    // co_await CoReactor::Instance()->SleepFor(ms);
+    SleepAwaiter SleepFor(int ms);
+
+private:
+    CoReactor();
+    ~CoReactor() = default;
+
+    Epoller* epoller_;
+    CompletionQueue wakeup_;
+
+    TimingWheel timer_;   // 只在reactor线程访问，tick为1毫秒
+
+    std::mutex mtx_;
+    std::unordered_map<int, Task> waiters_; // 已注册到epoll的fd，值为等待中的任务，空表示没有在等
+};
+
+class CoReactor::SleepAwaiter {
+public:
+    explicit SleepAwaiter(int ms): ms_(ms) {}
+
+    bool await_ready() const noexcept { return ms_ <= 0; }
+    void await_suspend(std::coroutine_handle<> handle);
+    void await_resume() const noexcept {}
+
+private:
+    static void OnTimeout_(void* owner, void* arg);
+
+    int ms_;
+    CoResumer resumer_;
+    TimerEntry entry_;
+};
+
+// 协程中读写非阻塞fd（如上游服务的socket），没有数据或写不进去时挂起等fd就绪
+// 对象拥有fd，析构时关闭
+class CoConn {
+public:
+    class IoAwaiter;
+
+    explicit CoConn(int fd = -1): fd_(fd) {}
+    CoConn(CoConn&& other) noexcept: fd_(other.fd_) { other.fd_ = -1; }
+    CoConn& operator=(CoConn&& other) noexcept;
+    ~CoConn() { Close(); }
+
+    int GetFd() const { return fd_; }
+    void Close();
+
+    // 读到数据返回字节数，对端关闭返回0，出错返回-errno
+    IoAwaiter read(void* buf, size_t len);
+    // 全部写完返回len，出错返回-errno
+    IoAwaiter write(const void* buf, size_t len);
+
+private:
+    int fd_;
+};
+
+class CoConn::IoAwaiter {
+public:
+    IoAwaiter(int fd, char* buf, size_t len, bool isWrite):
+        fd_(fd), buf_(buf), len_(len), done_(0), isWrite_(isWrite), result_(0) {}
+
+    bool await_ready() { return Try_(); }
+    void await_suspend(std::coroutine_handle<> handle);
+    ssize_t await_resume() const noexcept { return result_; }
+
+private:
+    bool Try_();
+    void Wait_();
+
+    int fd_;
+    char* buf_;
+    size_t len_;
+    size_t done_;
+    bool isWrite_;
+    ssize_t result_;
+    CoResumer resumer_;
+};
+
+#endif //CO_REACTOR_H
@@ -12,27 +12,75 @@ WebServer::WebServer(
             int port, int trigMode, int timeoutMS, bool OptLinger,
             int sqlPort, const char* sqlUser, const  char* sqlPwd,
             const char* dbName, int connPoolNum, int threadNum,
-            bool openLog, int logLevel, int logQueSize):
-            port_(port), openLinger_(OptLinger), timeoutMS_(timeoutMS), isClose_(false),
-            timer_(new HeapTimer()), threadpool_(new ThreadPool(threadNum)), epoller_(new Epoller())
+            bool openLog, int logLevel, int logQueSize,
+            const char* reactorCpus, const char* workerCpus, const char* logCpus, const char* userLog,
+            const char* sqlReplicas):
+            port_(port), openLinger_(OptLinger), timeoutMS_(timeoutMS),
+            limits_{ HEADER_TIMEOUT_MS, BODY_GRACE_MS, BODY_MIN_RATE, timeoutMS, WRITE_STALL_MS, timeoutMS }, isClose_(false), asyncSql_(false),
+            reactorCpus_(CpuAffinity::Parse(reactorCpus)), timer_(new TimingWheel(TIMER_SLACK_MS)), epoller_(new Epoller()),
+            router_(new Router())
     {
+    // 日志最先初始化：数据库连接池等后台线程一启动就可能写日志
+    if(openLog) { Log::Instance()->init(logLevel, "./log", ".log", logQueSize); }
+    // io通道：threadNum为常驻线程数，<=0时按可用CPU数；请求排队超时时自动加线程，最多到CPU数的MAX_THREAD_FACTOR倍
+    // reactor提交的读写任务不能丢弃，io通道不限排队
+    std::vector<int> workerSet = CpuAffinity::Parse(workerCpus);
+    size_t cpuNum = std::max<size_t>(workerSet.empty() ? CpuAffinity::Allowed().size() : workerSet.size(), 1);
+    size_t minThreads = threadNum > 0 ? threadNum : cpuNum;
+    size_t maxThreads = std::max(minThreads, cpuNum * MAX_THREAD_FACTOR);
+    lanes_[Router::LANE_IO].reset(new WorkStealingPool(minThreads, workerSet, maxThreads, TASK_WAIT_US, THREAD_IDLE_MS));
+    // db通道：线程会阻塞在数据库上，不绑核；同时访问数据库的线程数超过连接数也只是等连接，最多开连接数个
+    size_t dbThreads = std::max(connPoolNum, 1);
+    lanes_[Router::LANE_DB].reset(new WorkStealingPool(1, {}, dbThreads, TASK_WAIT_US, THREAD_IDLE_MS,
+                                                       dbThreads * DB_QUEUE_PER_CONN));
+    // cpu通道：每个CPU一个线程，和io通道共用CPU
+    lanes_[Router::LANE_CPU].reset(new WorkStealingPool(cpuNum, workerSet, cpuNum, TASK_WAIT_US, THREAD_IDLE_MS,
+                                                        CPU_QUEUE_LIMIT));
+
     // 获取项目的运行路径
     srcDir_ = getcwd(nullptr, 256);
     assert(srcDir_);
     strncat(srcDir_, "/resources", 16);
     HttpConn::userCount = 0;
     HttpConn::srcDir = srcDir_;
-    // 初始化数据库连接池
-    SqlConnPool::Instance()->Init("localhost", sqlPort, sqlUser, sqlPwd, dbName, connPoolNum);
+    HttpConn::router = router_.get();
+    // 每轮最多产生epoll_wait返回的事件数个任务（Epoller默认1024），预留后提交路径不再分配
+    readyTasks_.reserve(1024);
+    // 指定了userLog时用户存在本机的日志文件中，不连数据库；否则初始化数据库连接池
+    // 连接池的连接在后台并行建立，不等连上就继续启动；连上前/readyz报告未就绪
+    // sqlReplicas形如"host:port,host:port"，登录查询分给这些只读副本，每个副本另开connPoolNum个连接
+    // 这时登录、注册不用AsyncSqlPool
+    if(userLog) {
+        std::unique_ptr<LocalUserStore> store(new LocalUserStore(userLog));
+        if(!store->Open()) { isClose_ = true; }
+        UserService::Instance()->SetStore(std::move(store));
+    } else {
+        SqlConnPool::Instance()->Init("localhost", sqlPort, sqlUser, sqlPwd, dbName, connPoolNum);
+        SqlRouter::Instance()->Init(sqlReplicas, sqlUser, sqlPwd, dbName, connPoolNum);
+    }
+    // 客户端库支持非阻塞接口时，登录和注册的查询由reactor驱动，不占用线程
+    // 非阻塞客户端只连主库；配了副本时登录走db通道，由SqlRouter分给副本
+    if(!userLog && SqlRouter::Instance()->ReplicaCount() == 0) {
+        asyncSql_ = AsyncSqlPool::Instance()->Init(epoller_.get(), timer_.get(), "localhost", sqlPort, sqlUser, sqlPwd, dbName, connPoolNum);
+    }
+    // 协程处理函数的定时和fd等待由本线程的事件循环驱动
+    CoReactor::Instance()->Init(epoller_.get());
+    // 过期会话由reactor定期清扫
+    SweepSessions_().Detach(nullptr);
+    // 用户名布隆过滤器在db通道中建，建好前不做过滤；数据库还没连上时之后重试
+    WatchUserNames_().Detach(nullptr);
+
+    // 注册动态接口
+    InitRoutes_();
+    // 其他通道处理完的请求经completions_交回reactor
+    epoller_->AddFd(completions_.GetFd(), EPOLLIN);
 
     // 设置事件触发模式
     InitEventMode_(trigMode);
     // 初始化Socket连接
     if(!InitSocket_()) { isClose_ = true;}
 
-    // 初始化日志系统
     if(openLog) {
-        Log::Instance()->init(logLevel, "./log", ".log", logQueSize);
         if(isClose_) { LOG_ERROR("========== Server init error!=========="); }
         else {
             LOG_INFO("========== Server init ==========");
@@ -42,9 +90,30 @@ WebServer::WebServer(
                             (connEvent_ & EPOLLET ? "ET": "LT"));
             LOG_INFO("LogSys level: %d", logLevel);
             LOG_INFO("srcDir: %s", HttpConn::srcDir);
-            LOG_INFO("SqlConnPool num: %d, ThreadPool num: %d", connPoolNum, threadNum);
+            LOG_INFO("SqlConnPool num: %d, io lane: %zu-%zu threads, db lane: 1-%zu threads, cpu lane: %zu threads",
+                    connPoolNum, minThreads, maxThreads, dbThreads, cpuNum);
         }
+        InitPlacement_(logCpus, CpuAffinity::Parse(workerCpus));
+    }
+}
+
+// 日志写线程不和处理请求的线程抢CPU：没有指定时放到reactor和工作线程以外的CPU上，没有剩余CPU就不绑定
+void WebServer::InitPlacement_(const char* logCpus, const std::vector<int>& workerCpus) {
+    std::vector<int> cpus = CpuAffinity::Parse(logCpus);
+    if(cpus.empty() && (!reactorCpus_.empty() || !workerCpus.empty())) {
+        std::vector<int> serving = reactorCpus_;
+        serving.insert(serving.end(), workerCpus.begin(), workerCpus.end());
+        std::sort(serving.begin(), serving.end());
+        cpus = CpuAffinity::Exclude(serving);
+    }
+    if(!cpus.empty() && !Log::Instance()->PinWriter(cpus)) {
+        LOG_WARN("Pin log writer to CPU %s failed", CpuAffinity::ToString(cpus).c_str());
+        cpus.clear();
     }
+    LOG_INFO("CPU placement reactor: %s, workers: %s, log: %s, NUMA nodes: %d",
+            reactorCpus_.empty() ? "any" : CpuAffinity::ToString(reactorCpus_).c_str(),
+            workerCpus.empty() ? "any" : CpuAffinity::ToString(workerCpus).c_str(),
+            cpus.empty() ? "any" : CpuAffinity::ToString(cpus).c_str(), CpuAffinity::NodeCount());
 }
 
 // 关闭连接，释放内存和资源
@@ -52,7 +121,10 @@ WebServer::~WebServer() {
     close(listenFd_);
     isClose_ = true;
     free(srcDir_);
+    SqlRouter::Instance()->Close();
     SqlConnPool::Instance()->ClosePool();
+    AsyncSqlPool::Instance()->Close();
+    CoReactor::Instance()->Close();
 }
 
 // 设置事件的触发模式
@@ -113,12 +185,19 @@ void WebServer::InitEventMode_(int trigMode) {
 // 服务器通过epoll这种I/O复用技术（还有select和poll）来实现对监听socket（listenfd）和连接socket（客户请求）的同时监听
 void WebServer::Start() {
     int timeMS = -1;  /* epoll wait timeout == -1 无事件将阻塞 */
+    if(!reactorCpus_.empty() && !CpuAffinity::PinSelf(reactorCpus_)) {
+        LOG_WARN("Pin reactor to CPU %s failed", CpuAffinity::ToString(reactorCpus_).c_str());
+    }
     if(!isClose_) { LOG_INFO("========== Server start =========="); }
     while(!isClose_) {
+        timeMS = -1;
         if(timeoutMS_ > 0) {
             // 关闭超时连接并返回距下一个超时连接的时间
             timeMS = timer_->GetNextTick();
         }
+        // 协程的定时比连接超时先到时，按协程的定时等待
+        int coMS = CoReactor::Instance()->GetNextTick();
+        if(coMS >= 0 && (timeMS < 0 || coMS < timeMS)) { timeMS = coMS; }
         // 在timeMS时间内将触发的事件写入events_数组中并返回事件的数目
         int eventCnt = epoller_->Wait(timeMS);
 
@@ -133,6 +212,13 @@ void WebServer::Start() {
             if(fd == listenFd_) {
                 DealListen_();
             }
+            else if(fd == completions_.GetFd()) {
+                completions_.Run();
+            }
+            // 异步数据库连接池的socket
+            else if(asyncSql_ && AsyncSqlPool::Instance()->OnEvent(fd, events)) {}
+            // 协程等待的fd
+            else if(CoReactor::Instance()->OnEvent(fd, events)) {}
             // EPOLLERR：表示对应的文件描述符发生错误；
             // EPOLLRDHUP 表示读关闭; EPOLLHUP 表示读写都关闭。
             // 发生EPOLLRDHUP | EPOLLHUP | EPOLLERR关闭连接
@@ -140,6 +226,7 @@ void WebServer::Start() {
             // 如有异常，则直接关闭客户连接，并删除该用户的timer
             else if(events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
                 assert(users_.count(fd) > 0);
+                timer_->cancel(users_[fd].Timer());
                 CloseConn_(&users_[fd]);
             }
             // EPOLLIN事件产生的原因就是有新数据到来,此时服务端的socket可读
@@ -160,6 +247,11 @@ void WebServer::Start() {
                 LOG_ERROR("Unexpected event");
             }
         }
+        // 本轮就绪的读写任务一起交给线程池
+        if(!readyTasks_.empty()) {
+            lanes_[Router::LANE_IO]->AddTasks(readyTasks_.data(), readyTasks_.size());
+            readyTasks_.clear();
+        }
     }
 }
 
@@ -181,14 +273,40 @@ void WebServer::CloseConn_(HttpConn* client) {
     client->Close();
 }
 
+// 定时到期，在reactor线程执行：当前阶段已超时则关闭连接，否则按阶段改期
+// 已被工作线程关闭的连接不再处理，fd复用时AddClient_会重新加定时
+// 处理函数还在用请求和连接的内存区，超时只标记，由OnComplete_关闭；定时照常按检查间隔走，处理完后按发送阶段计算
+void WebServer::OnTimeout_(void* server, void* client) {
+    WebServer* self = static_cast<WebServer*>(server);
+    HttpConn* conn = static_cast<HttpConn*>(client);
+    HttpConn::PHASE phase = conn->Phase();
+    if(phase == HttpConn::PHASE_CLOSED) { return; }
+    int64_t left = conn->Deadline(self->limits_) - HttpConn::NowMs();
+    if(left > 0) {
+        self->ExtentTime_(conn);
+        return;
+    }
+    if(phase == HttpConn::PHASE_HANDLE) {
+        if(!conn->ClosePending() && conn->CloseOnComplete()) {
+            self->timeouts_[phase].fetch_add(1, std::memory_order_relaxed);
+            LOG_INFO("Client[%d] timeout in phase %d, close on complete", conn->GetFd(), phase);
+        }
+        self->timer_->adjust(conn->Timer(), PHASE_CHECK_MS);
+        return;
+    }
+    self->timeouts_[phase].fetch_add(1, std::memory_order_relaxed);
+    LOG_INFO("Client[%d] timeout in phase %d", conn->GetFd(), phase);
+    self->CloseConn_(conn);
+}
+
 /* 并将connfd注册到epoll事件表中 */
 void WebServer::AddClient_(int fd, sockaddr_in addr) {
     assert(fd > 0);
     //connfd对应HTTP连接初始化
     users_[fd].init(fd, addr);
     if(timeoutMS_ > 0) {
-        // 对socket连接设置定时器，绑定关闭连接的回调函数
-        timer_->add(fd, timeoutMS_, std::bind(&WebServer::CloseConn_, this, &users_[fd]));
+        // 对socket连接设置定时器，到期时按连接所处的阶段判断是否超时；fd复用时同一节点改期
+        timer_->add(users_[fd].Timer(), PHASE_CHECK_MS, &WebServer::OnTimeout_, this, &users_[fd]);
     }
 
     // 将HTTP连接的fd及相关事件添加到epoll对象fd中；目的就是通过这个epoll对象来监视这个HTTP连接
@@ -238,23 +356,27 @@ void WebServer::DealListen_() {
 // 线程池请求队列增加读任务
 void WebServer::DealRead_(HttpConn* client) {
     assert(client);
+    client->BeginRequest();
     ExtentTime_(client);
-    // bind绑定读任务函数和参数列表
-    threadpool_->AddTask(std::bind(&WebServer::OnRead_, this, client));
+    // 读任务先攒着，本轮事件处理完后批量提交
+    readyTasks_.emplace_back([this, client] { OnRead_(client); });
 }
 
 // 线程池请求队列增加写任务
 void WebServer::DealWrite_(HttpConn* client) {
     assert(client);
     ExtentTime_(client);
-    // bind绑定写任务函数和参数列表
-    threadpool_->AddTask(std::bind(&WebServer::OnWrite_, this, client));
+    // 写任务先攒着，本轮事件处理完后批量提交
+    readyTasks_.emplace_back([this, client] { OnWrite_(client); });
 }
 
-// 刷新HTTP连接事件的定时器时间
+// 按连接当前阶段的截止时刻改期；空闲连接只会经读事件离开空闲，可以直接定到截止时刻
 void WebServer::ExtentTime_(HttpConn* client) {
     assert(client);
-    if(timeoutMS_ > 0) { timer_->adjust(client->GetFd(), timeoutMS_); }
+    if(timeoutMS_ <= 0) { return; }
+    int64_t left = std::max<int64_t>(client->Deadline(limits_) - HttpConn::NowMs(), 0);
+    if(client->Phase() != HttpConn::PHASE_IDLE) { left = std::min<int64_t>(left, PHASE_CHECK_MS); }
+    timer_->adjust(client->Timer(), static_cast<int>(std::min<int64_t>(left, INT_MAX)));
 }
 
 void WebServer::OnRead_(HttpConn* client) {
@@ -272,15 +394,246 @@ void WebServer::OnRead_(HttpConn* client) {
 
 // 处理HTTP请求并生成响应报文
 void WebServer::OnProcess(HttpConn* client) {
-    if(client->process()) {
+    switch(client->process())
+    {
+    case HttpConn::PROCESS_DONE:
         // 成功生成响应报文，修改已经注册的fd的监听事件为写事件
         epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLOUT);
-    } else {
-        // 读缓冲没有内容；修改已经注册的fd的监听事件为读事件
+        break;
+    case HttpConn::PROCESS_DEFER:
+        OnDefer_(client);
+        break;
+    default:
+        // 读缓冲没有内容或请求没收完；修改已经注册的fd的监听事件为读事件
         epoller_->ModFd(client->GetFd(), connEvent_ | EPOLLIN);
+        break;
     }
 }
 
+// 按路由的执行方式运行处理函数，完成后交回reactor
+// 通道排队已满时直接回503，不让积压拖慢其他请求
+// EPOLLONESHOT保证处理期间该连接不会再触发事件
+void WebServer::OnDefer_(HttpConn* client) {
+    const Router::Route* route = client->route();
+    assert(route);
+    if(route->policy == Router::POOL) {
+        bool queued = lanes_[route->lane]->TryAddTask([this, client] {
+            client->Handle();
+            OnComplete_(client);
+        });
+        if(!queued) {
+            LOG_WARN("Client[%d] rejected, lane %d is full", client->GetFd(), route->lane);
+            if(client->Reject(503)) {
+                OnWrite_(client);
+            } else {
+                CloseConn_(client);
+            }
+        }
+    } else {
+        client->HandleAsync([this, client] { OnComplete_(client); });
+    }
+}
+
+// 处理函数所在的线程只负责把连接交回reactor，生成响应和发送由reactor派给io通道
+// 处理期间被要求关闭（如超时）的连接在这里关闭，不再发送
+void WebServer::OnComplete_(HttpConn* client) {
+    completions_.Post([this, client] {
+        readyTasks_.emplace_back([this, client] {
+            if(client->Finish()) {
+                OnWrite_(client);
+            } else {
+                CloseConn_(client);
+            }
+        });
+    });
+}
+
+// 循环停在SleepFor上；reactor关闭时不再恢复，帧随进程退出回收
+CoTask<> WebServer::SweepSessions_() {
+    while(true) {
+        co_await CoReactor::Instance()->SleepFor(SESSION_SWEEP_MS);
+        size_t removed = SessionStore::Instance()->Sweep();
+        if(removed) { LOG_DEBUG("Sweep %zu expired sessions", removed); }
+    }
+}
+
+// 启动时立即读一次；读失败的按间隔加倍重试，免得数据库长时间不可用时反复占着db通道的线程等连接
+// 重建期间旧的过滤器照常使用；上一次还没建完时NeedsNames为false
+CoTask<> WebServer::WatchUserNames_() {
+    int waitMs = NAMES_CHECK_MS;
+    while(true) {
+        if(UserService::Instance()->NeedsNames()) {
+            lanes_[Router::LANE_DB]->TryAddTask([] { UserService::Instance()->LoadNames(); });
+        }
+        co_await CoReactor::Instance()->SleepFor(waitMs);
+        waitMs = UserService::Instance()->NeedsNames() ? std::min(waitMs * 2, NAMES_RETRY_MAX_MS) : NAMES_CHECK_MS;
+    }
+}
+
+// 注册动态接口；登录、注册会访问数据库：有非阻塞客户端时由协程异步查询，否则登录放到db通道执行，注册等合批写入时不占线程
+// 用户存在本机日志中时查询只是查内存，直接在解析请求的线程执行
+// 登录、注册成功后下发会话cookie，之后的请求凭cookie在内存中校验
+void WebServer::InitRoutes_() {
+    // 不设Max-Age：浏览器关闭前一直带着，有效期由服务端滑动计算
+    // 建不了会话时照常回复，只是不下发cookie，之后的请求按未登录处理
+    auto startSession = [](const std::string& user, HttpResponse& resp) {
+        std::string token = SessionStore::Instance()->Create(user);
+        if(token.empty()) { return; }
+        resp.AddHeader("Set-Cookie", std::string(SessionStore::COOKIE_NAME) + "=" + token + "; Path=/; HttpOnly; SameSite=Lax");
+    };
+    auto verify = [startSession](bool isLogin) {
+        return [isLogin, startSession](HttpRequest& req, HttpResponse& resp) {
+            std::string name = req.GetPost("username");
+            if(UserService::Instance()->Verify(name, req.GetPost("password"), isLogin)) {
+                startSession(name, resp);
+                resp.SetPath("/welcome.html");
+            } else {
+                resp.SetPath("/error.html");
+            }
+        };
+    };
+    auto verifyAsync = [startSession](bool isLogin) {
+        return [isLogin, startSession](HttpRequest& req, HttpResponse& resp) -> CoTask<> {
+            std::string name = req.GetPost("username");
+            bool ok = co_await UserService::Instance()->VerifyAsync(name, req.GetPost("password"), isLogin);
+            if(ok) { startSession(name, resp); }
+            resp.SetPath(ok ? "/welcome.html" : "/error.html");
+        };
+    };
+    // 注册的写入由存储后端合批，处理函数不等写入：写完后在后端的线程调用done，连接经OnComplete_交回reactor
+    // 存储会查库时查重放到db通道，db通道的线程只在查重期间被占用，一批能攒的注册不受线程数限制
+    auto registerAsync = [this, startSession](bool blocking) {
+        return [this, blocking, startSession](HttpRequest& req, HttpResponse& resp, const Router::DoneCallBack& done) {
+            UserStore::Callback finish = [name = req.GetPost("username"), &resp, done, startSession](bool ok) {
+                if(ok) { startSession(name, resp); }
+                resp.SetPath(ok ? "/welcome.html" : "/error.html");
+                done();
+            };
+            if(!blocking) {
+                UserService::Instance()->Register(req.GetPost("username"), req.GetPost("password"), std::move(finish));
+                return;
+            }
+            // 请求在done之前一直有效；回调放不进Task，移到堆上
+            auto check = [&req, finish = std::make_unique<UserStore::Callback>(std::move(finish))] {
+                UserService::Instance()->Register(req.GetPost("username"), req.GetPost("password"), std::move(*finish));
+            };
+            if(!lanes_[Router::LANE_DB]->TryAddTask(std::move(check))) {
+                LOG_WARN("Register rejected, lane %d is full", Router::LANE_DB);
+                resp.SetCode(503);
+                done();
+            }
+        };
+    };
+    if(asyncSql_) {
+        router_->AddCo("POST", "/login.html", verifyAsync(true));
+        router_->AddCo("POST", "/register.html", verifyAsync(false));
+    } else if(!UserService::Instance()->Store()->IsBlocking()) {
+        router_->Add("POST", "/login.html", verify(true));
+        router_->AddAsync("POST", "/register.html", registerAsync(false));
+    } else {
+        router_->Add("POST", "/login.html", verify(true), Router::POOL, Router::LANE_DB);
+        router_->AddAsync("POST", "/register.html", registerAsync(true));
+    }
+    // 存活：事件循环还在响应；就绪：用户存储可用（数据库至少连上了预热的连接数），可以接流量
+    router_->Add("GET", "/healthz", [](HttpRequest&, HttpResponse& resp) {
+        resp.SetContent("{\"status\":\"ok\"}", "Content-type: application/json\r\n");
+    });
+    router_->Add("GET", "/readyz", [this](HttpRequest&, HttpResponse& resp) {
+        bool ready = !isClose_ && UserService::Instance()->Store()->IsReady();
+        if(!ready) { resp.SetCode(503); }
+        resp.SetContent(std::string("{\"ready\":") + (ready ? "true" : "false") + "}", "Content-type: application/json\r\n");
+    });
+    router_->Add("GET", "/api/session", [](HttpRequest& req, HttpResponse& resp) {
+        std::string user;
+        if(!SessionStore::Instance()->Touch(req.GetCookie(SessionStore::COOKIE_NAME), &user)) {
+            resp.SetCode(401);
+            resp.SetContent("{\"error\":\"not logged in\"}", "Content-type: application/json\r\n");
+            return;
+        }
+        std::string json = "{\"user\":\"";
+        for(char ch : user) {
+            if(ch == '"' || ch == '\\') { json += '\\'; }
+            if(static_cast<unsigned char>(ch) >= 0x20) { json += ch; }
+        }
+        resp.SetContent(json + "\"}", "Content-type: application/json\r\n");
+    });
+    router_->Add("POST", "/logout", [](HttpRequest& req, HttpResponse& resp) {
+        SessionStore::Instance()->Remove(req.GetCookie(SessionStore::COOKIE_NAME));
+        resp.AddHeader("Set-Cookie", std::string(SessionStore::COOKIE_NAME) + "=; Path=/; Max-Age=0");
+        resp.SetPath("/login.html");
+    });
+
+    router_->Add("GET", "/api/metrics", [this](HttpRequest&, HttpResponse& resp) {
+        static const char* LANE_NAMES[Router::LANE_COUNT] = { "io", "db", "cpu" };
+        static const char* PHASE_NAMES[HttpConn::PHASE_CLOSED] = { "header", "body", "handle", "write", "keepAlive" };
+        std::string timeouts;
+        for(int i = 0; i < HttpConn::PHASE_CLOSED; i++) {
+            timeouts += std::string(i ? "," : "") + "\"" + PHASE_NAMES[i] + "\":" + std::to_string(timeouts_[i].load());
+        }
+        std::string lanes;
+        for(int i = 0; i < Router::LANE_COUNT; i++) {
+            WorkStealingPool::Stats pool = lanes_[i]->GetStats();
+            lanes += std::string(i ? "," : "") + "\"" + LANE_NAMES[i] + "\":{\"threads\":" + std::to_string(pool.threads) +
+                     ",\"minThreads\":" + std::to_string(pool.minThreads) +
+                     ",\"maxThreads\":" + std::to_string(pool.maxThreads) +
+                     ",\"tasks\":" + std::to_string(pool.tasks) +
+                     ",\"avgWaitUs\":" + std::to_string(pool.avgWaitUs) +
+                     ",\"avgRunUs\":" + std::to_string(pool.avgRunUs) +
+                     ",\"maxWaitUs\":" + std::to_string(pool.maxWaitUs) +
+                     ",\"recentWaitUs\":" + std::to_string(pool.recentWaitUs) +
+                     ",\"grown\":" + std::to_string(pool.grown) +
+                     ",\"retired\":" + std::to_string(pool.retired) +
+                     ",\"queued\":" + std::to_string(pool.queued) +
+                     ",\"queueLimit\":" + std::to_string(pool.queueLimit) +
+                     ",\"rejected\":" + std::to_string(pool.rejected) + "}";
+        }
+        SqlConnPool::Stats sql = SqlConnPool::Instance()->GetStats();
+        SqlRouter::Stats routing = SqlRouter::Instance()->GetStats();
+        UserService::Stats users = UserService::Instance()->GetStats();
+        std::string waitHist;
+        for(size_t i = 0; i < sql.waitHist.size(); i++) {
+            waitHist += std::string(i ? "," : "") + std::to_string(sql.waitHist[i]);
+        }
+        std::string replicas;
+        for(size_t i = 0; i < routing.replicas.size(); i++) {
+            const SqlRouter::ReplicaStats& replica = routing.replicas[i];
+            replicas += std::string(i ? "," : "") + "{\"host\":\"" + replica.host + ":" + std::to_string(replica.port) + "\"" +
+                        ",\"healthy\":" + (replica.healthy ? "true" : "false") +
+                        ",\"lagS\":" + std::to_string(replica.lagS) +
+                        ",\"reads\":" + std::to_string(replica.reads) +
+                        ",\"free\":" + std::to_string(replica.pool.free) +
+                        ",\"broken\":" + std::to_string(replica.pool.broken) +
+                        ",\"timeouts\":" + std::to_string(replica.pool.timeouts) + "}";
+        }
+        resp.SetContent("{\"userCount\":" + std::to_string(HttpConn::userCount.load()) +
+                        ",\"bufferBytes\":" + std::to_string(HttpConn::bufferBytes.load()) +
+                        ",\"timeouts\":{" + timeouts + "}" +
+                        ",\"lanes\":{" + lanes + "}" +
+                        ",\"sql\":{\"total\":" + std::to_string(sql.total) +
+                        ",\"free\":" + std::to_string(sql.free) +
+                        ",\"inUse\":" + std::to_string(sql.inUse) +
+                        ",\"broken\":" + std::to_string(sql.broken) +
+                        ",\"unopened\":" + std::to_string(sql.unopened) +
+                        ",\"waiting\":" + std::to_string(sql.waiting) +
+                        ",\"acquired\":" + std::to_string(sql.acquired) +
+                        ",\"timeouts\":" + std::to_string(sql.timeouts) +
+                        ",\"reconnects\":" + std::to_string(sql.reconnects) +
+                        ",\"waitHistUs\":[" + waitHist + "]" +
+                        ",\"primaryReads\":" + std::to_string(routing.primaryReads) +
+                        ",\"stickyReads\":" + std::to_string(routing.stickyReads) +
+                        ",\"replicas\":[" + replicas + "]}" +
+                        ",\"users\":{\"cached\":" + std::to_string(users.cached) +
+                        ",\"cacheHits\":" + std::to_string(users.cacheHits) +
+                        ",\"bloomSkips\":" + std::to_string(users.bloomSkips) +
+                        ",\"registerBatches\":" + std::to_string(users.store.writeBatches) +
+                        ",\"registerRows\":" + std::to_string(users.store.writtenRows) +
+                        ",\"compactions\":" + std::to_string(users.store.compactions) +
+                        ",\"logBytes\":" + std::to_string(users.store.logBytes) +
+                        ",\"sessions\":" + std::to_string(SessionStore::Instance()->Size()) + "}}",
+                        "Content-type: application/json\r\n");
+    });
+}
+
 void WebServer::OnWrite_(HttpConn* client) {
     assert(client);
     int ret = -1;
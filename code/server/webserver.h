@@ -7,6 +7,7 @@
 #define WEBSERVER_H
 
 #include <unordered_map>
+#include <algorithm>
 #include <fcntl.h>       // fcntl()
 #include <unistd.h>      // close()
 #include <assert.h>
@@ -16,12 +17,21 @@
 #include <arpa/inet.h>
 
 #include "epoller.h"
+#include "completionqueue.h"
+#include "coreactor.h"
 #include "../log/log.h"
-#include "../timer/heaptimer.h"
+#include "../timer/timingwheel.h"
 #include "../pool/sqlconnpool.h"
-#include "../pool/threadpool.h"
+#include "../pool/workstealingpool.h"
 #include "../pool/sqlconnRAII.h"
+#include "../pool/asyncsqlpool.h"
+#include "../pool/sqlrouter.h"
+#include "../pool/affinity.h"
 #include "../http/httpconn.h"
+#include "../http/router.h"
+#include "../user/userservice.h"
+#include "../user/sessionstore.h"
+#include "../user/localuserstore.h"
 
 class WebServer {
 public:
@@ -29,7 +39,10 @@ public:
         int port, int trigMode, int timeoutMS, bool OptLinger, 
         int sqlPort, const char* sqlUser, const  char* sqlPwd, 
         const char* dbName, int connPoolNum, int threadNum,
-        bool openLog, int logLevel, int logQueSize);
+        bool openLog, int logLevel, int logQueSize,
+        const char* reactorCpus = nullptr, const char* workerCpus = nullptr,
+        const char* logCpus = nullptr, const char* userLog = nullptr,
+        const char* sqlReplicas = nullptr);
 
     ~WebServer();
     void Start();
@@ -46,31 +59,70 @@ private:
     void SendError_(int fd, const char*info);
     void ExtentTime_(HttpConn* client);
     void CloseConn_(HttpConn* client);
+    static void OnTimeout_(void* server, void* client);
 
     void OnRead_(HttpConn* client);
     void OnWrite_(HttpConn* client);
     void OnProcess(HttpConn* client);
+    void OnDefer_(HttpConn* client);
+    void OnComplete_(HttpConn* client);
+
+    void InitRoutes_();
+    void InitPlacement_(const char* logCpus, const std::vector<int>& workerCpus);
+    // 定期删除过期会话，在reactor线程运行
+    static CoTask<> SweepSessions_();
+    // 用户名过滤器没建成或装满时交给db通道（重新）建，在reactor线程运行
+    CoTask<> WatchUserNames_();
 
     static const int MAX_FD = 65536;
+    static const size_t MAX_THREAD_FACTOR = 4;  // 线程池最多线程数是CPU数的倍数，留给阻塞在数据库上的线程
+    static const int TASK_WAIT_US = 2000;       // 任务排队时间目标，持续超过时加线程
+    static const int THREAD_IDLE_MS = 30000;    // 多出的线程空闲这么久后退出
+    static const size_t DB_QUEUE_PER_CONN = 32; // db通道每个数据库连接允许排队的请求数
+    static const size_t CPU_QUEUE_LIMIT = 1024;
+    static const int SESSION_SWEEP_MS = 60000;
+    static const int NAMES_CHECK_MS = 1000;     // 多久检查一次用户名过滤器是否要重建
+    static constexpr int NAMES_RETRY_MAX_MS = 60000; // 读用户名失败后重试的间隔逐次加倍，最长这么久
+    static const int TIMER_SLACK_MS = 10;       // 连接超时的误差，同一误差内到期的连接一起关闭
+    // 分阶段的超时，防止慢速发送头部/请求体、慢速读取响应的客户端长期占用连接；长连接空闲和处理函数用timeoutMS
+    // 处理函数超时不关闭连接，只标记为完成后关闭
+    static const int HEADER_TIMEOUT_MS = 10000; // 请求行和头部要在这段时间内收完
+    static const int BODY_GRACE_MS = 5000;      // 请求体开头的宽限，之后平均速率不能低于BODY_MIN_RATE
+    static const int BODY_MIN_RATE = 1024;      // 字节/秒
+    static const int WRITE_STALL_MS = 10000;    // 发送响应时连续这么久发不出数据
+    static const int PHASE_CHECK_MS = 1000;     // 阶段在工作线程中切换，非空闲的连接至少隔这么久按当前阶段重算一次
 
     static int SetFdNonblock(int fd);
 
     int port_;
     bool openLinger_;
-    int timeoutMS_;  /* 毫秒MS */
+    int timeoutMS_;  /* 长连接空闲超时，毫秒MS；<=0时不做任何超时 */
+    HttpConn::Timeouts limits_;  /* 各阶段的超时，由上面的常量和timeoutMS组成 */
     bool isClose_;
+    bool asyncSql_;  /* 登录、注册是否使用AsyncSqlPool */
     int listenFd_;
     char* srcDir_;
     
+    // 调用Start()的线程（reactor）绑定的CPU，为空不绑定
+    std::vector<int> reactorCpus_;
+
     uint32_t listenEvent_;
     uint32_t connEvent_;
    
-    // 定时器
-    std::unique_ptr<HeapTimer> timer_;
-    // 线程池
-    std::unique_ptr<ThreadPool> threadpool_;
+    // 连接超时的时间轮，节点嵌在各连接里
+    std::unique_ptr<TimingWheel> timer_;
+    // 各阶段超时关闭的连接数，下标为HttpConn::PHASE；只在reactor线程累加
+    std::array<std::atomic<uint64_t>, HttpConn::PHASE_CLOSED> timeouts_;
+    // 各执行通道的线程池，工作窃取调度；下标为Router::EXEC_LANE
+    std::array<std::unique_ptr<WorkStealingPool>, Router::LANE_COUNT> lanes_;
+    // 执行通道交回reactor的收尾任务
+    CompletionQueue completions_;
+    // 一次epoll_wait产生的读写任务，处理完所有事件后一次提交；clear()保留容量
+    std::vector<Task> readyTasks_;
     // 使用epoll来做I/O事件触发
     std::unique_ptr<Epoller> epoller_;
+    // 动态接口的路由表，没有命中的请求按静态文件处理
+    std::unique_ptr<Router> router_;
     // listenfd得到的socket文件描述符和HTTP连接的映射表关系
     std::unordered_map<int, HttpConn> users_;
 };
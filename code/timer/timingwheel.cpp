@@ -0,0 +1,175 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "timingwheel.h"
+
+#include <climits>
+#include <algorithm>
+
+using namespace std;
+using namespace std::chrono;
+
+TimingWheel::TimingWheel(int tickMs): tickMs_(tickMs > 0 ? tickMs : 1), base_(steady_clock::now()),
+    now_(0), size_(0) {
+    for(auto& level : slots_) {
+        for(TimerEntry& head : level) { Init_(&head); }
+    }
+}
+
+int64_t TimingWheel::NowMs_() const {
+    return duration_cast<milliseconds>(steady_clock::now() - base_).count();
+}
+
+void TimingWheel::Unlink_(TimerEntry* entry) {
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+    entry->prev = entry->next = nullptr;
+}
+
+void TimingWheel::PushBack_(TimerEntry* head, TimerEntry* entry) {
+    entry->prev = head->prev;
+    entry->next = head;
+    head->prev->next = entry;
+    head->prev = entry;
+}
+
+void TimingWheel::Move_(TimerEntry* from, TimerEntry* to) {
+    if(Empty_(from)) { return; }
+    to->next = from->next;
+    to->prev = from->prev;
+    to->next->prev = to;
+    to->prev->next = to;
+    Init_(from);
+}
+
+// 按与now_的差选层：差小于64个tick放第0层，小于64*64放第1层，以此类推
+void TimingWheel::Insert_(TimerEntry* entry) {
+    uint64_t expires = entry->expires < now_ ? now_ : entry->expires;
+    uint64_t delta = expires - now_;
+    if(delta >= SPAN) {
+        expires = now_ + SPAN - 1;
+        delta = SPAN - 1;
+    }
+    int level = 0;
+    while(delta >= (uint64_t(1) << (BITS * (level + 1)))) { level++; }
+    PushBack_(&slots_[level][(expires >> (BITS * level)) & MASK], entry);
+}
+
+void TimingWheel::add(TimerEntry* entry, int timeout, TimerEntry::Callback cb, void* owner, void* arg) {
+    assert(entry && cb);
+    entry->cb = cb;
+    entry->owner = owner;
+    entry->arg = arg;
+    adjust(entry, timeout);
+}
+
+// 到期tick向上取整，节点不会早于timeout触发，最多晚一个tick
+void TimingWheel::adjust(TimerEntry* entry, int timeout) {
+    assert(entry && entry->cb);
+    int64_t expiresMs = NowMs_() + max(timeout, 0);
+    uint64_t expires = (expiresMs + tickMs_ - 1) / tickMs_;
+    if(entry->Pending()) {
+        //频繁刷新的连接大多落在同一个tick，不用动链表
+        if(entry->expires == expires) { return; }
+        Unlink_(entry);
+    } else {
+        size_++;
+    }
+    entry->expires = expires;
+    Insert_(entry);
+}
+
+void TimingWheel::cancel(TimerEntry* entry) {
+    assert(entry);
+    if(!entry->Pending()) { return; }
+    Unlink_(entry);
+    size_--;
+}
+
+void TimingWheel::clear() {
+    for(auto& level : slots_) {
+        for(TimerEntry& head : level) {
+            while(!Empty_(&head)) { Unlink_(head.next); }
+        }
+    }
+    size_ = 0;
+}
+
+// now_走到上一层一个槽的开头时，把那个槽的节点按剩余时间放回下面的层
+void TimingWheel::Cascade_() {
+    for(int level = 1; level < LEVELS; level++) {
+        uint64_t idx = (now_ >> (BITS * level)) & MASK;
+        TimerEntry list;
+        Init_(&list);
+        Move_(&slots_[level][idx], &list);
+        while(!Empty_(&list)) {
+            TimerEntry* entry = list.next;
+            Unlink_(entry);
+            Insert_(entry);
+        }
+        if(idx != 0) { break; }
+    }
+}
+
+void TimingWheel::tick() {
+    uint64_t target = NowMs_() / tickMs_;
+    while(now_ <= target) {
+        if(size_ == 0) {
+            now_ = target + 1;
+            break;
+        }
+        if((now_ & MASK) == 0) { Cascade_(); }
+        // 整槽摘下后再推进now_，回调里新加入的节点不会在本轮被处理
+        TimerEntry expired;
+        Init_(&expired);
+        Move_(&slots_[0][now_ & MASK], &expired);
+        now_++;
+        while(!Empty_(&expired)) {
+            TimerEntry* entry = expired.next;
+            Unlink_(entry);
+            // 曾超出轮子范围、还没到真正到期时间的节点
+            if(entry->expires >= now_) {
+                Insert_(entry);
+                continue;
+            }
+            size_--;
+            entry->cb(entry->owner, entry->arg);
+        }
+    }
+}
+
+// 第0层的节点给出准确的到期tick，上层的节点以下放的tick为准，醒来后下放再算
+uint64_t TimingWheel::NextTick_() const {
+    uint64_t next = UINT64_MAX;
+    for(uint64_t i = 0; i < SLOTS; i++) {
+        if(!Empty_(&slots_[0][(now_ + i) & MASK])) {
+            next = now_ + i;
+            break;
+        }
+    }
+    for(int level = 1; level < LEVELS; level++) {
+        int shift = BITS * level;
+        // 第一个不早于now_、对齐到本层一个槽的tick，这时下放该槽
+        uint64_t start = ((now_ + (uint64_t(1) << shift) - 1) >> shift);
+        for(uint64_t i = 0; i < SLOTS; i++) {
+            uint64_t at = (start + i) << shift;
+            if(at >= next) { break; }
+            if(!Empty_(&slots_[level][(start + i) & MASK])) {
+                next = at;
+                break;
+            }
+        }
+    }
+    return next;
+}
+
+int TimingWheel::GetNextTick() {
+    tick();
+    uint64_t next = size_ ? NextTick_() : UINT64_MAX;
+    if(next == UINT64_MAX) { return -1; }
+    int64_t ms = int64_t(next) * tickMs_ - NowMs_();
+    if(ms < 0) { ms = 0; }
+    return ms > INT_MAX ? INT_MAX : static_cast<int>(ms);
+}
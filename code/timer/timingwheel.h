@@ -0,0 +1,88 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <chrono>
+#include <stdint.h>
+#include <assert.h>
+
+// 定时节点，嵌在需要定时的对象里（如连接），轮子只串链表，不分配内存也不保存回调对象
+// 到期时节点先摘下再调用cb(owner, arg)，回调里可以重新加入或销毁节点
+struct TimerEntry {
+    typedef void (*Callback)(void* owner, void* arg);
+
+    TimerEntry() = default;
+    // 节点的地址挂在链表上，不能复制
+    TimerEntry(const TimerEntry&) = delete;
+    TimerEntry& operator=(const TimerEntry&) = delete;
+
+    bool Pending() const { return next != nullptr; }
+
+    TimerEntry* prev = nullptr;
+    TimerEntry* next = nullptr;
+    uint64_t expires = 0;   // 到期的tick
+    Callback cb = nullptr;
+    void* owner = nullptr;
+    void* arg = nullptr;
+};
+
+// 分层时间轮：4层、每层64个槽，第0层一个槽是一个tick，上一层一个槽是下一层一圈
+// 加入、取消、改期都只是链表操作；到期时间按tick向上取整，同一tick内到期的一起处理，tick就是允许的误差
+// 超出轮子范围的节点先放在最高层，逐层下放时按真实到期时间重新放置
+// 非线程安全，只在一个线程（reactor）使用
+class TimingWheel {
+public:
+    explicit TimingWheel(int tickMs = 1);
+    // 节点归各自的对象所有，可能已先于轮子析构，这里不再访问
+    ~TimingWheel() = default;
+
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+
+    // timeout毫秒后调用cb(owner, arg)；节点已在轮中时改为新的到期时间
+    void add(TimerEntry* entry, int timeout, TimerEntry::Callback cb, void* owner, void* arg = nullptr);
+    // 沿用上次的回调，改为timeout毫秒后到期
+    void adjust(TimerEntry* entry, int timeout);
+    // 不在轮中时什么也不做
+    void cancel(TimerEntry* entry);
+    // 摘下所有节点，不调用回调
+    void clear();
+    // 执行到期的节点
+    void tick();
+    // 执行到期的节点，返回距下一次要处理的毫秒数，没有节点返回-1
+    int GetNextTick();
+
+    size_t size() const { return size_; }
+    int TickMs() const { return tickMs_; }
+
+private:
+    static const int LEVELS = 4;
+    static const int BITS = 6;
+    static const uint64_t SLOTS = 1 << BITS;
+    static const uint64_t MASK = SLOTS - 1;
+    static const uint64_t SPAN = uint64_t(1) << (BITS * LEVELS); // 轮子能表示的最大tick差
+
+    int64_t NowMs_() const;
+    void Insert_(TimerEntry* entry);
+    void Cascade_();
+    uint64_t NextTick_() const;
+
+    static void Init_(TimerEntry* head) { head->prev = head->next = head; }
+    static bool Empty_(const TimerEntry* head) { return head->next == head; }
+    static void Unlink_(TimerEntry* entry);
+    static void PushBack_(TimerEntry* head, TimerEntry* entry);
+    // 把from整条链表接到to（空链表）上
+    static void Move_(TimerEntry* from, TimerEntry* to);
+
+    const int tickMs_;
+    const std::chrono::steady_clock::time_point base_;
+    uint64_t now_;      // 下一个还没处理的tick
+    size_t size_;
+    TimerEntry slots_[LEVELS][SLOTS];   // 每个槽是一个带头节点的环形链表
+};
+
+#endif //TIMING_WHEEL_H
@@ -0,0 +1,53 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "bloomfilter.h"
+
+#include <algorithm>
+
+BloomFilter::BloomFilter(size_t expected, size_t bitsPerItem, int hashes): hashes_(std::max(hashes, 1)) {
+    size_t bits = 64;
+    while(bits < std::max<size_t>(expected, 1) * bitsPerItem) { bits <<= 1; }
+    mask_ = bits - 1;
+    words_.reset(new std::atomic<uint64_t>[bits / 64]);
+    for(size_t i = 0; i < bits / 64; i++) {
+        words_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+//FNV-1a，再用splitmix64的混合步骤得到第二个哈希
+void BloomFilter::Hash_(std::string_view key, uint64_t& h1, uint64_t& h2) {
+    uint64_t h = 14695981039346656037ULL;
+    for(unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    h1 = h;
+    h += 0x9e3779b97f4a7c15ULL;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    h2 = (h ^ (h >> 31)) | 1;   //奇数步长，各位置不会重合
+}
+
+void BloomFilter::Add(std::string_view key) {
+    uint64_t h1, h2;
+    Hash_(key, h1, h2);
+    for(int i = 0; i < hashes_; i++) {
+        size_t bit = (h1 + i * h2) & mask_;
+        words_[bit / 64].fetch_or(uint64_t(1) << (bit % 64), std::memory_order_relaxed);
+    }
+}
+
+bool BloomFilter::MayContain(std::string_view key) const {
+    uint64_t h1, h2;
+    Hash_(key, h1, h2);
+    for(int i = 0; i < hashes_; i++) {
+        size_t bit = (h1 + i * h2) & mask_;
+        if(!(words_[bit / 64].load(std::memory_order_relaxed) & (uint64_t(1) << (bit % 64)))) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,37 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+// 布隆过滤器：MayContain返回false时一定没加过，返回true时可能是误判
+// 位数组按原子字读写，Add和MayContain可以在任意线程同时调用，不加锁
+class BloomFilter {
+public:
+    // 按预计元素数和每个元素占的位数定大小，位数取2的幂；10位、7个哈希时误判率约1%
+    explicit BloomFilter(size_t expected, size_t bitsPerItem = 10, int hashes = 7);
+
+    void Add(std::string_view key);
+    bool MayContain(std::string_view key) const;
+
+    size_t Bits() const { return mask_ + 1; }
+
+private:
+    // 两个独立的哈希按h1 + i*h2组合出各个位置
+    static void Hash_(std::string_view key, uint64_t& h1, uint64_t& h2);
+
+    size_t mask_;
+    int hashes_;
+    std::unique_ptr<std::atomic<uint64_t>[]> words_;
+};
+
+#endif //BLOOM_FILTER_H
@@ -0,0 +1,106 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "credentialcache.h"
+
+#include <random>
+#include <algorithm>
+
+using namespace std;
+using namespace std::chrono;
+
+CredentialCache::CredentialCache(size_t capacity, int ttlMs):
+    shardCapacity_(max<size_t>(capacity / SHARDS, 1)), ttl_(ttlMs) {}
+
+Sha256::Digest CredentialCache::Digest_(const uint8_t* salt, string_view pwd) {
+    Sha256 sha;
+    sha.Update(salt, SALT_SIZE);
+    sha.Update(pwd);
+    return sha.Final();
+}
+
+CredentialCache::Shard& CredentialCache::ShardOf_(string_view name) {
+    return shards_[hash<string_view>()(name) % SHARDS];
+}
+
+CredentialCache::Entry* CredentialCache::Find_(Shard& shard, string_view name) {
+    auto it = shard.index.find(name);
+    if(it == shard.index.end()) { return nullptr; }
+    auto node = it->second;
+    if(node->expires <= steady_clock::now()) {
+        shard.index.erase(it);
+        shard.lru.erase(node);
+        return nullptr;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, node);
+    return &*node;
+}
+
+CredentialCache::Result CredentialCache::Check(string_view name, string_view pwd) {
+    uint8_t salt[SALT_SIZE];
+    Sha256::Digest digest;
+    {
+        Shard& shard = ShardOf_(name);
+        lock_guard<mutex> locker(shard.mtx);
+        Entry* entry = Find_(shard, name);
+        if(!entry) { return MISS; }
+        copy(entry->salt, entry->salt + SALT_SIZE, salt);
+        digest = entry->digest;
+    }
+    //计算摘要不占分片锁
+    Sha256::Digest given = Digest_(salt, pwd);
+    return Sha256::Equal(digest.data(), given.data()) ? MATCH : MISMATCH;
+}
+
+bool CredentialCache::Contains(string_view name) {
+    Shard& shard = ShardOf_(name);
+    lock_guard<mutex> locker(shard.mtx);
+    return Find_(shard, name) != nullptr;
+}
+
+void CredentialCache::Put(string_view name, string_view pwd) {
+    //盐只需各不相同，线程各自的随机数发生器即可
+    static thread_local mt19937_64 rng(random_device{}());
+    Entry entry;
+    entry.name = name;
+    for(size_t i = 0; i < SALT_SIZE; i += 8) {
+        uint64_t r = rng();
+        copy_n(reinterpret_cast<uint8_t*>(&r), min<size_t>(8, SALT_SIZE - i), entry.salt + i);
+    }
+    entry.digest = Digest_(entry.salt, pwd);
+    entry.expires = steady_clock::now() + ttl_;
+
+    Shard& shard = ShardOf_(name);
+    lock_guard<mutex> locker(shard.mtx);
+    auto it = shard.index.find(name);
+    if(it != shard.index.end()) {
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+    }
+    else if(shard.lru.size() >= shardCapacity_) {
+        shard.index.erase(shard.lru.back().name);
+        shard.lru.pop_back();
+    }
+    shard.lru.push_front(move(entry));
+    shard.index.emplace(shard.lru.front().name, shard.lru.begin());
+}
+
+void CredentialCache::Erase(string_view name) {
+    Shard& shard = ShardOf_(name);
+    lock_guard<mutex> locker(shard.mtx);
+    auto it = shard.index.find(name);
+    if(it == shard.index.end()) { return; }
+    shard.lru.erase(it->second);
+    shard.index.erase(it);
+}
+
+size_t CredentialCache::Size() {
+    size_t size = 0;
+    for(Shard& shard : shards_) {
+        lock_guard<mutex> locker(shard.mtx);
+        size += shard.lru.size();
+    }
+    return size;
+}
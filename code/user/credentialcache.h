@@ -0,0 +1,64 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+
+#ifndef CREDENTIAL_CACHE_H
+#define CREDENTIAL_CACHE_H
+
+#include <list>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "sha256.h"
+
+// 已经和数据库核对过的用户名和口令，登录时先在这里比对
+// 只存加盐的SHA-256摘要，不存明文；每个用户名一个随机盐
+// 按用户名哈希分片，每片一把锁、一条LRU链，超过容量淘汰最久没用的；超过ttl的条目视为不存在
+class CredentialCache {
+public:
+    enum Result { MISS, MATCH, MISMATCH };
+
+    CredentialCache(size_t capacity, int ttlMs);
+
+    Result Check(std::string_view name, std::string_view pwd);
+    // 缓存里有这个用户名（口令对不对都算）
+    bool Contains(std::string_view name);
+    // 写入或覆盖；数据库中的口令变化时调用
+    void Put(std::string_view name, std::string_view pwd);
+    void Erase(std::string_view name);
+
+    size_t Size();
+
+private:
+    static const size_t SHARDS = 16;
+    static const size_t SALT_SIZE = 16;
+
+    struct Entry {
+        std::string name;
+        uint8_t salt[SALT_SIZE];
+        Sha256::Digest digest;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    struct Shard {
+        std::mutex mtx;
+        std::list<Entry> lru;   //队首是最近用过的
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> index; //键指向链表节点里的name
+    };
+
+    static Sha256::Digest Digest_(const uint8_t* salt, std::string_view pwd);
+    Shard& ShardOf_(std::string_view name);
+    // 调用时已持有分片锁；过期的顺便删掉
+    Entry* Find_(Shard& shard, std::string_view name);
+
+    size_t shardCapacity_;
+    std::chrono::milliseconds ttl_;
+    Shard shards_[SHARDS];
+};
+
+#endif //CREDENTIAL_CACHE_H
@@ -0,0 +1,380 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "localuserstore.h"
+
+#include <chrono>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/random.h>
+#include <assert.h>
+
+using namespace std;
+using namespace std::chrono;
+
+const char LocalUserStore::MAGIC[8] = { 'U', 'S', 'E', 'R', 'L', 'O', 'G', '1' };
+
+LocalUserStore::LocalUserStore(const string& path):
+    path_(path), fd_(-1), map_(nullptr), mapSize_(0), tail_(0), garbage_(0),
+    dirty_(false), inserts_(0), compactions_(0), stop_(false) {}
+
+LocalUserStore::~LocalUserStore() {
+    {
+        lock_guard<mutex> locker(bgMtx_);
+        stop_ = true;
+    }
+    bgCond_.notify_one();
+    if(worker_.joinable()) { worker_.join(); }
+    Sync_();
+    unique_lock<shared_mutex> locker(mtx_);
+    Unmap_();
+}
+
+bool LocalUserStore::Open() {
+    assert(fd_ < 0);
+    int fd = open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if(fd < 0) {
+        LOG_ERROR("Open user log %s failed: %s", path_.c_str(), strerror(errno));
+        return false;
+    }
+    unique_lock<shared_mutex> locker(mtx_);
+    if(!MapFile_(fd, map_, mapSize_)) {
+        LOG_ERROR("Map user log %s failed", path_.c_str());
+        close(fd);
+        return false;
+    }
+    fd_ = fd;
+    Scan_();
+    LOG_INFO("User log %s: %zu users, %llu bytes", path_.c_str(), index_.size(), (unsigned long long)tail_);
+    locker.unlock();
+    worker_ = thread(&LocalUserStore::Run_, this);
+    return true;
+}
+
+size_t LocalUserStore::RecordSize_(const RecordHeader& rec) {
+    return sizeof(RecordHeader) + rec.nameLen + (rec.type == PUT ? SECRET_SIZE : 0);
+}
+
+size_t LocalUserStore::SizeAt_(uint64_t offset) const {
+    RecordHeader rec;
+    memcpy(&rec, map_ + offset, sizeof(rec));
+    return RecordSize_(rec);
+}
+
+//FNV-1a，只用来发现写了一半的记录
+uint32_t LocalUserStore::Checksum_(const char* data, size_t len) {
+    uint32_t hash = 2166136261u;
+    for(size_t i = 0; i < len; i++) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool LocalUserStore::WriteAll_(int fd, const void* data, size_t len) {
+    const char* ptr = static_cast<const char*>(data);
+    while(len > 0) {
+        ssize_t ret = write(fd, ptr, len);
+        if(ret < 0 && errno == EINTR) { continue; }
+        if(ret <= 0) { return false; }
+        ptr += ret;
+        len -= ret;
+    }
+    return true;
+}
+
+bool LocalUserStore::Salt_(uint8_t* salt) {
+    size_t got = 0;
+    while(got < SALT_SIZE) {
+        ssize_t len = getrandom(salt + got, SALT_SIZE - got, 0);
+        if(len > 0) { got += len; }
+        else if(errno != EINTR) {
+            LOG_ERROR("getrandom failed: %s", strerror(errno));
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LocalUserStore::SyncDir_(const string& path) {
+    size_t slash = path.rfind('/');
+    string dir = slash == string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(fd < 0) { return false; }
+    bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok;
+}
+
+bool LocalUserStore::MapFile_(int fd, char*& map, size_t& size) {
+    struct stat st;
+    if(fstat(fd, &st) < 0) { return false; }
+    size_t want = INITIAL_SIZE;
+    while(want < static_cast<size_t>(st.st_size)) { want *= 2; }
+    if(want != static_cast<size_t>(st.st_size) && ftruncate(fd, want) < 0) { return false; }
+    void* addr = mmap(nullptr, want, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(addr == MAP_FAILED) { return false; }
+    FileHeader* header = static_cast<FileHeader*>(addr);
+    if(memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0) {
+        //不是空文件就不是本程序写的日志，不能覆盖
+        if(st.st_size != 0) {
+            LOG_ERROR("Bad user log header");
+            munmap(addr, want);
+            return false;
+        }
+        memcpy(header->magic, MAGIC, sizeof(MAGIC));
+        header->tail = sizeof(FileHeader);
+    }
+    map = static_cast<char*>(addr);
+    size = want;
+    return true;
+}
+
+void LocalUserStore::Unmap_() {
+    if(map_) { munmap(map_, mapSize_); }
+    if(fd_ >= 0) { close(fd_); }
+    map_ = nullptr;
+    mapSize_ = 0;
+    fd_ = -1;
+}
+
+//按顺序重放记录；后面的PUT覆盖前面的，DEL删掉前面的，被覆盖和删除的都记为无效字节
+void LocalUserStore::Scan_() {
+    index_.clear();
+    garbage_ = 0;
+    uint64_t end = min<uint64_t>(Header_()->tail, mapSize_);
+    uint64_t off = sizeof(FileHeader);
+    RecordHeader rec;
+    while(off + sizeof(rec) <= end) {
+        memcpy(&rec, map_ + off, sizeof(rec));
+        size_t len = RecordSize_(rec);
+        if((rec.type != PUT && rec.type != DEL) || off + len > end ||
+           Checksum_(map_ + off + sizeof(rec.checksum), len - sizeof(rec.checksum)) != rec.checksum) {
+            break;
+        }
+        string name(map_ + off + sizeof(rec), rec.nameLen);
+        auto it = index_.find(name);
+        if(it != index_.end()) { garbage_ += SizeAt_(it->second); }
+        if(rec.type == PUT) {
+            if(it != index_.end()) { it->second = off; }
+            else { index_.emplace(move(name), off); }
+        } else {
+            if(it != index_.end()) { index_.erase(it); }
+            garbage_ += len;
+        }
+        off += len;
+    }
+    if(off != Header_()->tail) {
+        LOG_WARN("User log %s truncated from %llu to %llu bytes", path_.c_str(),
+                 (unsigned long long)Header_()->tail, (unsigned long long)off);
+        Header_()->tail = off;
+    }
+    tail_ = off;
+}
+
+bool LocalUserStore::Grow_(uint64_t need) {
+    size_t size = mapSize_;
+    while(size < need) { size *= 2; }
+    if(ftruncate(fd_, size) < 0) {
+        LOG_ERROR("Grow user log %s failed: %s", path_.c_str(), strerror(errno));
+        return false;
+    }
+    void* addr = mremap(map_, mapSize_, size, MREMAP_MAYMOVE);
+    if(addr == MAP_FAILED) {
+        LOG_ERROR("Remap user log %s failed: %s", path_.c_str(), strerror(errno));
+        return false;
+    }
+    map_ = static_cast<char*>(addr);
+    mapSize_ = size;
+    return true;
+}
+
+//记录写完后再推进文件头的尾部；中途崩溃时这条记录的校验和对不上，重启时丢弃
+bool LocalUserStore::Append_(RECORD_TYPE type, string_view name, const uint8_t* secret) {
+    RecordHeader rec = { 0, static_cast<uint16_t>(name.size()), type, 0 };
+    size_t len = RecordSize_(rec);
+    if(tail_ + len > mapSize_ && !Grow_(tail_ + len)) { return false; }
+    char* dst = map_ + tail_;
+    memcpy(dst, &rec, sizeof(rec));
+    memcpy(dst + sizeof(rec), name.data(), name.size());
+    if(type == PUT) { memcpy(dst + sizeof(rec) + name.size(), secret, SECRET_SIZE); }
+    rec.checksum = Checksum_(dst + sizeof(rec.checksum), len - sizeof(rec.checksum));
+    memcpy(dst, &rec.checksum, sizeof(rec.checksum));
+    tail_ += len;
+    Header_()->tail = tail_;
+    dirty_ = true;
+    return true;
+}
+
+UserStore::Result LocalUserStore::Check(const string& name, const string& pwd) {
+    uint8_t secret[SECRET_SIZE];
+    {
+        shared_lock<shared_mutex> locker(mtx_);
+        if(!map_) { return ERROR; }
+        auto it = index_.find(name);
+        if(it == index_.end()) { return NO_USER; }
+        memcpy(secret, map_ + it->second + sizeof(RecordHeader) + name.size(), SECRET_SIZE);
+    }
+    //计算摘要不占锁
+    Sha256 sha;
+    sha.Update(secret, SALT_SIZE);
+    sha.Update(pwd);
+    Sha256::Digest given = sha.Final();
+    return Sha256::Equal(secret + SALT_SIZE, given.data()) ? MATCH : MISMATCH;
+}
+
+//写入mmap即返回，最多丢失最近SYNC_MS内的注册
+void LocalUserStore::Insert(const string& name, const string& pwd, Callback done) {
+    bool ok = false;
+    uint8_t secret[SECRET_SIZE];
+    if(name.size() <= MAX_NAME && Salt_(secret)) {
+        Sha256 sha;
+        sha.Update(secret, SALT_SIZE);
+        sha.Update(pwd);
+        Sha256::Digest digest = sha.Final();
+        memcpy(secret + SALT_SIZE, digest.data(), digest.size());
+
+        unique_lock<shared_mutex> locker(mtx_);
+        if(map_ && !index_.count(name)) {
+            uint64_t offset = tail_;
+            ok = Append_(PUT, name, secret);
+            if(ok) { index_.emplace(name, offset); }
+        }
+    }
+    if(ok) { inserts_++; }
+    if(done) { done(ok); }
+}
+
+bool LocalUserStore::Remove(const string& name) {
+    bool compact;
+    {
+        unique_lock<shared_mutex> locker(mtx_);
+        if(!map_) { return false; }
+        auto it = index_.find(name);
+        if(it == index_.end()) { return false; }
+        size_t old = SizeAt_(it->second);
+        uint64_t offset = tail_;
+        if(!Append_(DEL, name, nullptr)) { return false; }
+        garbage_ += old + (tail_ - offset);
+        index_.erase(it);
+        compact = NeedCompact_();
+    }
+    if(compact) { bgCond_.notify_one(); }
+    return true;
+}
+
+bool LocalUserStore::LoadNames(vector<string>& names) {
+    shared_lock<shared_mutex> locker(mtx_);
+    if(!map_) { return false; }
+    names.clear();
+    names.reserve(index_.size());
+    for(const auto& entry : index_) { names.push_back(entry.first); }
+    return true;
+}
+
+bool LocalUserStore::IsReady() {
+    shared_lock<shared_mutex> locker(mtx_);
+    return map_ != nullptr;
+}
+
+UserStore::Stats LocalUserStore::GetStats() {
+    uint64_t bytes;
+    {
+        shared_lock<shared_mutex> locker(mtx_);
+        bytes = tail_;
+    }
+    //不合批，每次写入算一批
+    return { inserts_.load(), inserts_.load(), compactions_.load(), bytes };
+}
+
+// 读锁下拷出有效记录写新文件，不挡查询和注册；再在写锁下补上这期间追加的记录，换掉原文件
+// 补上的记录原样照抄：按顺序重放到快照之上，结果和原文件相同
+bool LocalUserStore::Compact() {
+    lock_guard<mutex> fileLocker(fileMtx_);
+    string live;
+    uint64_t mark;
+    {
+        shared_lock<shared_mutex> locker(mtx_);
+        if(!map_) { return false; }
+        live.reserve(tail_ - garbage_);
+        for(const auto& entry : index_) { live.append(map_ + entry.second, SizeAt_(entry.second)); }
+        mark = tail_;
+    }
+    string tmpPath = path_ + ".compact";
+    int fd = open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if(fd < 0) {
+        LOG_ERROR("Open %s failed: %s", tmpPath.c_str(), strerror(errno));
+        return false;
+    }
+    FileHeader header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.tail = sizeof(header) + live.size();
+    bool ok = WriteAll_(fd, &header, sizeof(header)) && WriteAll_(fd, live.data(), live.size());
+
+    unique_lock<shared_mutex> locker(mtx_);
+    uint64_t before = tail_;
+    char* map = nullptr;
+    size_t size = 0;
+    if(ok) {
+        header.tail += tail_ - mark;
+        ok = WriteAll_(fd, map_ + mark, tail_ - mark) &&
+             pwrite(fd, &header, sizeof(header), 0) == sizeof(header) &&
+             fdatasync(fd) == 0 && MapFile_(fd, map, size);
+    }
+    if(ok && rename(tmpPath.c_str(), path_.c_str()) < 0) {
+        munmap(map, size);
+        ok = false;
+    }
+    if(!ok) {
+        LOG_ERROR("Compact user log %s failed: %s", path_.c_str(), strerror(errno));
+        close(fd);
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    //换名落盘后重启才一定打开新文件；失败时新文件已在用，下次压缩再试
+    if(!SyncDir_(path_)) {
+        LOG_WARN("Sync directory of %s failed: %s", path_.c_str(), strerror(errno));
+    }
+    //原文件的页已在新文件中落盘，不用再刷
+    Unmap_();
+    fd_ = fd;
+    map_ = map;
+    mapSize_ = size;
+    dirty_ = false;
+    Scan_();
+    compactions_++;
+    LOG_INFO("Compact user log %s: %llu -> %llu bytes", path_.c_str(),
+             (unsigned long long)before, (unsigned long long)tail_);
+    return true;
+}
+
+void LocalUserStore::Sync_() {
+    lock_guard<mutex> locker(fileMtx_);
+    if(fd_ >= 0 && dirty_.exchange(false) && fdatasync(fd_) < 0) {
+        LOG_WARN("Sync user log %s failed: %s", path_.c_str(), strerror(errno));
+        dirty_ = true;
+    }
+}
+
+void LocalUserStore::Run_() {
+    unique_lock<mutex> locker(bgMtx_);
+    while(!stop_) {
+        bgCond_.wait_for(locker, milliseconds(SYNC_MS));
+        if(stop_) { break; }
+        locker.unlock();
+        bool compact;
+        {
+            shared_lock<shared_mutex> storeLocker(mtx_);
+            compact = NeedCompact_();
+        }
+        if(compact) { Compact(); }
+        Sync_();
+        locker.lock();
+    }
+}
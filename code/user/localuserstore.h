@@ -0,0 +1,112 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+
+#ifndef LOCAL_USER_STORE_H
+#define LOCAL_USER_STORE_H
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <shared_mutex>
+#include <unordered_map>
+#include <condition_variable>
+
+#include "../log/log.h"
+#include "userstore.h"
+#include "sha256.h"
+
+// 用户存在本机的一个追加写日志文件中，不依赖外部服务，适合单机部署和压测
+// 文件整体mmap：文件头之后是一条条记录，注册追加PUT，删除追加DEL；内存中的哈希表记下每个用户最新PUT的位置
+// 启动时顺序扫描重建索引，遇到校验和不对的记录（写到一半时崩溃）即截断；口令只存加盐摘要
+// 后台线程每秒把写过的页刷盘，删除留下的无效记录过多时重写一份只含有效记录的文件替换原文件
+class LocalUserStore : public UserStore {
+public:
+    explicit LocalUserStore(const std::string& path);
+    ~LocalUserStore() override;
+
+    // 打开或新建日志文件并重建索引，失败时返回false，此后各操作都返回出错
+    bool Open();
+
+    Result Check(const std::string& name, const std::string& pwd) override;
+    void Insert(const std::string& name, const std::string& pwd, Callback done) override;
+    bool Remove(const std::string& name) override;
+    bool LoadNames(std::vector<std::string>& names) override;
+    bool IsBlocking() const override { return false; }
+    bool IsReady() override;
+    Stats GetStats() override;
+
+    // 立即压缩，一般由后台线程按无效记录的比例触发
+    bool Compact();
+
+    static const size_t INITIAL_SIZE = 1 << 20;         //文件按两倍扩大，起始大小
+    static const uint64_t COMPACT_MIN_BYTES = 1 << 20;  //无效记录超过这么多、且超过一半时压缩
+    static constexpr int SYNC_MS = 1000;
+
+private:
+    enum RECORD_TYPE : uint8_t { PUT = 1, DEL = 2 };
+
+    struct FileHeader {
+        char magic[8];
+        uint64_t tail;      //有效记录的末尾，记录写完后才推进
+    };
+
+    // 其后是用户名，PUT再跟盐和摘要；校验和覆盖checksum之后的全部字节
+    struct RecordHeader {
+        uint32_t checksum;
+        uint16_t nameLen;
+        uint8_t type;
+        uint8_t reserved;
+    };
+
+    static const size_t SALT_SIZE = 16;
+    static const size_t SECRET_SIZE = SALT_SIZE + Sha256::DIGEST_SIZE;
+    static const size_t MAX_NAME = UINT16_MAX;
+    static const char MAGIC[8];
+
+    static size_t RecordSize_(const RecordHeader& rec);
+    static uint32_t Checksum_(const char* data, size_t len);
+    static bool WriteAll_(int fd, const void* data, size_t len);
+    // 盐取自内核的随机数，取不到时返回false
+    static bool Salt_(uint8_t* salt);
+    // 刷盘文件所在的目录，让rename换上的新文件在崩溃后仍然有效
+    static bool SyncDir_(const std::string& path);
+    // 映射fd并在空文件上写文件头，不改动成员
+    static bool MapFile_(int fd, char*& map, size_t& size);
+
+    FileHeader* Header_() { return reinterpret_cast<FileHeader*>(map_); }
+    size_t SizeAt_(uint64_t offset) const;
+    // 以下在写锁下调用
+    void Scan_();
+    bool Grow_(uint64_t need);
+    bool Append_(RECORD_TYPE type, std::string_view name, const uint8_t* secret);
+    void Unmap_();
+    bool NeedCompact_() const { return garbage_ >= COMPACT_MIN_BYTES && garbage_ * 2 >= tail_; }
+
+    void Run_();
+    void Sync_();
+
+    std::string path_;
+    int fd_;
+    char* map_;
+    size_t mapSize_;
+    uint64_t tail_;
+    uint64_t garbage_;      //被覆盖或删除的记录的字节数
+    std::unordered_map<std::string, uint64_t> index_;   //用户名 -> 最新PUT记录的偏移
+    std::shared_mutex mtx_; //查询加读锁；追加、扩大映射、换文件加写锁
+
+    std::mutex fileMtx_;    //刷盘和压缩互斥，压缩会换掉fd_
+    std::atomic<bool> dirty_;
+    std::atomic<uint64_t> inserts_;     //写入的新用户数，删除不算
+    std::atomic<uint64_t> compactions_;
+
+    std::mutex bgMtx_;
+    std::condition_variable bgCond_;
+    bool stop_;
+    std::thread worker_;
+};
+
+#endif //LOCAL_USER_STORE_H
@@ -0,0 +1,70 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "mysqluserstore.h"
+
+using namespace std;
+
+const char* MySqlUserStore::SELECT_USER = "SELECT username, password FROM user WHERE username=? LIMIT 1";
+const char* MySqlUserStore::INSERT_USER = "INSERT INTO user(username, password) VALUES(?,?)";
+const char* MySqlUserStore::DELETE_USER = "DELETE FROM user WHERE username=?";
+const char* MySqlUserStore::SELECT_NAMES = "SELECT username FROM user";
+
+MySqlUserStore::MySqlUserStore():
+    selectUser_(SqlConnPool::RegisterStmt(SELECT_USER)),
+    insertUser_(SqlConnPool::RegisterStmt(INSERT_USER)),
+    deleteUser_(SqlConnPool::RegisterStmt(DELETE_USER)),
+    selectNames_(SqlConnPool::RegisterStmt(SELECT_NAMES)),
+    batcher_(insertUser_) {}
+
+UserStore::Result MySqlUserStore::Check(const string& name, const string& pwd) {
+    return Check_(SqlRouter::Instance()->Route(selectUser_, name), name, pwd);
+}
+
+UserStore::Result MySqlUserStore::CheckLatest(const string& name, const string& pwd) {
+    return Check_(SqlConnPool::Instance(), name, pwd);
+}
+
+//用户名和密码作为语句参数发送，不拼进SQL
+UserStore::Result MySqlUserStore::Check_(SqlConnPool* pool, const string& name, const string& pwd) {
+    vector<vector<string>> rows;
+    MYSQL* sql;
+    SqlConnRAII sqlRAII(&sql, pool);
+    if(!sql || !pool->Execute(sql, selectUser_, { name }, &rows)) { return ERROR; }
+    if(rows.empty()) { return NO_USER; }
+    return rows[0][1] == pwd ? MATCH : MISMATCH;
+}
+
+//写入后一段时间内这个用户的查询走主库，副本还没同步到也能登录
+void MySqlUserStore::Insert(const string& name, const string& pwd, Callback done) {
+    batcher_.Add(name, pwd, [name, done = move(done)](bool ok) {
+        if(ok) { SqlRouter::Instance()->MarkWritten(name); }
+        if(done) { done(ok); }
+    });
+}
+
+bool MySqlUserStore::Remove(const string& name) {
+    MYSQL* sql;
+    SqlConnRAII sqlRAII(&sql, SqlConnPool::Instance());
+    if(!sql || !SqlConnPool::Instance()->Execute(sql, deleteUser_, { name })) { return false; }
+    SqlRouter::Instance()->MarkWritten(name);
+    return true;
+}
+
+//布隆过滤器把没有的用户名当作确定不存在，必须读主库，副本落后会漏掉新用户
+bool MySqlUserStore::LoadNames(vector<string>& names) {
+    vector<vector<string>> rows;
+    MYSQL* sql;
+    SqlConnRAII sqlRAII(&sql, SqlConnPool::Instance(), LOAD_NAMES_WAIT_MS);
+    if(!sql || !SqlConnPool::Instance()->Execute(sql, selectNames_, {}, &rows)) { return false; }
+    names.clear();
+    names.reserve(rows.size());
+    for(vector<string>& row : rows) { names.push_back(move(row[0])); }
+    return true;
+}
+
+UserStore::Stats MySqlUserStore::GetStats() {
+    return { batcher_.Batches(), batcher_.Rows(), 0, 0 };
+}
@@ -0,0 +1,55 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+
+#ifndef MYSQL_USER_STORE_H
+#define MYSQL_USER_STORE_H
+
+#include <mysql/mysql.h>  //mysql
+
+#include "../log/log.h"
+#include "../pool/sqlconnpool.h"
+#include "../pool/sqlconnRAII.h"
+#include "../pool/sqlrouter.h"
+#include "userstore.h"
+#include "registerbatcher.h"
+
+// user表存在MySQL中：查询用SqlConnPool的预编译语句，注册写入交给RegisterBatcher合批
+// 配置了副本时登录查询由SqlRouter分给副本，写入和注册查重走主库
+class MySqlUserStore : public UserStore {
+public:
+    MySqlUserStore();
+    ~MySqlUserStore() override = default;
+
+    Result Check(const std::string& name, const std::string& pwd) override;
+    Result CheckLatest(const std::string& name, const std::string& pwd) override;
+    void Insert(const std::string& name, const std::string& pwd, Callback done) override;
+    bool Remove(const std::string& name) override;
+    bool LoadNames(std::vector<std::string>& names) override;
+    bool IsBlocking() const override { return true; }
+    bool IsReady() override { return SqlConnPool::Instance()->IsReady(); }
+    Stats GetStats() override;
+
+    // AsyncSqlPool按语句文本查询，协程路径直接使用
+    static const char* SELECT_USER;
+    static const char* INSERT_USER;
+    static const char* DELETE_USER;
+    static const char* SELECT_NAMES;
+
+    static const int LOAD_NAMES_WAIT_MS = 10000;    //启动时连接还在建立，读用户名多等一会儿
+
+private:
+    Result Check_(SqlConnPool* pool, const std::string& name, const std::string& pwd);
+
+    //SqlConnPool中的预编译语句编号
+    int selectUser_;
+    int insertUser_;
+    int deleteUser_;
+    int selectNames_;
+
+    RegisterBatcher batcher_;
+};
+
+#endif //MYSQL_USER_STORE_H
@@ -0,0 +1,103 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "registerbatcher.h"
+
+using namespace std;
+using namespace std::chrono;
+
+RegisterBatcher::RegisterBatcher(int insertStmt):
+    RegisterBatcher([insertStmt](const vector<Row>& rows, vector<bool>& results) { Write_(insertStmt, rows, results); }) {}
+
+RegisterBatcher::RegisterBatcher(Writer writer): writer_(move(writer)), stop_(false), batches_(0), rows_(0) {
+    flusher_ = thread(&RegisterBatcher::Run_, this);
+}
+
+//还在排队的注册照常写完再退出
+RegisterBatcher::~RegisterBatcher() {
+    {
+        lock_guard<mutex> locker(mtx_);
+        stop_ = true;
+    }
+    cond_.notify_one();
+    if(flusher_.joinable()) { flusher_.join(); }
+}
+
+void RegisterBatcher::Add(const string& name, const string& pwd, Callback cb) {
+    {
+        lock_guard<mutex> locker(mtx_);
+        queue_.push_back({ { name, pwd }, move(cb), steady_clock::now() });
+        //第一条开始计时，凑满一批时提前提交，其余时候不用唤醒
+        if(queue_.size() != 1 && queue_.size() != BATCH_MAX) { return; }
+    }
+    cond_.notify_one();
+}
+
+void RegisterBatcher::Run_() {
+    vector<Row> rows;
+    vector<Callback> cbs;
+    vector<bool> results;
+    unique_lock<mutex> locker(mtx_);
+    while(true) {
+        cond_.wait(locker, [this] { return !queue_.empty() || stop_; });
+        if(queue_.empty()) { break; }
+        cond_.wait_until(locker, queue_.front().since + milliseconds(BATCH_WINDOW_MS),
+                         [this] { return queue_.size() >= BATCH_MAX || stop_; });
+        size_t cnt = min(queue_.size(), BATCH_MAX);
+        rows.clear();
+        cbs.clear();
+        for(size_t i = 0; i < cnt; i++) {
+            rows.push_back(move(queue_.front().row));
+            cbs.push_back(move(queue_.front().cb));
+            queue_.pop_front();
+        }
+        locker.unlock();
+
+        results.assign(rows.size(), false);
+        writer_(rows, results);
+        batches_++;
+        rows_ += rows.size();
+        for(size_t i = 0; i < cbs.size(); i++) {
+            if(cbs[i]) { cbs[i](results[i]); }
+        }
+        locker.lock();
+    }
+}
+
+void RegisterBatcher::Write_(int insertStmt, const vector<Row>& rows, vector<bool>& results) {
+    MYSQL* sql;
+    SqlConnRAII sqlRAII(&sql, SqlConnPool::Instance());
+    if(!sql) { return; }
+    if(rows.size() > 1 && InsertBatch_(sql, rows)) {
+        results.assign(rows.size(), true);
+        return;
+    }
+    for(size_t i = 0; i < rows.size(); i++) {
+        results[i] = SqlConnPool::Instance()->Execute(sql, insertStmt, { rows[i].name, rows[i].pwd });
+        if(!results[i]) { LOG_DEBUG("Insert error! %s", rows[i].name.c_str()); }
+    }
+}
+
+//INSERT INTO user(username, password) VALUES('a','1'),('b','2')...，值由连接按字符集转义
+bool RegisterBatcher::InsertBatch_(MYSQL* sql, const vector<Row>& rows) {
+    string order = "INSERT INTO user(username, password) VALUES";
+    for(size_t i = 0; i < rows.size(); i++) {
+        order += i ? ",(" : "(";
+        for(const string* value : { &rows[i].name, &rows[i].pwd }) {
+            size_t start = order.size() + 1;
+            order.resize(start + value->size() * 2 + 1);
+            order[start - 1] = '\'';
+            unsigned long len = mysql_real_escape_string(sql, &order[start], value->data(), value->size());
+            order.resize(start + len);
+            order += value == &rows[i].name ? "'," : "'";
+        }
+        order += ")";
+    }
+    if(mysql_query(sql, order.c_str())) {
+        LOG_WARN("Batch insert of %zu users failed: %s", rows.size(), mysql_error(sql));
+        return false;
+    }
+    return true;
+}
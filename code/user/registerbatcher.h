@@ -0,0 +1,73 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+
+#ifndef REGISTER_BATCHER_H
+#define REGISTER_BATCHER_H
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+#include "../log/log.h"
+#include "../pool/sqlconnpool.h"
+#include "../pool/sqlconnRAII.h"
+
+// 注册写入延后合批：由后台线程攒一小段时间或攒够条数后一条多行INSERT提交
+// 提交完成后在后台线程调用各自的回调；整批失败时逐条重试，一条出错不连累同批的其他用户
+class RegisterBatcher {
+public:
+    typedef std::function<void(bool ok)> Callback;
+
+    struct Row {
+        std::string name;
+        std::string pwd;
+    };
+    // 写入一批，results已按行数填好false，写成功的行改为true；在后台线程调用
+    typedef std::function<void(const std::vector<Row>& rows, std::vector<bool>& results)> Writer;
+
+    // insertStmt为SqlConnPool中单行INSERT的语句编号，单条和重试时使用
+    explicit RegisterBatcher(int insertStmt);
+    // 写到别处，测试中用来替换数据库
+    explicit RegisterBatcher(Writer writer);
+    ~RegisterBatcher();
+
+    // 用户名由调用者保证没有重复（见UserService的占用）
+    void Add(const std::string& name, const std::string& pwd, Callback cb);
+
+    uint64_t Batches() const { return batches_; }
+    uint64_t Rows() const { return rows_; }
+
+    static constexpr size_t BATCH_MAX = 64;     //一批最多的行数
+    static constexpr int BATCH_WINDOW_MS = 5;   //第一条入队后最多等这么久
+
+private:
+    struct Pending {
+        Row row;
+        Callback cb;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    void Run_();
+    static void Write_(int insertStmt, const std::vector<Row>& rows, std::vector<bool>& results);
+    static bool InsertBatch_(MYSQL* sql, const std::vector<Row>& rows);
+
+    Writer writer_;
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    std::deque<Pending> queue_;
+    bool stop_;
+    std::atomic<uint64_t> batches_;
+    std::atomic<uint64_t> rows_;
+    std::thread flusher_;
+};
+
+#endif //REGISTER_BATCHER_H
@@ -0,0 +1,128 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "sessionstore.h"
+
+#include <mutex>
+#include <cstdint>
+#include <errno.h>
+#include <string.h>
+#include <sys/random.h>
+#include "../log/log.h"
+
+using namespace std;
+using namespace std::chrono;
+
+SessionStore* SessionStore::Instance() {
+    static SessionStore store;
+    return &store;
+}
+
+int64_t SessionStore::NowMs_() {
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+SessionStore::Shard& SessionStore::ShardOf_(string_view token) {
+    return shards_[TokenHash()(token) % SHARDS];
+}
+
+//令牌要不可猜测，取自内核的随机数；取不到时不建会话
+string SessionStore::Create(string_view user) {
+    static const char HEX[] = "0123456789abcdef";
+    unsigned char bytes[TOKEN_BYTES];
+    size_t got = 0;
+    while(got < TOKEN_BYTES) {
+        ssize_t len = getrandom(bytes + got, TOKEN_BYTES - got, 0);
+        if(len > 0) { got += len; }
+        else if(errno != EINTR) {
+            LOG_ERROR("getrandom failed: %s", strerror(errno));
+            return string();
+        }
+    }
+    string token(TOKEN_BYTES * 2, '0');
+    for(size_t i = 0; i < TOKEN_BYTES; i++) {
+        token[i * 2] = HEX[bytes[i] >> 4];
+        token[i * 2 + 1] = HEX[bytes[i] & 0xf];
+    }
+
+    int64_t now = NowMs_();
+    unique_ptr<Session> session(new Session);
+    session->user = user;
+    session->expires.store(now + TTL_MS, memory_order_relaxed);
+    Shard& shard = ShardOf_(token);
+    unique_lock<shared_mutex> locker(shard.mtx);
+    if(shard.sessions.size() >= SHARD_CAPACITY) { Evict_(shard, now); }
+    shard.sessions[token] = move(session);
+    return token;
+}
+
+//满了才扫一遍，平时不付出代价
+void SessionStore::Evict_(Shard& shard, int64_t now) {
+    auto oldest = shard.sessions.end();
+    int64_t oldestExpires = INT64_MAX;
+    size_t removed = 0;
+    for(auto it = shard.sessions.begin(); it != shard.sessions.end();) {
+        int64_t expires = it->second->expires.load(memory_order_relaxed);
+        if(expires <= now) {
+            it = shard.sessions.erase(it);
+            removed++;
+            continue;
+        }
+        if(expires < oldestExpires) {
+            oldest = it;
+            oldestExpires = expires;
+        }
+        ++it;
+    }
+    if(removed == 0 && oldest != shard.sessions.end()) { shard.sessions.erase(oldest); }
+}
+
+bool SessionStore::Touch(string_view token, string* user) {
+    if(token.size() != TOKEN_BYTES * 2) { return false; }
+    int64_t now = NowMs_();
+    Shard& shard = ShardOf_(token);
+    shared_lock<shared_mutex> locker(shard.mtx);
+    auto it = shard.sessions.find(token);
+    if(it == shard.sessions.end()) { return false; }
+    Session& session = *it->second;
+    if(session.expires.load(memory_order_relaxed) <= now) { return false; }
+    session.expires.store(now + TTL_MS, memory_order_relaxed);
+    if(user) { *user = session.user; }
+    return true;
+}
+
+void SessionStore::Remove(string_view token) {
+    Shard& shard = ShardOf_(token);
+    unique_lock<shared_mutex> locker(shard.mtx);
+    auto it = shard.sessions.find(token);
+    if(it != shard.sessions.end()) { shard.sessions.erase(it); }
+}
+
+//逐片加写锁，一次只阻塞一片的校验
+size_t SessionStore::Sweep() {
+    int64_t now = NowMs_();
+    size_t removed = 0;
+    for(Shard& shard : shards_) {
+        unique_lock<shared_mutex> locker(shard.mtx);
+        for(auto it = shard.sessions.begin(); it != shard.sessions.end();) {
+            if(it->second->expires.load(memory_order_relaxed) <= now) {
+                it = shard.sessions.erase(it);
+                removed++;
+            } else {
+                ++it;
+            }
+        }
+    }
+    return removed;
+}
+
+size_t SessionStore::Size() {
+    size_t size = 0;
+    for(Shard& shard : shards_) {
+        shared_lock<shared_mutex> locker(shard.mtx);
+        size += shard.sessions.size();
+    }
+    return size;
+}
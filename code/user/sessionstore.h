@@ -0,0 +1,73 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+
+#ifndef SESSION_STORE_H
+#define SESSION_STORE_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <shared_mutex>
+#include <functional>
+#include <unordered_map>
+
+// 登录后的会话，保存在内存中，令牌经cookie下发
+// 令牌是128位随机数的十六进制串；按令牌分片，每片一把读写锁，校验只加读锁
+// 有效期滑动：每次校验通过都从当时起重新计算；过期的会话校验时视为不存在，由Sweep定期删除
+// 每片最多SHARD_CAPACITY个会话，满了时先删过期的，没有过期的就删最早到期的，反复登录不会让内存一直涨到下次清扫
+class SessionStore {
+public:
+    static const int TTL_MS = 30 * 60 * 1000;
+    static const size_t SHARDS = 16;
+    static const size_t SHARD_CAPACITY = 8192;
+    static constexpr const char* COOKIE_NAME = "sid";
+
+    //局部静态变量单例模式
+    static SessionStore* Instance();
+
+    // 为user新建会话，返回令牌；取不到随机数时返回空串
+    std::string Create(std::string_view user);
+    // 令牌有效时延长有效期并返回true，user不为空时取回用户名
+    bool Touch(std::string_view token, std::string* user = nullptr);
+    void Remove(std::string_view token);
+    // 删除所有过期会话，返回删除的个数
+    size_t Sweep();
+
+    size_t Size();
+
+private:
+    SessionStore() = default;
+    ~SessionStore() = default;
+
+    static const size_t TOKEN_BYTES = 16;
+
+    struct Session {
+        std::string user;
+        std::atomic<int64_t> expires;   //steady_clock的毫秒数，读锁下也可以更新
+    };
+
+    // 用string_view直接查表，不为查找构造string
+    struct TokenHash {
+        typedef void is_transparent;
+        size_t operator()(std::string_view token) const { return std::hash<std::string_view>()(token); }
+    };
+
+    struct Shard {
+        std::shared_mutex mtx;
+        std::unordered_map<std::string, std::unique_ptr<Session>, TokenHash, std::equal_to<>> sessions;
+    };
+
+    static int64_t NowMs_();
+    Shard& ShardOf_(std::string_view token);
+    // 持有分片的写锁时调用，腾出至少一个位置
+    static void Evict_(Shard& shard, int64_t now);
+
+    Shard shards_[SHARDS];
+};
+
+#endif //SESSION_STORE_H
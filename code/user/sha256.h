@@ -0,0 +1,39 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+// SHA-256（FIPS 180-4），用于口令的加盐摘要（CredentialCache、LocalUserStore），不依赖OpenSSL
+class Sha256 {
+public:
+    static const size_t DIGEST_SIZE = 32;
+    typedef std::array<uint8_t, DIGEST_SIZE> Digest;
+
+    Sha256();
+
+    void Update(const void* data, size_t len);
+    void Update(std::string_view data) { Update(data.data(), data.size()); }
+    Digest Final();
+
+    // 比较两个摘要，耗时与内容无关
+    static bool Equal(const uint8_t* a, const uint8_t* b);
+
+private:
+    void Transform_(const uint8_t* block);
+
+    uint32_t state_[8];
+    uint8_t block_[64];
+    size_t blockLen_;
+    uint64_t totalLen_;
+};
+
+#endif //SHA256_H
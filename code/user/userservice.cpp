@@ -0,0 +1,276 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#include "userservice.h"
+
+#include <future>
+#include <assert.h>
+#include "../server/coreactor.h"
+using namespace std;
+
+UserService::UserService():
+    store_(new MySqlUserStore()), cache_(CACHE_CAPACITY, CACHE_TTL_MS), cacheHits_(0), bloomSkips_(0),
+    filter_(nullptr), namesCapacity_(0), namesCount_(0), loadingNames_(false) {}
+
+UserService* UserService::Instance() {
+    static UserService service;
+    return &service;
+}
+
+void UserService::SetStore(unique_ptr<UserStore> store) {
+    assert(store);
+    store_ = move(store);
+    lock_guard<mutex> locker(namesMtx_);
+    filter_ = nullptr;
+    names_.reset();
+    namesCount_ = 0;
+    namesCapacity_ = 0;
+}
+
+//先开始记录新加的用户名再读库：读的时候还没提交的注册，提交后由Remember_补进来
+bool UserService::LoadNames() {
+    {
+        lock_guard<mutex> locker(namesMtx_);
+        if(loadingNames_) { return false; }
+        loadingNames_ = true;
+    }
+    vector<string> names;
+    bool ok = store_->LoadNames(names);
+    unique_ptr<BloomFilter> filter;
+    size_t capacity = max<size_t>(names.size(), 1024) * NAMES_HEADROOM;
+    if(ok) {
+        filter.reset(new BloomFilter(capacity));
+        for(const string& name : names) { filter->Add(name); }
+    }
+    lock_guard<mutex> locker(namesMtx_);
+    if(!ok) {
+        namesAdded_.clear();
+        loadingNames_ = false;
+        LOG_WARN("Load user names failed, bloom filter %s", names_ ? "not rebuilt" : "disabled");
+        return false;
+    }
+    for(const string& name : namesAdded_) { filter->Add(name); }
+    namesCount_ = names.size() + namesAdded_.size();
+    namesCapacity_ = capacity;
+    namesAdded_.clear();
+    if(names_) { retired_.push_back(move(names_)); }
+    names_ = move(filter);
+    filter_.store(names_.get(), memory_order_release);
+    //过滤器发布之后才结束记录：看到没在建的AddName_一定拿到新的过滤器
+    loadingNames_.store(false, memory_order_release);
+    LOG_INFO("Loaded %zu user names, bloom filter %zu bits", names.size(), names_->Bits());
+    return true;
+}
+
+bool UserService::NeedsNames() const {
+    if(loadingNames_.load()) { return false; }
+    return !filter_.load() || namesCount_.load() > namesCapacity_.load();
+}
+
+//正在建过滤器时另外记下，建好后补进新的过滤器
+//没看到在建就只加进当前的：之后开始的读库一定能读到已提交的用户名
+void UserService::AddName_(const string& name) {
+    BloomFilter* filter = filter_.load(memory_order_acquire);
+    if(filter && !loadingNames_.load(memory_order_acquire)) {
+        filter->Add(name);
+        return;
+    }
+    lock_guard<mutex> locker(namesMtx_);
+    filter = filter_.load(memory_order_relaxed);
+    if(filter) { filter->Add(name); }
+    if(loadingNames_) { namesAdded_.push_back(name); }
+}
+
+bool UserService::TryCached_(const string& name, const string& pwd, bool isLogin, bool& ok) {
+    if(isLogin) {
+        //口令和缓存不一致时仍以数据库为准
+        if(cache_.Check(name, pwd) == CredentialCache::MATCH) {
+            cacheHits_++;
+            ok = true;
+            return true;
+        }
+        if(IsNewName_(name)) {
+            LOG_DEBUG("no such user!");
+            ok = false;
+            return true;
+        }
+        return false;
+    }
+    if(cache_.Contains(name)) {
+        cacheHits_++;
+        LOG_DEBUG("user used!");
+        ok = false;
+        return true;
+    }
+    return false;
+}
+
+bool UserService::IsNewName_(const string& name) {
+    BloomFilter* filter = filter_.load(memory_order_acquire);
+    if(!filter || filter->MayContain(name)) { return false; }
+    bloomSkips_++;
+    return true;
+}
+
+bool UserService::Reserve_(const string& name, bool& fresh) {
+    {
+        lock_guard<mutex> locker(reserveMtx_);
+        if(!reserved_.insert(name).second) { return false; }
+    }
+    fresh = IsNewName_(name);
+    //写入前就加进过滤器：写完放开占用后，同名的注册一定会查库
+    AddName_(name);
+    return true;
+}
+
+//写完后放开：已写入的之后能查到，失败的可以重新注册
+void UserService::Release_(const string& name) {
+    lock_guard<mutex> locker(reserveMtx_);
+    reserved_.erase(name);
+}
+
+void UserService::Remember_(const string& name, const string& pwd) {
+    AddName_(name);
+    cache_.Put(name, pwd);
+}
+
+UserService::Stats UserService::GetStats() {
+    return { cache_.Size(), cacheHits_.load(), bloomSkips_.load(), store_->GetStats() };
+}
+
+bool UserService::Remove(const string& name) {
+    if(!store_->Remove(name)) { return false; }
+    cache_.Erase(name);
+    return true;
+}
+
+//注册，登录请求解析
+bool UserService::Verify(const string &name, const string &pwd, bool isLogin) {
+    if(!isLogin) {
+        promise<bool> committed;
+        future<bool> result = committed.get_future();
+        Register(name, pwd, [&committed](bool ok) { committed.set_value(ok); });
+        return result.get();
+    }
+    if(name == "" || pwd == "") { return false; }
+    LOG_INFO("Verify name:%s", name.c_str());
+    bool ok;
+    if(TryCached_(name, pwd, isLogin, ok)) { return ok; }
+
+    /* 登录行为：查询用户及密码 */
+    UserStore::Result found = store_->Check(name, pwd);
+    bool flag = found == UserStore::MATCH;
+    if(flag) { Remember_(name, pwd); }
+    else if(found != UserStore::ERROR) { LOG_DEBUG("pwd error!"); }
+    return flag;
+}
+
+void UserService::Register(const string& name, const string& pwd, UserStore::Callback done) {
+    if(name == "" || pwd == "") {
+        done(false);
+        return;
+    }
+    LOG_INFO("Verify name:%s", name.c_str());
+    bool ok;
+    if(TryCached_(name, pwd, false, ok)) {
+        done(ok);
+        return;
+    }
+    bool fresh = false;
+    if(!Reserve_(name, fresh)) {
+        LOG_DEBUG("user used!");
+        done(false);
+        return;
+    }
+    /* 查询用户；用户名确定没用过时不查 */
+    UserStore::Result found = fresh ? UserStore::NO_USER : store_->CheckLatest(name, pwd);
+    if(found != UserStore::NO_USER) {
+        //已有此用户或查询出错
+        if(found != UserStore::ERROR) { LOG_DEBUG("user used!"); }
+        Release_(name);
+        done(false);
+        return;
+    }
+    /* 注册行为 且 用户名未被使用*/
+    LOG_DEBUG("regirster!");
+    store_->Insert(name, pwd, [this, name, pwd, done = move(done)](bool committed) {
+        if(committed) {
+            namesCount_++;
+            Remember_(name, pwd);
+        }
+        Release_(name);
+        if(committed) { LOG_DEBUG( "UserVerify success!!"); }
+        else { LOG_DEBUG( "Insert error!"); }
+        done(committed);
+    });
+}
+
+namespace {
+
+//等注册写入完成；回调在存储后端的线程，交给reactor恢复协程
+struct RegisterAwaiter {
+    UserStore& store;
+    const string& name;
+    const string& pwd;
+    bool ok = false;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(coroutine_handle<> handle) {
+        store.Insert(name, pwd, [this, resumer = CoResumer(handle)](bool committed) {
+            ok = committed;
+            CoReactor::Instance()->Post(resumer);
+        });
+    }
+    bool await_resume() const noexcept { return ok; }
+};
+
+}
+
+CoTask<bool> UserService::VerifyAsync(string name, string pwd, bool isLogin) {
+    if(name == "" || pwd == "") { co_return false; }
+    LOG_INFO("Verify name:%s", name.c_str());
+    bool ok;
+    if(TryCached_(name, pwd, isLogin, ok)) { co_return ok; }
+    bool fresh = false;
+    if(!isLogin && !Reserve_(name, fresh)) {
+        LOG_DEBUG("user used!");
+        co_return false;
+    }
+    /* 查询用户及密码；注册的用户名确定没用过时不查 */
+    SqlResult result;
+    result.ok = true;
+    if(!fresh) {
+        //先构造awaiter再co_await：GCC 12不支持co_await表达式里带初始化列表临时对象
+        AsyncSqlPool::QueryAwaiter select = AsyncSqlPool::Instance()->Query(MySqlUserStore::SELECT_USER, { name });
+        result = co_await select;
+        if(!result.ok) {
+            if(!isLogin) { Release_(name); }
+            co_return false;
+        }
+    }
+    /* 登录行为 */
+    if(isLogin) {
+        bool flag = !result.rows.empty() && result.rows[0][1] == pwd;
+        if(flag) { Remember_(name, pwd); }
+        else { LOG_DEBUG("pwd error!"); }
+        co_return flag;
+    }
+    //数据库中有结果但是注册行为
+    if(!result.rows.empty()) {
+        LOG_DEBUG("user used!");
+        Release_(name);
+        co_return false;
+    }
+    /* 注册行为 且 用户名未被使用*/
+    LOG_DEBUG("regirster!");
+    ok = co_await RegisterAwaiter{ *store_, name, pwd };
+    if(ok) {
+        namesCount_++;
+        Remember_(name, pwd);
+    }
+    Release_(name);
+    if(!ok) { LOG_DEBUG( "Insert error!"); }
+    co_return ok;
+}
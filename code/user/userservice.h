@@ -0,0 +1,104 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+#ifndef USER_SERVICE_H
+#define USER_SERVICE_H
+
+#include <mutex>
+#include <string>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <unordered_set>
+
+#include "../log/log.h"
+#include "../pool/asyncsqlpool.h"
+#include "credentialcache.h"
+#include "bloomfilter.h"
+#include "userstore.h"
+#include "mysqluserstore.h"
+
+// 用户登录与注册
+// 原先写在HttpRequest中，现由路由处理函数调用
+// 核对过的口令放进CredentialCache，再次登录不查库；用户名另有布隆过滤器，不存在的用户登录、没用过的用户名注册都不必先查库
+// 用户数据存在UserStore中，默认是MySQL，可以换成本机的LocalUserStore
+// 假定只有本进程写用户数据：别处新加的用户在过滤器里没有，别处改的口令在缓存过期前不生效
+class UserService {
+public:
+    struct Stats {
+        size_t cached;      //缓存中的用户数
+        uint64_t cacheHits; //登录直接由缓存确认、注册直接由缓存拒绝的次数
+        uint64_t bloomSkips;//布隆过滤器省掉查询的次数
+        UserStore::Stats store;
+    };
+
+    //局部静态变量单例模式
+    static UserService* Instance();
+
+    //换掉默认的MySqlUserStore，在LoadNames和接受请求之前调用
+    void SetStore(std::unique_ptr<UserStore> store);
+    UserStore* Store() { return store_.get(); }
+
+    //读出全部用户名建布隆过滤器，读不到时不使用过滤器；可以和请求并行，建好之前不做过滤
+    //已有过滤器时重建，建好前旧的照常使用
+    bool LoadNames();
+    //过滤器还没建成（没读过或读失败），或注册的用户名超出了它的设计容量，需要（重新）LoadNames
+    bool NeedsNames() const;
+
+    //登录时校验密码，注册时检查用户名未被占用并写入，等写入完成后才返回
+    bool Verify(const std::string& name, const std::string& pwd, bool isLogin);
+
+    //注册，不等写入：查重在调用线程完成（存储是数据库时会查库），写入交给存储后端合批，
+    //完成后done(ok)在后端的线程调用，查重就失败时在本线程调用
+    void Register(const std::string& name, const std::string& pwd, UserStore::Callback done);
+
+    //同Verify，查询交给AsyncSqlPool，等待期间协程挂起，由reactor线程恢复；只用于MySqlUserStore
+    CoTask<bool> VerifyAsync(std::string name, std::string pwd, bool isLogin);
+
+    //删除用户；过滤器不能删除，之后按“可能存在”处理
+    bool Remove(const std::string& name);
+
+    Stats GetStats();
+
+private:
+    UserService();
+    ~UserService() = default;
+
+    static const size_t CACHE_CAPACITY = 100000;
+    static const int CACHE_TTL_MS = 600000;
+    static const size_t NAMES_HEADROOM = 4; //过滤器按现有用户数的这么多倍定大小，留出注册的余量
+
+    //不查库就能得出结果时返回true，结果放在ok
+    bool TryCached_(const std::string& name, const std::string& pwd, bool isLogin, bool& ok);
+    //过滤器确定用户名还没被用过
+    bool IsNewName_(const std::string& name);
+    //注册前占住用户名，已被别的注册占住时返回false；fresh为true表示用户名确定没用过，不必查库
+    bool Reserve_(const std::string& name, bool& fresh);
+    void Release_(const std::string& name);
+    //登录核对成功或注册写入后记下
+    void Remember_(const std::string& name, const std::string& pwd);
+    //把用户名加进过滤器；过滤器正在建时先记下，建好后补进去
+    void AddName_(const std::string& name);
+
+    std::unique_ptr<UserStore> store_;
+    CredentialCache cache_;
+    std::atomic<uint64_t> cacheHits_;
+    std::atomic<uint64_t> bloomSkips_;
+
+    std::unique_ptr<BloomFilter> names_;
+    std::atomic<BloomFilter*> filter_;      //建好后发布，请求只读这个指针
+    //换下来的过滤器可能还有请求在读，不释放；每次至少按NAMES_HEADROOM倍增长，留下的总和不超过当前的一半
+    std::vector<std::unique_ptr<BloomFilter>> retired_;
+    std::atomic<size_t> namesCapacity_;     //当前过滤器的设计容量
+    std::atomic<size_t> namesCount_;        //过滤器里的用户名数，之后每写入一个注册加一
+    mutable std::mutex namesMtx_;
+    std::atomic<bool> loadingNames_;
+    std::vector<std::string> namesAdded_;   //建过滤器期间新加的用户名
+
+    std::mutex reserveMtx_;
+    std::unordered_set<std::string> reserved_;  //已占住、还没写完的用户名
+};
+
+#endif //USER_SERVICE_H
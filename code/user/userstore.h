@@ -0,0 +1,54 @@
+/*
+ * @Author       : mark
+ * @Date         : 2026-10-19
+ * @copyleft Apache 2.0
+ */
+
+#ifndef USER_STORE_H
+#define USER_STORE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+// 用户数据的存储后端：MySqlUserStore走数据库连接池，LocalUserStore是本机的追加日志文件
+// 由UserService持有，缓存、过滤器和注册查重都在UserService中，后端只负责查和写
+class UserStore {
+public:
+    enum Result {
+        ERROR,      //后端出错，结果未知
+        NO_USER,
+        MATCH,
+        MISMATCH,
+    };
+
+    struct Stats {
+        uint64_t writeBatches;  //写入的批数，不合批的后端每次写入算一批
+        uint64_t writtenRows;
+        uint64_t compactions;   //日志压缩次数，没有日志的后端为0
+        uint64_t logBytes;      //日志当前长度，没有日志的后端为0
+    };
+
+    typedef std::function<void(bool ok)> Callback;
+
+    virtual ~UserStore() = default;
+
+    // 查用户并核对密码
+    virtual Result Check(const std::string& name, const std::string& pwd) = 0;
+    // 同Check，但一定要读到最新的写入，注册查重用；有只读副本的后端在这里改读主库
+    virtual Result CheckLatest(const std::string& name, const std::string& pwd) { return Check(name, pwd); }
+    // 写入新用户，用户名由调用者保证没有重复；done可能在本线程直接调用，也可能在后端的线程调用
+    virtual void Insert(const std::string& name, const std::string& pwd, Callback done) = 0;
+    virtual bool Remove(const std::string& name) = 0;
+    // 取出全部用户名，出错返回false
+    virtual bool LoadNames(std::vector<std::string>& names) = 0;
+    // 查询要经过网络等慢速I/O时为true，调用方据此决定放到哪个执行通道
+    virtual bool IsBlocking() const = 0;
+    // 可以处理请求了；数据库连接在后台建立，启动后要过一会儿才就绪
+    virtual bool IsReady() = 0;
+
+    virtual Stats GetStats() = 0;
+};
+
+#endif //USER_STORE_H
@@ -5,6 +5,26 @@
  */ 
 #include "../code/log/log.h"
 #include "../code/pool/threadpool.h"
+#include "../code/pool/workstealingpool.h"
+#include "../code/http/router.h"
+#include "../code/http/httprequest.h"
+#include "../code/http/httpconn.h"
+#include "../code/buffer/chainbuffer.h"
+#include "../code/pool/asyncsqlpool.h"
+#include "../code/pool/sqlconnpool.h"
+#include "../code/pool/sqlrouter.h"
+#include "../code/server/coreactor.h"
+#include "../code/buffer/arena.h"
+#include "../code/user/credentialcache.h"
+#include "../code/user/bloomfilter.h"
+#include "../code/user/sessionstore.h"
+#include "../code/user/localuserstore.h"
+#include "../code/user/registerbatcher.h"
+#include "../code/user/userservice.h"
+#include "../code/timer/timingwheel.h"
+#include <map>
+#include <future>
+#include <arpa/inet.h>
 #include <features.h>
 
 #if __GLIBC__ == 2 && __GLIBC_MINOR__ < 30
@@ -50,7 +70,828 @@ void TestThreadPool() {
     getchar();
 }
 
+void TestWorkStealingPool() {
+    std::atomic<int> done(0);
+    {
+        //工作线程轮流绑定到允许使用的CPU上
+        WorkStealingPool pool(4, CpuAffinity::Allowed());
+        //工作线程内部提交的任务进入本地队列，可被其他线程窃取
+        for(int i = 0; i < 1000; i++) {
+            pool.AddTask([&pool, &done] {
+                for(int j = 0; j < 10; j++) {
+                    pool.AddTask([&done] { done++; });
+                }
+                done++;
+            });
+        }
+        //批量提交
+        Task batch[64];
+        for(Task& task : batch) {
+            task = Task([&done] { done++; });
+        }
+        pool.AddTasks(batch, 64);
+        while(done.load() < 11064) {
+            std::this_thread::yield();
+        }
+    }
+    assert(done.load() == 11064);
+
+    //阻塞的任务让后面的任务排队，线程数增长；空闲后退回常驻线程数
+    WorkStealingPool elastic(1, {}, 4, 1000, 50);
+    for(int i = 0; i < 20; i++) {
+        elastic.AddTask([] { std::this_thread::sleep_for(std::chrono::milliseconds(5)); });
+    }
+    while(elastic.GetStats().tasks < 20) {
+        std::this_thread::yield();
+    }
+    WorkStealingPool::Stats stats = elastic.GetStats();
+    assert(stats.grown > 0 && stats.maxWaitUs > 1000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    stats = elastic.GetStats();
+    assert(stats.threads == 1 && stats.retired == stats.grown);
+
+    //排队上限：唯一的线程被占住时最多排2个
+    WorkStealingPool limited(1, {}, 1, 2000, 0, 2);
+    std::atomic<bool> release(false);
+    std::atomic<int> started(0);
+    limited.AddTask([&] { started++; while(!release) { std::this_thread::yield(); } });
+    while(started.load() == 0) { std::this_thread::yield(); }
+    assert(limited.TryAddTask([] {}) && limited.TryAddTask([] {}) && !limited.TryAddTask([] {}));
+    release = true;
+    while(limited.GetStats().tasks < 3) { std::this_thread::yield(); }
+    assert(limited.GetStats().rejected == 1);
+}
+
+void TestCpuAffinity() {
+    std::vector<int> cpus = CpuAffinity::Parse("4-6,1,5\n");
+    assert((cpus == std::vector<int>{1, 4, 5, 6}));
+    assert(CpuAffinity::ToString(cpus) == "1,4-6");
+    assert(CpuAffinity::Parse("3-1").empty() && CpuAffinity::Parse("a").empty());
+    std::vector<int> allowed = CpuAffinity::Allowed();
+    assert(!allowed.empty() && CpuAffinity::Exclude(allowed).empty());
+    std::thread([&allowed] {
+        assert(CpuAffinity::PinSelf({ allowed.back() }));
+        assert(sched_getcpu() == allowed.back());
+        assert(CpuAffinity::CurrentNode() == CpuAffinity::NodeOf(allowed.back()));
+    }).join();
+}
+
+// 需要本机的MySQL/MariaDB和MariaDB客户端库；账号取环境变量TEST_DB_USER、TEST_DB_PWD、TEST_DB_NAME
+// 客户端库没有非阻塞接口或连不上数据库时所有查询失败，不做检查
+void TestAsyncSql() {
+    const char* user = getenv("TEST_DB_USER");
+    const char* pwd = getenv("TEST_DB_PWD");
+    const char* db = getenv("TEST_DB_NAME");
+    Epoller epoller;
+    TimingWheel timer;
+    AsyncSqlPool* pool = AsyncSqlPool::Instance();
+    if(!pool->Init(&epoller, &timer, "localhost", 3306, user ? user : "root", pwd ? pwd : "", db ? db : "test", 4)) {
+        return;
+    }
+    //4条连接上同时排100个查询，由本线程的epoll循环驱动
+    const int cnt = 100;
+    int ok = 0, failed = 0;
+    for(int i = 0; i < cnt; i++) {
+        pool->Query("SELECT ?", { std::to_string(i) }, [i, &ok, &failed](SqlResult& result) {
+            if(!result.ok) {
+                failed++;
+                return;
+            }
+            assert(result.rows.size() == 1 && result.rows[0][0] == std::to_string(i));
+            ok++;
+        });
+    }
+    for(int round = 0; ok + failed < cnt && round < 100; round++) {
+        int n = epoller.Wait(100);
+        for(int i = 0; i < n; i++) {
+            assert(pool->OnEvent(epoller.GetEventFd(i), epoller.GetEvents(i)));
+        }
+        timer.tick();
+    }
+    assert(ok == cnt || failed == cnt);
+    pool->Close();
+
+    auto runUntil = [&](const std::function<bool()>& done) {
+        for(int round = 0; !done() && round < 100; round++) {
+            int n = epoller.Wait(timer.GetNextTick());
+            for(int i = 0; i < n; i++) {
+                assert(pool->OnEvent(epoller.GetEventFd(i), epoller.GetEvents(i)));
+            }
+            timer.tick();
+        }
+    };
+
+    //执行超时的查询失败后连接重建，后面的查询照常执行
+    if(ok == cnt) {
+        assert(pool->Init(&epoller, &timer, "localhost", 3306, user ? user : "root", pwd ? pwd : "", db ? db : "test", 1, 1000, 300));
+        std::string slow, next;
+        pool->Query("SELECT SLEEP(2)", {}, [&slow](SqlResult& result) { slow = result.ok ? "ok" : result.error; });
+        runUntil([&slow] { return !slow.empty(); });
+        assert(slow == "query timeout");
+        pool->Query("SELECT ?", { "after" }, [&next](SqlResult& result) {
+            next = result.ok && result.rows.size() == 1 ? result.rows[0][0] : result.error;
+        });
+        runUntil([&next] { return !next.empty(); });
+        assert(next == "after");
+        pool->Close();
+    }
+
+    //只完成TCP握手、从不发问候包的服务端：连接停在握手阶段，排队的查询到截止时间以失败回调
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen = sizeof(addr);
+    assert(bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) == 0 && listen(listenFd, 8) == 0);
+    assert(getsockname(listenFd, (struct sockaddr*)&addr, &addrLen) == 0);
+    assert(pool->Init(&epoller, &timer, "127.0.0.1", ntohs(addr.sin_port), "user", "pwd", "test", 1, 1000, 300));
+    std::string error;
+    auto start = std::chrono::steady_clock::now();
+    pool->Query("SELECT 1", {}, [&error](SqlResult& result) {
+        assert(!result.ok);
+        error = result.error;
+    });
+    runUntil([&error] { return !error.empty(); });
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    //截止时间按毫秒取整，允许差一个毫秒
+    assert(error == "query timeout" && elapsed >= 299 && elapsed < 1000);
+    pool->Close();
+    close(listenFd);
+}
+
+// 同样需要本机的数据库；连不上时只检查取连接超时
+void TestSqlConnPool() {
+    const char* user = getenv("TEST_DB_USER");
+    const char* pwd = getenv("TEST_DB_PWD");
+    const char* db = getenv("TEST_DB_NAME");
+    SqlConnPool* pool = SqlConnPool::Instance();
+    pool->Init("localhost", 3306, user ? user : "root", pwd ? pwd : "", db ? db : "test", 2);
+    //连接在后台建立，连不上数据库时下面只检查超时
+    bool ready = pool->WaitReady(5000);
+    assert(ready == pool->IsReady());
+    std::vector<MYSQL*> held;
+    while(MYSQL* sql = pool->GetConn(0)) { held.push_back(sql); }
+
+    //没有空闲连接时等到期限返回nullptr
+    auto start = std::chrono::steady_clock::now();
+    assert(!pool->GetConn(50));
+    assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(50));
+    SqlConnPool::Stats stats = pool->GetStats();
+    assert(stats.timeouts == 2 && stats.waiting == 0);
+    assert(stats.free == 0 && stats.inUse == (int)held.size());
+
+    //归还的连接直接交给排队的线程
+    if(!held.empty()) {
+        MYSQL* got = nullptr;
+        std::thread waiter([pool, &got] { got = pool->GetConn(5000); });
+        while(pool->GetStats().waiting == 0) { std::this_thread::yield(); }
+        pool->FreeConn(held.back());
+        waiter.join();
+        assert(got == held.back());
+    }
+    for(MYSQL* sql : held) { pool->FreeConn(sql); }
+    assert(pool->GetStats().free == (int)held.size());
+
+    //没有配置副本时读写都走主库
+    int select = SqlConnPool::RegisterStmt(" select username FROM user WHERE username=?");
+    int insert = SqlConnPool::RegisterStmt("INSERT INTO user(username, password) VALUES(?,?)");
+    assert(SqlConnPool::IsReadStmt(select) && !SqlConnPool::IsReadStmt(insert));
+    SqlRouter::Instance()->MarkWritten("alice");
+    assert(SqlRouter::Instance()->Route(select, "bob") == pool);
+    assert(SqlRouter::Instance()->Route(insert) == pool);
+    pool->ClosePool();
+    assert(!pool->IsReady());
+
+    //只预热一条，其余的等取连接排队时再连
+    if(ready) {
+        SqlConnPool lazy;
+        lazy.Init("localhost", 3306, user ? user : "root", pwd ? pwd : "", db ? db : "test", 3, 1);
+        assert(lazy.WaitReady(5000));
+        MYSQL* first = lazy.GetConn();
+        MYSQL* second = lazy.GetConn(5000);
+        assert(first && second && first != second);
+        assert(lazy.GetStats().unopened == 1);
+        lazy.FreeConn(first);
+        lazy.FreeConn(second);
+        lazy.ClosePool();
+    }
+}
+
+void TestCredentialCache() {
+    BloomFilter names(1000);
+    for(int i = 0; i < 1000; i++) { names.Add("user" + std::to_string(i)); }
+    int falsePositives = 0;
+    for(int i = 0; i < 1000; i++) {
+        assert(names.MayContain("user" + std::to_string(i)));
+        falsePositives += names.MayContain("other" + std::to_string(i));
+    }
+    assert(falsePositives < 50);
+
+    //16个分片，每片容量1
+    CredentialCache cache(16, 50);
+    cache.Put("alice", "pw");
+    assert(cache.Check("alice", "pw") == CredentialCache::MATCH);
+    assert(cache.Check("alice", "pw2") == CredentialCache::MISMATCH);
+    assert(cache.Check("bob", "pw") == CredentialCache::MISS);
+    cache.Put("alice", "pw2");
+    assert(cache.Check("alice", "pw2") == CredentialCache::MATCH && cache.Size() == 1);
+    for(int i = 0; i < 100; i++) { cache.Put("user" + std::to_string(i), "pw"); }
+    assert(cache.Size() <= 16);
+    cache.Put("carol", "pw");
+    cache.Erase("carol");
+    assert(!cache.Contains("carol"));
+    cache.Put("dave", "pw");
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    assert(cache.Check("dave", "pw") == CredentialCache::MISS);
+}
+
+void TestSessionStore() {
+    SessionStore* store = SessionStore::Instance();
+    std::string token = store->Create("alice");
+    assert(token.size() == 32 && token != store->Create("alice"));
+    std::string user;
+    assert(store->Touch(token, &user) && user == "alice");
+    assert(!store->Touch(token.substr(1) + "0"));
+    assert(!store->Touch(""));
+    assert(store->Sweep() == 0);
+    store->Remove(token);
+    assert(!store->Touch(token));
+
+    //反复登录时会话数有上限，新建的会话总是可用
+    size_t limit = SessionStore::SHARDS * SessionStore::SHARD_CAPACITY;
+    for(size_t i = 0; i < limit + 1000; i++) {
+        token = store->Create("bob");
+        assert(store->Touch(token));
+    }
+    assert(store->Size() <= limit);
+}
+
+void TestTimingWheel() {
+    TimingWheel wheel(1);
+    std::vector<int> fired;
+    auto record = [](void* owner, void* arg) {
+        static_cast<std::vector<int>*>(owner)->push_back((int)(intptr_t)arg);
+    };
+    //跨过第0层一圈的节点要经过下放；取消和改期都不触发旧的到期
+    TimerEntry a, b, c, d;
+    wheel.add(&a, 5, record, &fired, (void*)1);
+    wheel.add(&b, 150, record, &fired, (void*)2);
+    wheel.add(&c, 20, record, &fired, (void*)3);
+    wheel.add(&d, 10, record, &fired, (void*)4);
+    wheel.cancel(&c);
+    wheel.adjust(&d, 80);
+    assert(wheel.size() == 3 && !c.Pending());
+    auto start = std::chrono::steady_clock::now();
+    while(wheel.size() > 0) {
+        int ms = wheel.GetNextTick();
+        assert(ms >= -1 && ms <= 150);
+        if(ms > 0) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+    }
+    int elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    assert((fired == std::vector<int>{1, 4, 2}) && elapsed >= 140);
+    assert(wheel.GetNextTick() == -1 && !a.Pending());
+}
+
+CoTask<size_t> ReadAll(CoConn& conn, char* buf, size_t len) {
+    size_t got = 0;
+    while(got < len) {
+        ssize_t n = co_await conn.read(buf + got, len - got);
+        if(n <= 0) { break; }
+        got += n;
+    }
+    co_return got;
+}
+
+void TestLocalUserStore() {
+    const char* path = "./testusers.log";
+    unlink(path);
+    std::vector<std::string> names;
+    {
+        LocalUserStore store(path);
+        assert(store.Open());
+        bool inserted = false;
+        store.Insert("alice", "pw", [&inserted](bool ok) { inserted = ok; });
+        assert(inserted);
+        store.Insert("alice", "other", [&inserted](bool ok) { inserted = ok; });
+        assert(!inserted);
+        assert(store.Check("alice", "pw") == UserStore::MATCH);
+        assert(store.Check("alice", "other") == UserStore::MISMATCH);
+        assert(store.Check("bob", "pw") == UserStore::NO_USER);
+        //超过初始映射大小，删掉大部分后压缩；后台线程也可能已经压缩过
+        for(int i = 0; i < 20000; i++) { store.Insert("user" + std::to_string(i), "pw", nullptr); }
+        assert(store.GetStats().logBytes > LocalUserStore::INITIAL_SIZE);
+        for(int i = 0; i < 19000; i++) { assert(store.Remove("user" + std::to_string(i))); }
+        assert(!store.Remove("user0"));
+        assert(store.Compact());
+        UserStore::Stats stats = store.GetStats();
+        assert(stats.compactions >= 1 && stats.logBytes < LocalUserStore::INITIAL_SIZE / 10);
+        //只算写入的新用户，重复的和删除都不算
+        assert(stats.writtenRows == 20001 && stats.writeBatches == stats.writtenRows);
+        assert(store.Check("user19999", "pw") == UserStore::MATCH);
+        assert(store.Check("user0", "pw") == UserStore::NO_USER);
+    }
+    //重新打开时从日志重建索引
+    LocalUserStore store(path);
+    assert(store.Open());
+    assert(store.LoadNames(names) && names.size() == 1001);
+    assert(store.Check("alice", "pw") == UserStore::MATCH);
+    assert(store.Check("user19000", "pw") == UserStore::MATCH);
+    assert(store.Check("user18999", "pw") == UserStore::NO_USER);
+    unlink(path);
+}
+
+//还没建过滤器时要求读用户名；注册的用户名超出过滤器的设计容量后要求重建，重建后容量按现有用户数重新计算
+void TestUserNames() {
+    const char* path = "./testnames.log";
+    unlink(path);
+    UserService* users = UserService::Instance();
+    std::unique_ptr<LocalUserStore> store(new LocalUserStore(path));
+    assert(store->Open());
+    users->SetStore(std::move(store));
+    assert(users->NeedsNames());
+    assert(users->LoadNames() && !users->NeedsNames());
+    //空库按1024个用户、4倍余量定大小
+    int cnt = 1024 * 4;
+    for(int i = 0; i < cnt; i++) { assert(users->Verify("name" + std::to_string(i), "pw", false)); }
+    assert(!users->NeedsNames());
+    assert(users->Verify("name" + std::to_string(cnt), "pw", false));
+    assert(users->NeedsNames());
+    assert(users->LoadNames() && !users->NeedsNames());
+    //旧名字仍被过滤器认出，重复注册被拒绝
+    assert(!users->Verify("name0", "pw", false) && users->Verify("name0", "pw", true));
+    uint64_t skips = users->GetStats().bloomSkips;
+    assert(!users->Verify("nobody", "pw", true) && users->GetStats().bloomSkips == skips + 1);
+    unlink(path);
+}
+
+void TestCoroutine() {
+    Epoller epoller;
+    CoReactor* reactor = CoReactor::Instance();
+    reactor->Init(&epoller);
+    int fds[2];
+    assert(pipe2(fds, O_NONBLOCK) == 0);
+    CoConn in(fds[0]), out(fds[1]);
+    //超过管道容量，读写两端都要挂起等对方
+    std::string data(200000, 'c'), recv(data.size(), 0);
+    bool wrote = false, read = false;
+    Arena arena;
+    {
+        CoFrameScope scope(&arena);
+        [](CoConn& out, const std::string& data, bool& wrote) -> CoTask<> {
+            co_await CoReactor::Instance()->SleepFor(10);
+            assert(co_await out.write(data.data(), data.size()) == (ssize_t)data.size());
+            wrote = true;
+        }(out, data, wrote).Detach(nullptr);
+        [](CoConn& in, std::string& recv, bool& read) -> CoTask<> {
+            assert(co_await ReadAll(in, &recv[0], recv.size()) == recv.size());
+            read = true;
+        }(in, recv, read).Detach(nullptr);
+    }
+    assert(arena.Capacity() > 0);
+    for(int round = 0; !(wrote && read) && round < 1000; round++) {
+        int timeMS = reactor->GetNextTick();
+        int n = epoller.Wait(timeMS < 0 ? 100 : timeMS);
+        for(int i = 0; i < n; i++) {
+            assert(reactor->OnEvent(epoller.GetEventFd(i), epoller.GetEvents(i)));
+        }
+    }
+    assert(wrote && read && recv == data);
+    in.Close();
+    out.Close();
+    reactor->Close();
+}
+
+void TestRouter() {
+    Router router;
+    auto nop = [](HttpRequest&, HttpResponse&) {};
+    router.Add("GET", "/api/metrics", nop);
+    router.Add("GET", "/api/users/:name", nop);
+    router.Add("GET", "/api/users/:name/posts/:id", nop);
+    router.Add("GET", "/api/users/me", nop);
+    router.Add("GET", "/static/*file", nop);
+
+    RouteParams params;
+    assert(router.Match("GET", "/api/metrics", params));
+    assert(router.Match("GET", "/api/users/me", params) && params.size() == 0);
+    assert(router.Match("GET", "/api/users/bob/posts/7", params));
+    assert(params.Get("name") == "bob" && params.Get("id") == "7");
+    assert(router.Match("GET", "/static/css/style.css", params) && params.Get("file") == "css/style.css");
+    assert(!router.Match("GET", "/index.html", params));
+    assert(!router.Match("POST", "/api/metrics", params));
+}
+
+void TestChainBuffer() {
+    ChainBuffer buff;
+    std::string body(10000, 'x');
+    buff.Append(body);
+    buff.Prepend("HTTP/1.1 200 OK\r\n\r\n");
+    assert(buff.ReadableBytes() == body.size() + 19);
+
+    struct iovec iov[8];
+    int cnt = buff.ReadableIov(iov, 8);
+    assert(cnt >= 3);
+    assert(std::string((char*)iov[0].iov_base, iov[0].iov_len) == "HTTP/1.1 200 OK\r\n\r\n");
+
+    buff.Retrieve(19 + 5000);
+    assert(buff.RetrieveAllToStr() == std::string(5000, 'x'));
+    assert(buff.ReadableBytes() == 0);
+}
+
+void TestHttpHeader() {
+    Buffer buff;
+    std::string req = "GET /index HTTP/1.1\r\n"
+                      "Host: example.com\r\n"
+                      "connection:  Keep-Alive \r\n"
+                      "Cookie: theme=dark; sid=0123abcd;lang=zh\r\n";
+    //超过内联槽位数的非常用头部
+    for(int i = 0; i < 10; i++) {
+        req += "X-Field-" + std::to_string(i) + ": v" + std::to_string(i) + "\r\n";
+    }
+    req += "\r\n";
+    buff.Append(req);
+
+    HttpRequest request;
+    assert(request.parse(buff) && request.IsFinish());
+    assert(request.path() == "/index.html");
+    //常用头部按槽位取，也能按名字（忽略大小写）取
+    assert(request.GetHeader(HttpHeader::HOST) == "example.com");
+    assert(request.GetHeader(HttpHeader::CONNECTION) == "Keep-Alive");
+    assert(request.GetHeader("HOST") == "example.com");
+    assert(request.GetHeader(HttpHeader::CONTENT_TYPE).empty());
+    assert(request.IsKeepAlive());
+    //其余头部按名字查找
+    assert(request.GetHeader("x-field-0") == "v0");
+    assert(request.GetHeader("X-FIELD-9") == "v9");
+    assert(request.GetHeader("X-Field-10").empty());
+
+    assert(request.GetCookie("theme") == "dark");
+    assert(request.GetCookie("sid") == "0123abcd");
+    assert(request.GetCookie("lang") == "zh");
+    assert(request.GetCookie("si").empty());
+    assert(request.GetCookie("missing").empty());
+
+    //Init之后头部清空
+    request.Init();
+    assert(request.GetHeader(HttpHeader::HOST).empty() && request.GetCookie("sid").empty());
+}
+
+//把报文按step字节一段段追加到缓冲区，每段之后解析一次，模拟分多次读到
+bool FeedRequest(HttpRequest& request, Buffer& buff, const std::string& msg, size_t step) {
+    for(size_t pos = 0; pos < msg.size(); pos += step) {
+        buff.Append(msg.substr(pos, step));
+        if(!request.parse(buff)) { return false; }
+    }
+    return true;
+}
+
+void TestHttpParser() {
+    //Content-Length请求体，逐字节到达；头部在请求体收完之后仍然可用
+    for(size_t step : { 1, 7, 64 }) {
+        HttpRequest request;
+        Buffer buff;
+        std::string form = "username=abc&password=a%2Bb";
+        assert(FeedRequest(request, buff, "POST /login HTTP/1.1\r\nConnection: keep-alive\r\n"
+               "Content-Type: application/x-www-form-urlencoded\r\nContent-Length: " + std::to_string(form.size()) +
+               "\r\n\r\n" + form, step));
+        assert(request.IsFinish() && request.IsKeepAlive());
+        assert(request.GetPost("username") == "abc");
+        assert(request.GetHeader(HttpHeader::CONTENT_TYPE) == "application/x-www-form-urlencoded");
+        assert(buff.ReadableBytes() == 0);
+    }
+
+    //分块编码：长度行、分块扩展、数据和尾部字段都可能被切开
+    for(size_t step : { 1, 3, 1000 }) {
+        HttpRequest request;
+        Buffer buff;
+        std::string body;
+        request.SetBodyHandler([&](const char* data, size_t len) { body.append(data, len); return true; });
+        std::string alpha = "abcdefghijklmnopqrstuvwxyz";
+        assert(FeedRequest(request, buff, "POST /echo HTTP/1.1\r\nTransfer-Encoding: chunked\r\n"
+               "Content-Type: text/plain\r\n\r\n5;name=v\r\nhello\r\n1A\r\n" + alpha + "\r\n"
+               "0\r\nX-Trailer: t\r\n\r\nGET /next HTTP/1.1\r\n", step));
+        assert(request.IsFinish());
+        assert(body == "hello" + alpha);
+        //后面流水线的请求留在缓冲区
+        assert(std::string(buff.Peek(), buff.ReadableBytes()) == "GET /next HTTP/1.1\r\n");
+    }
+
+    //Expect: 100-continue 在头部收完、请求体开始之前有效
+    {
+        HttpRequest request;
+        Buffer buff;
+        assert(FeedRequest(request, buff, "PUT /data HTTP/1.1\r\nExpect: 100-Continue\r\nContent-Length: 5\r\n\r\n", 4));
+        assert(request.InBody() && request.ExpectContinue());
+        assert(FeedRequest(request, buff, "he", 2));
+        assert(!request.ExpectContinue() && !request.IsFinish());
+        assert(FeedRequest(request, buff, "llo", 2));
+        assert(request.IsFinish());
+
+        //HTTP/1.0客户端不会等100 Continue
+        HttpRequest old;
+        Buffer oldBuff;
+        assert(FeedRequest(old, oldBuff, "PUT /data HTTP/1.0\r\nExpect: 100-continue\r\nContent-Length: 5\r\n\r\n", 16));
+        assert(old.InBody() && !old.ExpectContinue());
+    }
+
+    //出错的请求给出状态码，并且不再保持连接
+    struct Case { std::string msg; int code; };
+    std::vector<Case> cases = {
+        { "POST /a HTTP/1.1\r\nConnection: keep-alive\r\nContent-Length: " +
+          std::to_string(HttpRequest::MAX_BODY_SIZE + 1) + "\r\n\r\n", 413 },
+        { "POST /a HTTP/1.1\r\nConnection: keep-alive\r\nTransfer-Encoding: chunked\r\n\r\n"
+          "10\r\n0123456789abcdef\r\nFFFFFFFF\r\n", 413 },
+        { "POST /a HTTP/1.1\r\nConnection: keep-alive\r\nContent-Type: application/x-www-form-urlencoded\r\n"
+          "Content-Length: " + std::to_string(HttpRequest::MAX_FORM_SIZE + 1) + "\r\n\r\n" +
+          std::string(HttpRequest::MAX_FORM_SIZE + 1, 'x'), 413 },
+        { "POST /a HTTP/1.1\r\nConnection: keep-alive\r\nExpect: 200-ok\r\nContent-Length: 5\r\n\r\n", 417 },
+        { "GET /a HTTP/1.1\r\nConnection: keep-alive\r\nX-Big: " + std::string(HttpRequest::MAX_HEADER_SIZE, 'x'), 431 },
+        { "GET /a HTTP/1.1\r\nConnection: keep-alive\r\nX-Big: " + std::string(HttpRequest::MAX_HEADER_SIZE, 'x') + "\r\n\r\n", 431 },
+        { "POST /a HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n", 400 },
+        { "POST /a HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n", 400 },
+        //请求体的边界有歧义，可能是请求走私
+        { "POST /a HTTP/1.1\r\nConnection: keep-alive\r\nTransfer-Encoding: chunked\r\nContent-Length: 5\r\n\r\n"
+          "5\r\nhello\r\n0\r\n\r\n", 400 },
+        { "POST /a HTTP/1.1\r\nConnection: keep-alive\r\nContent-Length: 5\r\nTransfer-Encoding: chunked\r\n\r\n", 400 },
+        { "POST /a HTTP/1.1\r\nConnection: keep-alive\r\nContent-Length: 5\r\ncontent-length: 50\r\n\r\nhello", 400 },
+    };
+    for(const Case& c : cases) {
+        HttpRequest request;
+        Buffer buff;
+        assert(!FeedRequest(request, buff, c.msg, 512));
+        assert(request.ErrorCode() == c.code);
+        assert(request.IsFinish() && !request.IsKeepAlive());
+    }
+
+    //重复的Content-Length值相同时照常处理
+    {
+        HttpRequest request;
+        Buffer buff;
+        assert(FeedRequest(request, buff, "POST /a HTTP/1.1\r\nConnection: keep-alive\r\nContent-Length: 5\r\n"
+               "Content-Length: 5\r\n\r\nhello", 7));
+        assert(request.IsFinish() && request.IsKeepAlive() && buff.ReadableBytes() == 0);
+    }
+}
+
+void TestMultipart() {
+    assert(MultipartParser::GetBoundary("multipart/form-data; boundary=XyZ") == "XyZ");
+    assert(MultipartParser::GetBoundary("multipart/form-data; boundary=\"a b\"") == "a b");
+    assert(MultipartParser::GetBoundary("text/plain").empty());
+
+    //文件内容里混入和分隔符前缀相同的字节，验证跨越两次喂入的分隔符能被识别，没形成分隔符的字节原样交出
+    std::string content = "line1\r\n--Xy\r\n-\r\n--XyY" + std::string(100, 'd') + "\r\n--X";
+    std::string body = "preamble\r\n--XyZ\r\n"
+                       "Content-Disposition: form-data; name=\"title\"\r\n\r\n"
+                       "hi there\r\n--XyZ\r\n"
+                       "Content-Disposition: form-data; name=\"file\"; filename=\"a.txt\"\r\n"
+                       "Content-Type: text/plain\r\n\r\n" + content + "\r\n--XyZ--\r\nepilogue";
+    for(size_t step : { size_t(1), size_t(2), size_t(3), size_t(5), size_t(7), size_t(13), body.size() }) {
+        MultipartParser parser;
+        std::vector<std::string> begins, ends;
+        std::map<std::string, std::string> values;
+        std::string fileType;
+        parser.SetCallBack(
+            [&](const MultipartParser::Part& part) {
+                begins.push_back(part.name);
+                if(part.IsFile()) { fileType = part.contentType; }
+                return true;
+            },
+            [&](const MultipartParser::Part& part, const char* data, size_t len) {
+                values[part.name].append(data, len);
+                return true;
+            },
+            [&](const MultipartParser::Part& part) { ends.push_back(part.name); return true; });
+        parser.Init("XyZ");
+        for(size_t pos = 0; pos < body.size(); pos += step) {
+            assert(parser.Feed(body.data() + pos, std::min(step, body.size() - pos)));
+        }
+        assert(parser.IsFinish() && !parser.IsError());
+        assert((begins == std::vector<std::string>{ "title", "file" }) && begins == ends);
+        assert(values["title"] == "hi there");
+        assert(values["file"] == content);
+        assert(fileType == "text/plain");
+    }
+
+    //有遗留字节时，后续大块数据的主体直接在调用方的内存上交出，不经carry_拷贝
+    {
+        MultipartParser parser;
+        std::string file;
+        size_t direct = 0;
+        std::string head = "--XyZ\r\nContent-Disposition: form-data; name=\"f\"; filename=\"b\"\r\n\r\nabc";
+        std::string big = std::string(8192, 'e') + "\r\n--XyZ--\r\n";
+        parser.SetCallBack(nullptr, [&](const MultipartParser::Part&, const char* data, size_t len) {
+            if(data >= big.data() && data < big.data() + big.size()) { direct += len; }
+            file.append(data, len);
+            return true;
+        }, nullptr);
+        parser.Init("XyZ");
+        assert(parser.Feed(head.data(), head.size()) && parser.Feed(big.data(), big.size()));
+        assert(parser.IsFinish() && file == "abc" + std::string(8192, 'e'));
+        assert(direct + std::string("\r\n--XyZ").size() >= 8192);
+    }
+
+    //经由HttpRequest：普通字段进入表单，文件交给上传回调
+    {
+        HttpRequest request;
+        Buffer buff;
+        std::string upload;
+        request.SetUploadHandler([&](const MultipartParser::Part& part, const char* data, size_t len) {
+            assert(part.filename == "a.txt");
+            upload.append(data, len);
+            return true;
+        });
+        assert(FeedRequest(request, buff, "POST /upload HTTP/1.1\r\nContent-Type: multipart/form-data; boundary=XyZ\r\n"
+               "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body, 11));
+        assert(request.IsFinish());
+        assert(request.GetPost("title") == "hi there");
+        assert(upload == content);
+    }
+
+    //没有结束分隔符就收完了请求体
+    {
+        HttpRequest request;
+        Buffer buff;
+        std::string cut = body.substr(0, body.find("\r\n--XyZ--"));
+        assert(!FeedRequest(request, buff, "POST /upload HTTP/1.1\r\nContent-Type: multipart/form-data; boundary=XyZ\r\n"
+               "Content-Length: " + std::to_string(cut.size()) + "\r\n\r\n" + cut, 64));
+        assert(request.ErrorCode() == 400);
+    }
+}
+
+//处理函数挂起等待时由测试手动恢复
+struct ParkAwaiter {
+    std::coroutine_handle<>* parked;
+    bool await_ready() const { return false; }
+    void await_suspend(std::coroutine_handle<> handle) { *parked = handle; }
+    void await_resume() const {}
+};
+
+//协程处理函数挂起期间连接被关闭：帧在连接的内存区里，关闭要等处理完成
+void TestHttpConnHandle() {
+    Router router;
+    std::coroutine_handle<> parked;
+    router.AddCo("GET", "/slow", [&parked](HttpRequest&, HttpResponse& resp) -> CoTask<> {
+        co_await ParkAwaiter{ &parked };
+        resp.SetContent("done", "Content-type: text/plain\r\n");
+    });
+    HttpConn::router = &router;
+    HttpConn::srcDir = "/tmp";
+    const std::string req = "GET /slow HTTP/1.1\r\nConnection: keep-alive\r\n\r\n";
+    struct sockaddr_in addr = {};
+    HttpConn conn;
+    int err = 0;
+
+    for(bool closeEarly : { true, false }) {
+        int fds[2];
+        assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        conn.init(fds[0], addr);
+        assert(write(fds[1], req.data(), req.size()) == (ssize_t)req.size());
+        assert(conn.read(&err) > 0);
+        assert(conn.process() == HttpConn::PROCESS_DEFER);
+        bool done = false;
+        conn.HandleAsync([&done] { done = true; });
+        assert(parked && !done);
+        if(closeEarly) {
+            //只做标记，fd还开着，请求和内存区还在给挂起的协程用
+            conn.Close();
+            assert(conn.ClosePending() && conn.CloseOnComplete());
+            assert(fcntl(fds[0], F_GETFD) != -1 && conn.Phase() == HttpConn::PHASE_HANDLE);
+        }
+        std::exchange(parked, nullptr).resume();
+        assert(done);
+        if(closeEarly) {
+            //处理完成后不再发送，由调用方关闭
+            assert(!conn.Finish() && !conn.ClosePending());
+            assert(fcntl(fds[0], F_GETFD) != -1);
+            conn.Close();
+            assert(fcntl(fds[0], F_GETFD) == -1 && conn.Phase() == HttpConn::PHASE_CLOSED);
+            char ch;
+            assert(read(fds[1], &ch, 1) == 0);
+        } else {
+            assert(!conn.ClosePending() && conn.Finish() && !conn.CloseOnComplete());
+            assert(conn.write(&err) > 0 && conn.ToWriteBytes() == 0);
+            char resp[256];
+            ssize_t len = read(fds[1], resp, sizeof(resp));
+            assert(len > 0 && std::string(resp, len).find("HTTP/1.1 200 OK") == 0);
+            assert(std::string(resp, len).find("\r\n\r\ndone") != std::string::npos);
+            conn.Close();
+        }
+        close(fds[1]);
+    }
+    HttpConn::router = nullptr;
+}
+
+//一个请求依次经过各阶段，每个阶段的截止时刻按对应的超时计算
+void TestHttpConnDeadline() {
+    Router router;
+    std::coroutine_handle<> parked;
+    router.AddCo("POST", "/slow", [&parked](HttpRequest&, HttpResponse& resp) -> CoTask<> {
+        co_await ParkAwaiter{ &parked };
+        resp.SetContent("done", "Content-type: text/plain\r\n");
+    });
+    HttpConn::router = &router;
+    HttpConn::srcDir = "/tmp";
+    const HttpConn::Timeouts limits = { 100, 50, 1000, 300, 200, 400 };
+    struct sockaddr_in addr = {};
+    HttpConn conn;
+    int err = 0;
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    auto send = [&](const std::string& data) {
+        assert(write(fds[1], data.data(), data.size()) == (ssize_t)data.size());
+        assert(conn.read(&err) == (ssize_t)data.size());
+        return conn.process();
+    };
+
+    conn.init(fds[0], addr);
+    int64_t start = conn.PhaseStart();
+    assert(conn.Phase() == HttpConn::PHASE_HEADER && conn.Deadline(limits) == start + 100);
+    //头部没收完，仍从建立连接起计时
+    assert(send("POST /slow HTTP/1.1\r\nConnection: keep-alive\r\nContent-Le") == HttpConn::PROCESS_WAIT);
+    assert(conn.Phase() == HttpConn::PHASE_HEADER && conn.Deadline(limits) == start + 100);
+    //进入请求体后每收到1000字节多给1秒
+    assert(send("ngth: 2010\r\n\r\n" + std::string(10, 'a')) == HttpConn::PROCESS_WAIT);
+    assert(conn.Phase() == HttpConn::PHASE_BODY && conn.Deadline(limits) == conn.PhaseStart() + 50);
+    assert(send(std::string(1000, 'b')) == HttpConn::PROCESS_WAIT);
+    assert(conn.Deadline(limits) == conn.PhaseStart() + 50 + 1000);
+    assert(send(std::string(1000, 'c')) == HttpConn::PROCESS_DEFER);
+    assert(conn.Phase() == HttpConn::PHASE_HANDLE && conn.Deadline(limits) == conn.PhaseStart() + 300);
+    bool done = false;
+    conn.HandleAsync([&done] { done = true; });
+    std::exchange(parked, nullptr).resume();
+    assert(done && conn.Finish());
+    assert(conn.Phase() == HttpConn::PHASE_WRITE && conn.Deadline(limits) == conn.LastWrite() + 200);
+    assert(conn.write(&err) > 0 && conn.ToWriteBytes() == 0);
+    assert(conn.Deadline(limits) == conn.LastWrite() + 200);
+    //长连接发完后等待下一个请求
+    assert(conn.process() == HttpConn::PROCESS_WAIT);
+    assert(conn.Phase() == HttpConn::PHASE_IDLE && conn.Deadline(limits) == conn.PhaseStart() + 400);
+    conn.BeginRequest();
+    assert(conn.Phase() == HttpConn::PHASE_HEADER && conn.Deadline(limits) == conn.PhaseStart() + 100);
+    conn.Close();
+    close(fds[1]);
+    HttpConn::router = nullptr;
+}
+
+//写入换成内存中的假实现，名字以bad开头的行写入失败
+void TestRegisterBatcher() {
+    std::mutex mtx;
+    std::vector<size_t> sizes;
+    RegisterBatcher batcher([&](const std::vector<RegisterBatcher::Row>& rows, std::vector<bool>& results) {
+        {
+            std::lock_guard<std::mutex> locker(mtx);
+            sizes.push_back(rows.size());
+        }
+        for(size_t i = 0; i < rows.size(); i++) {
+            results[i] = rows[i].name.compare(0, 3, "bad") != 0;
+        }
+    });
+
+    //只有一条时等满窗口再提交
+    std::promise<bool> single;
+    auto start = std::chrono::steady_clock::now();
+    batcher.Add("solo", "pw", [&single](bool ok) { single.set_value(ok); });
+    assert(single.get_future().get());
+    assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(RegisterBatcher::BATCH_WINDOW_MS));
+
+    //凑满BATCH_MAX立即提交，多出的几条等下一个窗口；结果按行回给各自的回调
+    const size_t cnt = RegisterBatcher::BATCH_MAX + 3;
+    std::vector<int> results(cnt, -1);
+    std::atomic<size_t> done(0);
+    for(size_t i = 0; i < cnt; i++) {
+        std::string name = (i % 10 == 0 ? "bad" : "user") + std::to_string(i);
+        batcher.Add(name, "pw", [&results, &done, i](bool ok) {
+            results[i] = ok;
+            done++;
+        });
+    }
+    while(done < cnt) { std::this_thread::sleep_for(std::chrono::milliseconds(1)); }
+    for(size_t i = 0; i < cnt; i++) {
+        assert(results[i] == (i % 10 != 0));
+    }
+    std::lock_guard<std::mutex> locker(mtx);
+    assert((sizes == std::vector<size_t>{ 1, RegisterBatcher::BATCH_MAX, 3 }));
+    assert(batcher.Batches() == 3 && batcher.Rows() == cnt + 1);
+}
+
 int main() {
+    TestRouter();
+    TestChainBuffer();
+    TestHttpHeader();
+    TestHttpParser();
+    TestMultipart();
+    TestHttpConnHandle();
+    TestHttpConnDeadline();
+    TestCredentialCache();
+    TestSessionStore();
+    TestTimingWheel();
+    TestLocalUserStore();
+    TestUserNames();
+    TestRegisterBatcher();
+    TestCpuAffinity();
+    TestAsyncSql();
+    TestSqlConnPool();
+    TestCoroutine();
+    TestWorkStealingPool();
     TestLog();
     TestThreadPool();
 }
\ No newline at end of file